@@ -0,0 +1,58 @@
+# Generates a C++ header with the CondDB particle table as constexpr array
+# sorted by MC ID. Run in script mode:
+#
+#   cmake -DINPUT=CondDB_particle_table.txt -DOUTPUT=ParticleTableData.h -P GenerateParticleTableData.cmake
+#
+# String fields are stored without blanks, as the CondDBTranslator returns them.
+
+file(STRINGS ${INPUT} table_lines)
+
+set(rows "")
+foreach(line IN LISTS table_lines)
+  if(line MATCHES "^\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|")
+    foreach(i 1 2 3 4 5 6 7 8 9)
+      string(REPLACE " " "" field "${CMAKE_MATCH_${i}}")
+      set(field_${i} "${field}")
+    endforeach()
+    if(field_9 STREQUAL "self-cc")
+      set(field_9 "${field_1}")
+    endif()
+
+    # zero padded sort key, so that sorting the strings sorts by MC ID
+    if(field_2 MATCHES "^-")
+      string(SUBSTRING "${field_2}" 1 -1 abs_id)
+      math(EXPR key_value "2147483647 - ${abs_id}")
+      set(key_prefix "0")
+    else()
+      set(key_value "${field_2}")
+      set(key_prefix "1")
+    endif()
+    string(LENGTH "${key_value}" key_length)
+    while(key_length LESS 10)
+      set(key_value "0${key_value}")
+      string(LENGTH "${key_value}" key_length)
+    endwhile()
+
+    list(APPEND rows "${key_prefix}${key_value}  {${field_2}, \"${field_1}\", \"${field_3}\", \"${field_4}\", \"${field_5}\", \"${field_6}\", \"${field_7}\", ${field_8}, \"${field_9}\"},")
+  endif()
+endforeach()
+list(SORT rows)
+list(LENGTH rows num_rows)
+
+set(content "// generated by cmake/GenerateParticleTableData.cmake from CondDB_particle_table.txt, do not edit\n")
+set(content "${content}#ifndef DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTableData_H\n")
+set(content "${content}#define DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTableData_H\n\n")
+set(content "${content}// from STL\n#include <cstddef>\n\n")
+set(content "${content}namespace dooselection {\nnamespace mctools {\nnamespace mcdecaymatrixreader {\nnamespace particletabledata {\n\n")
+set(content "${content}struct Row {\n  int mc_id;\n  const char* name;\n  const char* charge;\n  const char* mass;\n  const char* ctaugamma;\n  const char* maxwidth;\n  const char* evtgenname;\n  int pythia_id;\n  const char* antiparticlename;\n};\n\n")
+set(content "${content}constexpr std::size_t kNumRows = ${num_rows};\n\n")
+set(content "${content}constexpr Row kRows[kNumRows] = {\n")
+foreach(row IN LISTS rows)
+  string(SUBSTRING "${row}" 13 -1 row)
+  set(content "${content}  ${row}\n")
+endforeach()
+set(content "${content}};\n\n")
+set(content "${content}} //namespace particletabledata\n} //namespace mcdecaymatrixreader\n} //namespace mctools\n} //namespace dooselection\n\n")
+set(content "${content}#endif // DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTableData_H\n")
+
+file(WRITE ${OUTPUT} "${content}")
@@ -0,0 +1,245 @@
+/******************************************/
+// IDLookupBenchmark.cpp
+//
+// Compares the MC ID to name translation of the
+// former IDTranslator if-chain and the former
+// particle map with the lookup in the compile-time
+// tables (IDTranslator and ParticleTable, as used
+// by CondDBTranslator) on a realistic ID
+// distribution of decay matrices.
+/******************************************/
+
+// from STL
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// from ROOT
+#include "Rtypes.h"
+
+// from DooSelection
+#include "dooselection/mctools/idtranslator/IDTranslator.h"
+#include "dooselection/mctools/mcdecaymatrixreader/ParticleTable.h"
+
+using namespace std;
+
+namespace {
+/// Copy of IDTranslator::convertMCID before the compile-time lookup table
+string LegacyConvertMCID(Float_t ID, bool real_names, bool only_abs){
+  if (only_abs){
+    ID = abs(ID);
+  }
+  if (!real_names){
+    stringstream tmp;
+    tmp << ID;
+    string boing = tmp.str();
+    return boing.c_str();
+  }
+  if      (ID ==     1) return "d";
+  else if (ID ==    -1) return "d bar";
+  else if (ID ==     2) return "u";
+  else if (ID ==    -2) return "u bar";
+  else if (ID ==     3) return "s";
+  else if (ID ==    -3) return "s bar";
+  else if (ID ==     4) return "c";
+  else if (ID ==    -4) return "c bar";
+  else if (ID ==     5) return "b";
+  else if (ID ==    -5) return "b bar";
+  else if (ID ==    11) return "electron";
+  else if (ID ==   -11) return "anti-electron";
+  else if (ID ==    12) return "e neutrino";
+  else if (ID ==   -12) return "anti-e neutrino";
+  else if (ID ==    13) return "muon";
+  else if (ID ==   -13) return "anti-muon";
+  else if (ID ==    14) return "muon neutrino";
+  else if (ID ==   -14) return "anti-muon neutrino";
+  else if (ID ==    15) return "tau";
+  else if (ID ==   -15) return "anti-tau";
+  else if (ID ==    16) return "tau neutrino";
+  else if (ID ==   -16) return "anti-tau neutrino";
+  else if (ID ==    21) return "gluon";
+  else if (ID ==    22) return "gamma";
+  else if (ID ==   111) return "pi0";
+  else if (ID ==   115) return "a2 0";
+  else if (ID ==  -115) return "a2 0 bar";
+  else if (ID ==   211) return "pi+";
+  else if (ID ==  -211) return "pi-";
+  else if (ID ==   215) return "a2+";
+  else if (ID ==  -215) return "a2-";
+  else if (ID ==   221) return "eta";
+  else if (ID ==   223) return "omega";
+  else if (ID ==   225) return "f2";
+  else if (ID ==   311) return "K0";
+  else if (ID ==   315) return "K2* 0";
+  else if (ID ==  -315) return "K2* 0 bar";
+  else if (ID ==  -311) return "K0 bar";
+  else if (ID ==   321) return "K+";
+  else if (ID ==  -321) return "K-";
+  else if (ID ==   113) return "rho0";
+  else if (ID ==   213) return "rho+";
+  else if (ID ==  -213) return "rho-";
+  else if (ID ==   130) return "K0 long";
+  else if (ID ==   310) return "K0 short";
+  else if (ID ==   313) return "K*0";
+  else if (ID ==  -313) return "K*0 bar";
+  else if (ID ==   323) return "K*+";
+  else if (ID ==  -323) return "K*-";
+  else if (ID ==   331) return "eta'(958)";
+  else if (ID ==   433) return "Ds*+";
+  else if (ID ==  -433) return "Ds*-";
+  else if (ID ==   443) return "J/Psi";
+  else if (ID ==   411) return "D+";
+  else if (ID ==  -411) return "D-";
+  else if (ID ==   415) return "D2*(2460)+";
+  else if (ID ==  -415) return "D2*(2460)-";
+  else if (ID ==   421) return "D0";
+  else if (ID ==  -421) return "D0 bar";
+  else if (ID ==   431) return "Ds+";
+  else if (ID ==  -431) return "Ds-";
+  else if (ID ==   423) return "D*0";
+  else if (ID ==  -423) return "D*0 bar";
+  else if (ID ==   413) return "D*(2010)+";
+  else if (ID ==  -413) return "D*(2010)-";
+  else if (ID ==   425) return "D2*0";
+  else if (ID ==  -425) return "D2*0 bar";
+  else if (ID ==   445) return "chi c2(1P)";
+  else if (ID ==   511) return "B0";
+  else if (ID ==  -511) return "B0 bar";
+  else if (ID ==   521) return "B+";
+  else if (ID ==  -521) return "B-";
+  else if (ID ==   531) return "Bs 0";
+  else if (ID ==  -531) return "Bs 0 bar";
+  else if (ID ==   513) return "B* 0";
+  else if (ID ==  -513) return "B* 0 bar";
+  else if (ID ==  2101) return "(ud)0";
+  else if (ID ==  2203) return "(uu)1";
+  else if (ID ==  2112) return "neutron";
+  else if (ID == -2112) return "anti-neutron";
+  else if (ID ==  2212) return "proton";
+  else if (ID == -2212) return "anti-proton";
+  else if (ID ==  2224) return "delta++";
+  else if (ID == -2224) return "delta--";
+  else if (ID ==  2214) return "delta+";
+  else if (ID ==  2114) return "delta0";
+  else if (ID == -2114) return "delta0 bar";
+  else if (ID ==  3122) return "lambda";
+  else if (ID == -3122) return "lambda bar";
+  else if (ID ==  3212) return "sigma 0";
+  else if (ID ==  4112) return "sigma c 0";
+  else if (ID ==  4132) return "Xi c0";
+  else if (ID ==  5122) return "Lambda_b";
+  else if (ID == -5122) return "Lambda_b bar";
+  else if (ID == -4132) return "Xi c0 bar";
+  else if (ID == 10413) return "D1(2420)+";
+  else if (ID ==-10413) return "D1(2420)-";
+  else if (ID == 20213) return "a1(1260)+";
+  else if (ID ==-20213) return "a1(1260)-";
+  else if (ID == 20413) return "D1(H)+";
+  else if (ID ==-20413) return "D1(H)-";
+  else if (ID == 20443) return "chi c1(1P)";
+  else if (ID == 9010221) return "f0(980)";
+  else if (ID == 333) return "phi(1020)";
+  else{
+    stringstream tmp;
+    tmp << ID;
+    string boing = tmp.str();
+    return boing.c_str();
+  }
+}
+
+/// MC ID with its relative frequency in the nodes of B decay matrices
+struct WeightedID {
+  int mc_id;
+  double weight;
+};
+
+/// Realistic ID distribution: mostly charged pions and kaons, photons and
+/// leptons, some charm and beauty hadrons and a few IDs without a name
+const WeightedID kIDDistribution[] = {
+  { 211, 17.}, {-211, 17.}, { 321,  7.}, {-321,  7.}, {  22,  9.}, { 111,  6.},
+  {  13,  2.}, { -13,  2.}, {  11,  1.5}, { -11,  1.5}, {  12,  0.5}, { -14, 0.5},
+  { 310,  1.5}, { 130,  0.5}, { 2212, 1.5}, {-2212, 1.5}, { 2112, 0.5}, { 3122, 0.5},
+  { 113,  1.}, { 213,  1.}, {-213,  1.}, { 223,  0.5}, { 221,  0.5}, { 333,  0.5},
+  { 313,  1.}, {-313,  1.}, { 323,  0.5}, {-323,  0.5},
+  { 411,  1.}, {-411,  1.}, { 421,  1.5}, {-421,  1.5}, { 413,  0.5}, {-413, 0.5},
+  { 431,  0.5}, {-431,  0.5}, { 443,  1.}, {4122,  0.2},
+  { 511,  2.}, {-511,  2.}, { 521,  1.}, {-521,  1.}, { 531,  1.}, {-531,  1.},
+  { 513,  0.3}, {5122,  0.2},
+  {  1,   0.2}, {  2,  0.2}, {  21,  0.3}, {   0,  1.}, {100443, 0.1}, {30343, 0.1}
+};
+
+/// Runs translate on all IDs n_repetitions times and returns the time per ID in ns
+template<class Translate>
+double Measure(const vector<int>& ids, int n_repetitions, Translate translate, size_t& checksum){
+  const auto start = chrono::steady_clock::now();
+  for (int repetition = 0; repetition < n_repetitions; ++repetition){
+    for (vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it){
+      checksum += translate(*it).size();
+    }
+  }
+  const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+  return elapsed.count()/(static_cast<double>(ids.size())*n_repetitions);
+}
+} // namespace
+
+int main(int argc, char * argv[]){
+  size_t n_ids = 1000000;
+  int n_repetitions = 5;
+  if (argc > 1) n_ids = atol(argv[1]);
+  if (argc > 2) n_repetitions = atoi(argv[2]);
+
+  vector<double> weights;
+  for (size_t i = 0; i < sizeof(kIDDistribution)/sizeof(kIDDistribution[0]); ++i){
+    weights.push_back(kIDDistribution[i].weight);
+  }
+  mt19937 engine(42);
+  discrete_distribution<size_t> distribution(weights.begin(), weights.end());
+  vector<int> ids(n_ids);
+  for (size_t i = 0; i < n_ids; ++i){
+    ids[i] = kIDDistribution[distribution(engine)].mc_id;
+  }
+
+  // the translations have to agree before their speed is compared
+  for (size_t i = 0; i < sizeof(kIDDistribution)/sizeof(kIDDistribution[0]); ++i){
+    const int id = kIDDistribution[i].mc_id;
+    if (LegacyConvertMCID(id, true, false) != dooselection::mctools::IDTranslator::convertMCID(id, true, false)){
+      cerr << "IDLookupBenchmark: translations of ID " << id << " differ" << endl;
+      return 1;
+    }
+  }
+
+  using dooselection::mctools::mcdecaymatrixreader::ParticleTable;
+  using dooselection::mctools::mcdecaymatrixreader::ParticleTableEntry;
+  // the former CondDBTranslator looked up its particles in a map
+  map<int, const ParticleTableEntry*> particle_map;
+  const vector<ParticleTableEntry>& entries = ParticleTable::Instance().entries();
+  for (vector<ParticleTableEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it){
+    particle_map[it->mc_id] = &(*it);
+  }
+  const string empty_name;
+
+  size_t checksum = 0;
+  const double legacy_chain = Measure(ids, n_repetitions, [](int id){ return LegacyConvertMCID(id, true, false); }, checksum);
+  const double idtranslator = Measure(ids, n_repetitions, [](int id){ return dooselection::mctools::IDTranslator::convertMCID(id, true, false); }, checksum);
+  const double conddb_map = Measure(ids, n_repetitions, [&](int id) -> const string& {
+    map<int, const ParticleTableEntry*>::const_iterator it = particle_map.find(id);
+    return it != particle_map.end() ? it->second->name : empty_name;
+  }, checksum);
+  const double conddb_table = Measure(ids, n_repetitions, [&](int id) -> const string& {
+    const ParticleTableEntry* entry = ParticleTable::Instance().Find(id);
+    return entry != NULL ? entry->name : empty_name;
+  }, checksum);
+
+  cout << "IDLookupBenchmark: " << n_ids << " IDs, " << n_repetitions << " repetitions (checksum " << checksum << ")" << endl;
+  cout << "  IDTranslator if-chain (legacy)        " << legacy_chain << " ns/ID" << endl;
+  cout << "  IDTranslator compile-time table       " << idtranslator << " ns/ID" << endl;
+  cout << "  particle table std::map (legacy)      " << conddb_map << " ns/ID" << endl;
+  cout << "  particle table compile-time lookup    " << conddb_table << " ns/ID" << endl;
+  return 0;
+}
@@ -140,8 +140,20 @@ int main(int argc, char* argv[]){
       return 0;
     }
   }
+  else if (pt.get_child_optional("fold_xml_files")) {
+    // k-fold application, entries are classified with fold_xml_files[fold_leaf % k]
+    std::vector<std::string> fold_xml_files = config.getVoStrings("fold_xml_files");
+    reducer.AddTMVAKFoldMethod(method.Data(), fold_xml_files);
+    summary.Add("Folds", std::to_string(fold_xml_files.size()));
+  }
   else reducer.SetTMVAMethodAndXMLFile(method, xml_file);
 
+  // Batched evaluation settings
+  if (pt.get_child_optional("num_threads")) reducer.set_num_threads(config.getInt("num_threads"));
+  if (pt.get_child_optional("batch_size")) reducer.set_batch_size(config.getInt("batch_size"));
+  if (pt.get_child_optional("native_bdt")) reducer.set_use_native_bdt(config.getBool("native_bdt"));
+  if (pt.get_child_optional("native_bdt_validation")) reducer.set_native_bdt_validation(config.getInt("native_bdt_validation"));
+
   // Register input file
   reducer.set_input_file_path(input_file.string());
   reducer.set_input_tree_path(tree);
@@ -152,6 +164,12 @@ int main(int argc, char* argv[]){
   reducer.set_output_tree_path(output_tree);
   reducer.PrepareFinalTree();
 
+  // Register fold leaf for k-fold application
+  if (pt.get_child_optional("fold_leaf")) {
+    reducer.SetTMVAFoldLeaf(reducer.GetInterimLeafByName(config.getString("fold_leaf")));
+    summary.Add("Fold leaf", config.getString("fold_leaf"));
+  }
+
   // Register input variables
   summary.AddSection("Variables");
 
@@ -43,6 +43,11 @@ int main(int argc, char * argv[]){
   reducer.set_output_file_path(outputfile);
   reducer.set_output_tree_path(outputtree);
 
+  boost::property_tree::ptree pt = config.getPTree();
+  if (pt.get_child_optional("exact_quantiles")) reducer.set_exact_quantiles(config.getBool("exact_quantiles"));
+  if (pt.get_child_optional("sketch_size")) reducer.set_sketch_size(config.getInt("sketch_size"));
+  if (pt.get_child_optional("num_threads")) reducer.set_num_threads(config.getInt("num_threads"));
+
   for(std::vector<std::string>::const_iterator var = variables.begin(); var != variables.end(); var++){
     std::vector<std::string> nbins = config.getVoStrings("variables."+(*var)+".bins");
     double min = config.getDouble("variables."+(*var)+".min");
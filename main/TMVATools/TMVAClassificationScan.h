@@ -0,0 +1,509 @@
+#ifndef DOOSELECTION_TMVATOOLS_TMVACLASSIFICATIONSCAN_H
+#define DOOSELECTION_TMVATOOLS_TMVACLASSIFICATIONSCAN_H
+
+// from STL
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// from POSIX
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// from ROOT
+#include "TFile.h"
+#include "TH1D.h"
+#include "TLeaf.h"
+#include "TRandom3.h"
+#include "TString.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+// from TMVA
+#include "TMVA/Types.h"
+
+// from BOOST
+#include <boost/property_tree/ptree.hpp>
+#include <boost/regex.hpp>
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+#include "doocore/config/EasyConfig.h"
+#include "doocore/config/Summary.h"
+
+/**
+ *  @brief Helpers for hyperparameter scans in TMVAClassification
+ *
+ *  A scan is configured in the section 'scan' of the TMVAClassification
+ *  config file:
+ *
+ *  @code
+ *  scan
+ *  {
+ *    num_cpu 8                  ; number of methods trained concurrently
+ *    train_fraction 0.5         ; fraction of entries used for training
+ *    seed 0                     ; seed for the training/test split
+ *    ks_threshold 0.01          ; KS probability below which a method is flagged as overtrained
+ *    method "TMVA::Types::kBDT/BDTG/!V:BoostType=Grad:nCuts=25"
+ *    grid
+ *    {
+ *      NTrees { "200" "400" "800" }
+ *      MaxDepth { "2" "3" }
+ *    }
+ *  }
+ *  @endcode
+ *
+ *  Each grid point appends its values to the options of the scan method. All
+ *  methods in factory.methods are trained as well. The input is split once
+ *  into a compact dataset with only the needed branches, then every method is
+ *  trained in its own process (TMVA is not thread-safe) with at most num_cpu
+ *  processes at a time. The results are ranked by ROC integral.
+ */
+namespace tmvatools {
+
+/**
+ *  @brief One method to train in a scan
+ */
+struct ScanJob {
+  std::string type;       ///< method type, e.g. TMVA::Types::kBDT
+  std::string name;       ///< method name
+  std::string options;    ///< method options
+  std::string directory;  ///< output directory of this method
+};
+
+/**
+ *  @brief Performance of one trained method
+ */
+struct ScanResult {
+  std::string name;
+  std::string options;
+  bool success;
+  double roc_integral;
+  double ks_signal;
+  double ks_background;
+};
+
+/**
+ *  @brief Function training a job on the training and test trees
+ */
+typedef std::function<void(const ScanJob&, TTree*, TTree*, TTree*, TTree*)> ScanTrainFunction;
+
+/**
+ *  @brief Get TMVA method type from its name
+ *
+ *  @param type type name as in the config file, e.g. TMVA::Types::kBDT
+ *  @param method_type the method type
+ *  @return whether the type is known
+ */
+inline bool GetMethodType(const std::string& type, TMVA::Types::EMVA& method_type) {
+  if (type == "TMVA::Types::kBDT"){method_type = TMVA::Types::kBDT;}
+  else if (type == "TMVA::Types::kFisher"){method_type = TMVA::Types::kFisher;}
+  else if (type == "TMVA::Types::kMLP"){method_type = TMVA::Types::kMLP;}
+  else if (type == "TMVA::Types::kTMlpANN"){method_type = TMVA::Types::kTMlpANN;}
+  else if (type == "TMVA::Types::kCFMlpANN"){method_type = TMVA::Types::kCFMlpANN;}
+  else if (type == "TMVA::Types::kLikelihood"){method_type = TMVA::Types::kLikelihood;}
+  else if (type == "TMVA::Types::kCuts"){method_type = TMVA::Types::kCuts;}
+  else if (type == "TMVA::Types::kPDEFoam"){method_type = TMVA::Types::kPDEFoam;}
+  else if (type == "TMVA::Types::kKNN"){method_type = TMVA::Types::kKNN;}
+  else if (type == "TMVA::Types::kSVM"){method_type = TMVA::Types::kSVM;}
+  else if (type == "TMVA::Types::kRuleFit"){method_type = TMVA::Types::kRuleFit;}
+  else return false;
+  return true;
+}
+
+/**
+ *  @brief Parse a method string "type/name/options"
+ *
+ *  @param method the method string
+ *  @param job job to set type, name and options of
+ *  @return whether the string could be parsed
+ */
+inline bool ParseMethod(const std::string& method, ScanJob& job) {
+  boost::regex expr("(.*)\\s*/{1}\\s*(.*)\\s*/{1}\\s*(.*)");
+  boost::match_results<std::string::const_iterator> what;
+  if (!regex_search(method, what, expr)) return false;
+
+  job.type    = std::string(what[1].first, what[1].second);
+  job.name    = std::string(what[2].first, what[2].second);
+  job.options = std::string(what[3].first, what[3].second);
+  return true;
+}
+
+/**
+ *  @brief Build all jobs of a scan
+ *
+ *  @param config the config file
+ *  @param output_directory directory to put the jobs' output into
+ *  @return all jobs (methods of factory.methods and all grid points)
+ */
+inline std::vector<ScanJob> BuildScanJobs(doocore::config::EasyConfig& config, const std::string& output_directory) {
+  using namespace doocore::io;
+  boost::property_tree::ptree pt = config.getPTree();
+  std::vector<ScanJob> jobs;
+
+  if (pt.get_child_optional("factory.methods")) {
+    std::vector<std::string> methods = config.getVoStrings("factory.methods");
+    for (std::vector<std::string>::const_iterator it = methods.begin(); it != methods.end(); ++it) {
+      ScanJob job;
+      if (ParseMethod(*it, job)) {
+        jobs.push_back(job);
+      } else {
+        serr << "RegEx matching failed for method " << *it << endmsg;
+      }
+    }
+  }
+
+  if (pt.get_child_optional("scan.method")) {
+    ScanJob base;
+    if (!ParseMethod(config.getString("scan.method"), base)) {
+      serr << "RegEx matching failed for scan method " << config.getString("scan.method") << endmsg;
+      throw 1;
+    }
+
+    // cartesian product of all grid parameters
+    std::vector<ScanJob> points(1, base);
+    if (pt.get_child_optional("scan.grid")) {
+      const boost::property_tree::ptree& grid = pt.get_child("scan.grid");
+      for (boost::property_tree::ptree::const_iterator it = grid.begin(); it != grid.end(); ++it) {
+        std::vector<std::string> values = config.getVoStrings("scan.grid."+(*it).first);
+        std::vector<ScanJob> new_points;
+        for (std::vector<ScanJob>::const_iterator it_point = points.begin(); it_point != points.end(); ++it_point) {
+          for (std::vector<std::string>::const_iterator it_value = values.begin(); it_value != values.end(); ++it_value) {
+            ScanJob point(*it_point);
+            point.name    += "_" + (*it).first + (*it_value);
+            point.options += ":" + (*it).first + "=" + (*it_value);
+            new_points.push_back(point);
+          }
+        }
+        points.swap(new_points);
+      }
+    }
+    jobs.insert(jobs.end(), points.begin(), points.end());
+  }
+
+  for (std::vector<ScanJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+    // TMVA uses the method name for branches and file names
+    std::replace((*it).name.begin(), (*it).name.end(), '.', 'p');
+    (*it).directory = output_directory + "/" + (*it).name;
+  }
+  return jobs;
+}
+
+/**
+ *  @brief Split a tree into compact training and test trees
+ *
+ *  Only active branches are copied. Entries failing the cut are dropped.
+ *
+ *  @param tree the input tree
+ *  @param cut cut to apply
+ *  @param name name prefix for the output trees (<name>_train and <name>_test)
+ *  @param train_fraction fraction of entries put into the training tree
+ *  @param seed seed for the random split
+ */
+inline void SplitTree(TTree* tree, const TString& cut, const TString& name, double train_fraction, UInt_t seed) {
+  TTree* train = tree->CloneTree(0);
+  train->SetName(name+"_train");
+  TTree* test = tree->CloneTree(0);
+  test->SetName(name+"_test");
+
+  TTreeFormula* formula = NULL;
+  if (cut != "") {
+    formula = new TTreeFormula("scan_cut", cut, tree);
+  }
+
+  TRandom3 random(seed);
+  const Long64_t num_entries = tree->GetEntries();
+  for (Long64_t i=0; i<num_entries; ++i) {
+    tree->GetEntry(i);
+    if (formula != NULL) {
+      formula->GetNdata();
+      if (formula->EvalInstance() == 0) continue;
+    }
+    if (random.Rndm() < train_fraction) {
+      train->Fill();
+    } else {
+      test->Fill();
+    }
+  }
+  delete formula;
+
+  doocore::io::sinfo << "Split " << tree->GetName() << " into " << train->GetEntries() << " training and " << test->GetEntries() << " test entries." << doocore::io::endmsg;
+  train->Write();
+  test->Write();
+}
+
+/**
+ *  @brief Write the compact dataset for all jobs
+ *
+ *  @param file_name file to write the training and test trees into
+ *  @param sig_tree signal input tree
+ *  @param bkg_tree background input tree (might be the same as sig_tree)
+ *  @param sig_cut cut on signal tree
+ *  @param bkg_cut cut on background tree
+ *  @param branches branches needed for training
+ *  @param train_fraction fraction of entries used for training
+ *  @param seed seed for the random split
+ */
+inline void PrepareScanDataset(const std::string& file_name, TTree* sig_tree, TTree* bkg_tree, const TString& sig_cut, const TString& bkg_cut, const std::vector<std::string>& branches, double train_fraction, UInt_t seed) {
+  std::vector<std::pair<TTree*,TString> > inputs;
+  inputs.push_back(std::make_pair(sig_tree, sig_cut));
+  if (bkg_tree != sig_tree || bkg_cut != sig_cut) {
+    inputs.push_back(std::make_pair(bkg_tree, bkg_cut));
+  }
+
+  TFile file(file_name.c_str(), "RECREATE");
+  for (unsigned int i=0; i<inputs.size(); ++i) {
+    TTree* tree      = inputs[i].first;
+    const TString& cut = inputs[i].second;
+
+    std::vector<std::string> active_branches(branches);
+    if (cut != "") {
+      TTreeFormula form("form_cut", cut, tree);
+      TLeaf* leaf = form.GetLeaf(0);
+      int j = 1;
+      while (leaf != NULL) {
+        active_branches.push_back(leaf->GetName());
+        leaf = form.GetLeaf(j);
+        ++j;
+      }
+    }
+
+    tree->SetBranchStatus("*", false);
+    for (std::vector<std::string>::const_iterator it = active_branches.begin(); it != active_branches.end(); ++it) {
+      if (*it != "") tree->SetBranchStatus(it->c_str(), true);
+    }
+
+    file.cd();
+    SplitTree(tree, cut, i == 0 ? "signal" : "background", train_fraction, seed+i);
+  }
+  file.Close();
+}
+
+/**
+ *  @brief Compute ROC integral and overtraining checks of a trained method
+ *
+ *  @param job the trained job
+ *  @return the result
+ */
+inline ScanResult EvaluateScanJob(const ScanJob& job) {
+  ScanResult result;
+  result.name          = job.name;
+  result.options       = job.options;
+  result.success       = false;
+  result.roc_integral  = 0.0;
+  result.ks_signal     = 0.0;
+  result.ks_background = 0.0;
+
+  TFile file((job.directory+"/tmva_classification.root").c_str());
+  TTree* trees[2];
+  trees[0] = dynamic_cast<TTree*>(file.Get("TrainTree"));
+  trees[1] = dynamic_cast<TTree*>(file.Get("TestTree"));
+  if (trees[0] == NULL) trees[0] = dynamic_cast<TTree*>(file.Get("dataset/TrainTree"));
+  if (trees[1] == NULL) trees[1] = dynamic_cast<TTree*>(file.Get("dataset/TestTree"));
+  if (trees[0] == NULL || trees[1] == NULL) {
+    doocore::io::serr << "Cannot find TrainTree/TestTree for method " << job.name << doocore::io::endmsg;
+    return result;
+  }
+
+  // (classifier, weight) for signal and background in training and test
+  std::vector<std::pair<Float_t,Float_t> > values[2][2];
+  Float_t min = 0.0, max = 0.0;
+  for (int t=0; t<2; ++t) {
+    Int_t class_id;
+    Float_t weight, classifier;
+    trees[t]->SetBranchAddress("classID", &class_id);
+    trees[t]->SetBranchAddress("weight", &weight);
+    trees[t]->SetBranchAddress(job.name.c_str(), &classifier);
+    for (Long64_t i=0; i<trees[t]->GetEntries(); ++i) {
+      trees[t]->GetEntry(i);
+      values[t][class_id == 0 ? 0 : 1].push_back(std::make_pair(classifier, weight));
+      if ((t == 0 && i == 0) || classifier < min) min = classifier;
+      if ((t == 0 && i == 0) || classifier > max) max = classifier;
+    }
+  }
+
+  // ROC integral on the test sample: probability that signal is classified
+  // higher than background (ties count half)
+  std::vector<std::pair<Float_t,Float_t> >& test_sig = values[1][0];
+  std::vector<std::pair<Float_t,Float_t> >& test_bkg = values[1][1];
+  std::sort(test_sig.begin(), test_sig.end());
+  std::sort(test_bkg.begin(), test_bkg.end());
+  double sum_sig = 0.0, sum_bkg = 0.0, area = 0.0, bkg_below = 0.0;
+  for (size_t i=0; i<test_bkg.size(); ++i) sum_bkg += test_bkg[i].second;
+  size_t b = 0;
+  for (size_t s=0; s<test_sig.size(); ++s) {
+    while (b < test_bkg.size() && test_bkg[b].first < test_sig[s].first) {
+      bkg_below += test_bkg[b].second;
+      ++b;
+    }
+    double bkg_equal = 0.0;
+    for (size_t k=b; k < test_bkg.size() && test_bkg[k].first == test_sig[s].first; ++k) {
+      bkg_equal += test_bkg[k].second;
+    }
+    area    += test_sig[s].second*(bkg_below + 0.5*bkg_equal);
+    sum_sig += test_sig[s].second;
+  }
+  if (sum_sig != 0.0 && sum_bkg != 0.0) {
+    result.roc_integral = area/(sum_sig*sum_bkg);
+  }
+
+  // overtraining check: KS test of training vs. test distributions
+  double* ks[2] = {&result.ks_signal, &result.ks_background};
+  for (int c=0; c<2; ++c) {
+    TH1D hist_train("hist_train", "hist_train", 100, min, max+1e-6*(max-min+1.0));
+    TH1D hist_test("hist_test", "hist_test", 100, min, max+1e-6*(max-min+1.0));
+    hist_train.SetDirectory(NULL);
+    hist_test.SetDirectory(NULL);
+    for (size_t i=0; i<values[0][c].size(); ++i) hist_train.Fill(values[0][c][i].first, values[0][c][i].second);
+    for (size_t i=0; i<values[1][c].size(); ++i) hist_test.Fill(values[1][c][i].first, values[1][c][i].second);
+    *ks[c] = hist_train.KolmogorovTest(&hist_test);
+  }
+
+  result.success = true;
+  return result;
+}
+
+/**
+ *  @brief Run a job in the current (child) process and store its result
+ */
+inline int RunScanJob(const ScanJob& job, const std::string& dataset_file_name, const ScanTrainFunction& train) {
+  TFile* dataset = TFile::Open(dataset_file_name.c_str());
+  if (dataset == NULL) return 1;
+
+  TTree* sig_train = dynamic_cast<TTree*>(dataset->Get("signal_train"));
+  TTree* sig_test  = dynamic_cast<TTree*>(dataset->Get("signal_test"));
+  TTree* bkg_train = dynamic_cast<TTree*>(dataset->Get("background_train"));
+  TTree* bkg_test  = dynamic_cast<TTree*>(dataset->Get("background_test"));
+  if (bkg_train == NULL) bkg_train = sig_train;
+  if (bkg_test == NULL)  bkg_test  = sig_test;
+
+  train(job, sig_train, sig_test, bkg_train, bkg_test);
+  dataset->Close();
+
+  ScanResult result = EvaluateScanJob(job);
+  if (!result.success) return 1;
+
+  std::ofstream out((job.directory+"/scan_result.txt").c_str());
+  out << std::setprecision(10) << result.roc_integral << " " << result.ks_signal << " " << result.ks_background << std::endl;
+  return 0;
+}
+
+/**
+ *  @brief Run a complete scan
+ *
+ *  @param config the config file
+ *  @param output_directory output directory of the job
+ *  @param sig_tree signal input tree
+ *  @param bkg_tree background input tree (might be the same as sig_tree)
+ *  @param sig_cut cut on signal tree
+ *  @param bkg_cut cut on background tree
+ *  @param branches branches needed for training (variables and weights)
+ *  @param train function booking and training one job
+ *  @return the ranked results
+ */
+inline std::vector<ScanResult> RunScan(doocore::config::EasyConfig& config, const std::string& output_directory, TTree* sig_tree, TTree* bkg_tree, const TString& sig_cut, const TString& bkg_cut, const std::vector<std::string>& branches, const ScanTrainFunction& train) {
+  using namespace doocore::io;
+  boost::property_tree::ptree pt = config.getPTree();
+
+  unsigned int num_cpu  = pt.get_child_optional("scan.num_cpu") ? config.getInt("scan.num_cpu") : 1;
+  double train_fraction = pt.get_child_optional("scan.train_fraction") ? config.getDouble("scan.train_fraction") : 0.5;
+  UInt_t seed           = pt.get_child_optional("scan.seed") ? config.getInt("scan.seed") : 0;
+  double ks_threshold   = pt.get_child_optional("scan.ks_threshold") ? config.getDouble("scan.ks_threshold") : 0.01;
+  if (num_cpu < 1) num_cpu = 1;
+
+  std::vector<ScanJob> jobs = BuildScanJobs(config, output_directory);
+  sinfo << "Scan: Training " << jobs.size() << " methods using " << num_cpu << " processes." << endmsg;
+
+  // the split is done once and shared by all jobs
+  gSystem->mkdir(output_directory.c_str(), true);
+  const std::string dataset_file_name = output_directory + "/scan_dataset.root";
+  PrepareScanDataset(dataset_file_name, sig_tree, bkg_tree, sig_cut, bkg_cut, branches, train_fraction, seed);
+
+  // worker pool of child processes
+  std::map<pid_t, size_t> running;
+  std::vector<bool> succeeded(jobs.size(), false);
+  size_t next_job = 0;
+  while (next_job < jobs.size() || !running.empty()) {
+    while (next_job < jobs.size() && running.size() < num_cpu) {
+      gSystem->mkdir(jobs[next_job].directory.c_str(), true);
+      std::cout.flush();
+      fflush(stdout);
+
+      pid_t pid = fork();
+      if (pid == 0) {
+        int status = RunScanJob(jobs[next_job], dataset_file_name, train);
+        std::cout.flush();
+        fflush(stdout);
+        _exit(status);
+      } else if (pid < 0) {
+        serr << "Scan: Cannot start process for method " << jobs[next_job].name << endmsg;
+        throw 2;
+      }
+      sinfo << "Scan: Started training of " << jobs[next_job].name << " (" << jobs[next_job].options << ")" << endmsg;
+      running[pid] = next_job++;
+    }
+
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) break;
+    std::map<pid_t, size_t>::iterator it = running.find(pid);
+    if (it == running.end()) continue;
+
+    succeeded[it->second] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!succeeded[it->second]) {
+      serr << "Scan: Training of " << jobs[it->second].name << " failed." << endmsg;
+    }
+    running.erase(it);
+  }
+
+  // collect and rank results
+  std::vector<ScanResult> results;
+  for (size_t j=0; j<jobs.size(); ++j) {
+    ScanResult result;
+    result.name    = jobs[j].name;
+    result.options = jobs[j].options;
+    result.success = false;
+    std::ifstream in((jobs[j].directory+"/scan_result.txt").c_str());
+    if (succeeded[j] && in >> result.roc_integral >> result.ks_signal >> result.ks_background) {
+      result.success = true;
+      results.push_back(result);
+    }
+  }
+  std::sort(results.begin(), results.end(), [](const ScanResult& a, const ScanResult& b) {
+    return a.roc_integral > b.roc_integral;
+  });
+
+  doocore::config::Summary& summary = doocore::config::Summary::GetInstance();
+  summary.AddSection("Scan results");
+  std::ofstream ranking((output_directory+"/scan_ranking.txt").c_str());
+  ranking << "# rank name roc_integral ks_signal ks_background overtrained options" << std::endl;
+  sinfo << "Scan: Ranking by ROC integral (KS probabilities training vs. test):" << endmsg;
+  for (size_t r=0; r<results.size(); ++r) {
+    const bool overtrained = results[r].ks_signal < ks_threshold || results[r].ks_background < ks_threshold;
+
+    std::stringstream line;
+    line << std::setprecision(5) << "ROC " << results[r].roc_integral << ", KS(sig) " << results[r].ks_signal << ", KS(bkg) " << results[r].ks_background << (overtrained ? ", overtrained" : "");
+    sinfo << std::setw(4) << r+1 << " " << results[r].name << ": " << line.str() << endmsg;
+    summary.Add(results[r].name, line.str());
+
+    ranking << r+1 << " " << results[r].name << " " << results[r].roc_integral << " " << results[r].ks_signal << " " << results[r].ks_background << " " << overtrained << " " << results[r].options << std::endl;
+  }
+  if (results.size() < jobs.size()) {
+    swarn << "Scan: " << jobs.size()-results.size() << " of " << jobs.size() << " methods failed." << endmsg;
+  }
+
+  return results;
+}
+
+} // namespace tmvatools
+
+#endif // DOOSELECTION_TMVATOOLS_TMVACLASSIFICATIONSCAN_H
@@ -11,6 +11,7 @@
 // from TMVA
 #include "TMVA/DataLoader.h"
 #include "TMVA/Factory.h"
+#include "TMVA/MethodBase.h"
 #include "TMVA/Tools.h"
 #include "TMVA/Config.h"
 #include "TMVAGui.C"
@@ -26,6 +27,8 @@
 #include "doocore/system/Tools.h"
 
 // from here
+#include "TMVAClassificationScan.h"
+#include "TMVATrainingCache.h"
 
 int main(int argc, char * argv[]){
   if (argc != 2) {
@@ -106,6 +109,34 @@ int main(int argc, char * argv[]){
       summary.Add("Cut on background sample", bkg_cut);
     }
   }
+
+  // compact training cache holding only entries passing the cuts and the
+  // branches needed for training
+  std::string cache_file_name;
+  if (config.getString("general.cache_directory") != "") {
+    tmvatools::TrainingInput training_input;
+    if (config.getBool("general.use_single_input_file")){
+      training_input.files.push_back((std::string)input_path+(std::string)input_file_name);
+      training_input.trees.push_back(input_tree_name.Data());
+    }
+    else {
+      training_input.files.push_back((std::string)input_path+(std::string)input_sig_file_name);
+      training_input.trees.push_back(input_sig_tree_name.Data());
+      training_input.files.push_back((std::string)input_path+(std::string)input_bkg_file_name);
+      training_input.trees.push_back(input_bkg_tree_name.Data());
+    }
+    training_input.sig_cut = sig_cut;
+    training_input.bkg_cut = bkg_cut;
+    training_input.branches = config.getVoStrings("variables.float");
+    std::vector<std::string> integer_variables = config.getVoStrings("variables.integer");
+    training_input.branches.insert(training_input.branches.end(), integer_variables.begin(), integer_variables.end());
+    training_input.branches.push_back(sig_sweight.Data());
+    training_input.branches.push_back(bkg_sweight.Data());
+
+    cache_file_name = tmvatools::TrainingCacheFileName(config.getString("general.cache_directory"), training_input);
+    tmvatools::CreateTrainingCache(cache_file_name, training_input);
+    summary.Add("Training cache", cache_file_name);
+  }
   
   summary.AddSection("Output");
   TString output_path("tmva/"+config.getString("general.output.path"));
@@ -120,6 +151,79 @@ int main(int argc, char * argv[]){
   TString split_options(config.getString("factory.split_options"));
   summary.Add("Split options", split_options);
 
+  //===========================================================================
+  // Scan mode: train all methods and grid points in parallel processes
+  //===========================================================================
+  if (config.getPTree().get_child_optional("scan")) {
+    if (debug_mode) doocore::io::serr << "-debug- " << "scan mode" << doocore::io::endmsg;
+
+    std::vector<std::string> float_variables = config.getVoStrings("variables.float");
+    std::vector<std::string> integer_variables = config.getVoStrings("variables.integer");
+
+    TTree * sig_tree = NULL;
+    TTree * bkg_tree = NULL;
+    if (cache_file_name != "") {
+      // cuts are already applied in the cache
+      tmvatools::OpenTrainingCache(cache_file_name, sig_tree, bkg_tree);
+      sig_cut = "";
+      bkg_cut = "";
+    }
+    else if (config.getBool("general.use_single_input_file")){
+      TFile * file = TFile::Open(input_path+input_file_name);
+      sig_tree = (TTree*)file->Get(input_tree_name);
+      bkg_tree = sig_tree;
+    }
+    else {
+      TFile * sig_file = TFile::Open(input_path+input_sig_file_name);
+      sig_tree = (TTree*)sig_file->Get(input_sig_tree_name);
+      TFile * bkg_file = TFile::Open(input_path+input_bkg_file_name);
+      bkg_tree = (TTree*)bkg_file->Get(input_bkg_tree_name);
+    }
+
+    std::vector<std::string> branches(float_variables);
+    branches.insert(branches.end(), integer_variables.begin(), integer_variables.end());
+    branches.push_back(sig_sweight.Data());
+    branches.push_back(bkg_sweight.Data());
+
+    // books and trains one method, called in a separate process for each job
+    auto train = [&](const tmvatools::ScanJob& job, TTree* sig_train, TTree* sig_test, TTree* bkg_train, TTree* bkg_test) {
+      TFile * job_file = new TFile(TString(job.directory)+"/tmva_classification.root", "RECREATE");
+
+      TMVA::Factory* job_factory = new TMVA::Factory("tmva", job_file, factory_options);
+      TMVA::DataLoader* job_dataloader = new TMVA::DataLoader("dataset");
+      for (std::vector<std::string>::const_iterator it = float_variables.begin(); it != float_variables.end(); ++it) job_dataloader->AddVariable(*it);
+      for (std::vector<std::string>::const_iterator it = integer_variables.begin(); it != integer_variables.end(); ++it) job_dataloader->AddVariable(*it, 'I');
+      job_dataloader->SetWeightExpression(sig_sweight, "Signal");
+      job_dataloader->SetWeightExpression(bkg_sweight, "Background");
+      job_dataloader->AddSignalTree(sig_train, 1.0, TMVA::Types::kTraining);
+      job_dataloader->AddSignalTree(sig_test, 1.0, TMVA::Types::kTesting);
+      job_dataloader->AddBackgroundTree(bkg_train, 1.0, TMVA::Types::kTraining);
+      job_dataloader->AddBackgroundTree(bkg_test, 1.0, TMVA::Types::kTesting);
+      job_dataloader->PrepareTrainingAndTestTree("", "", split_options);
+
+      TMVA::Types::EMVA method_type;
+      tmvatools::GetMethodType(job.type, method_type);
+      // the factory prepends the data loader name to fWeightFileDir, so the
+      // weight file directory of the job is set on the booked method instead
+      TMVA::MethodBase* job_method = job_factory->BookMethod(job_dataloader, method_type, job.name, job.options);
+      if (job_method != NULL) job_method->SetWeightFileDir(TString(job.directory)+"/Weights");
+
+      job_factory->TrainAllMethods();
+      job_factory->TestAllMethods();
+      job_factory->EvaluateAllMethods();
+      job_file->Close();
+    };
+
+    TStopwatch sw;
+    sw.Start();
+    tmvatools::RunScan(config, (std::string)output_path+"/"+(std::string)job_name+"/Scan", sig_tree, bkg_tree, sig_cut, bkg_cut, branches, train);
+    sw.Stop();
+    doocore::io::sinfo << "RUNTIME: " << sw << doocore::io::endmsg;
+
+    summary.Write((std::string)output_path+"/"+(std::string)job_name+"/"+"summary.log");
+    return 0;
+  }
+
   //===========================================================================
   // Create a ROOT output file where TMVA will store ntuples, histograms, etc.
   //===========================================================================
@@ -176,7 +280,16 @@ int main(int argc, char * argv[]){
   TFile * bkg_file = NULL;
   TTree * bkg_tree = NULL;
   
-  if (config.getBool("general.use_single_input_file")){
+  if (cache_file_name != "") {
+    if (debug_mode) doocore::io::serr << "-debug- " << "use training cache" << doocore::io::endmsg;
+    //---------------------------------------------------------------------------
+    // Registration of the preselected signal and background trees of the training cache
+    //---------------------------------------------------------------------------
+    tmvatools::OpenTrainingCache(cache_file_name, sig_tree, bkg_tree);
+    dataloader->AddSignalTree(sig_tree, 1.0);
+    dataloader->AddBackgroundTree(bkg_tree, 1.0);
+  }
+  else if (config.getBool("general.use_single_input_file")){
     if (debug_mode) doocore::io::serr << "-debug- " << "use single input file" << doocore::io::endmsg;
     //---------------------------------------------------------------------------
     // Registration of a single ROOT tree containing the input data for signal and background
@@ -307,18 +420,7 @@ int main(int argc, char * argv[]){
 
       if (debug_mode) doocore::io::serr << "-debug- " << "Using method '" << type << "' with name '" << name << "' and options '" << options << "'." << doocore::io::endmsg;
 
-      if (type == "TMVA::Types::kBDT"){method_type = TMVA::Types::kBDT;}
-      else if (type == "TMVA::Types::kFisher"){method_type = TMVA::Types::kFisher;}
-      else if (type == "TMVA::Types::kMLP"){method_type = TMVA::Types::kMLP;}
-      else if (type == "TMVA::Types::kTMlpANN"){method_type = TMVA::Types::kTMlpANN;}
-      else if (type == "TMVA::Types::kCFMlpANN"){method_type = TMVA::Types::kCFMlpANN;}
-      else if (type == "TMVA::Types::kLikelihood"){method_type = TMVA::Types::kLikelihood;}
-      else if (type == "TMVA::Types::kCuts"){method_type = TMVA::Types::kCuts;}
-      else if (type == "TMVA::Types::kPDEFoam"){method_type = TMVA::Types::kPDEFoam;}
-      else if (type == "TMVA::Types::kKNN"){method_type = TMVA::Types::kKNN;}
-      else if (type == "TMVA::Types::kSVM"){method_type = TMVA::Types::kSVM;}
-      else if (type == "TMVA::Types::kRuleFit"){method_type = TMVA::Types::kRuleFit;}
-      else{doocore::io::serr << "Unknown TMVA method type '" << type << "'! Abort!" << doocore::io::endmsg; return 0;}
+      if (!tmvatools::GetMethodType(type, method_type)) {doocore::io::serr << "Unknown TMVA method type '" << type << "'! Abort!" << doocore::io::endmsg; return 0;}
       
       factory->BookMethod(dataloader, method_type, name, options);
       summary.Add(name, options);
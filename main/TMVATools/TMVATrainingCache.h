@@ -0,0 +1,232 @@
+#ifndef DOOSELECTION_TMVATOOLS_TMVATRAININGCACHE_H
+#define DOOSELECTION_TMVATOOLS_TMVATRAININGCACHE_H
+
+// from STL
+#include <sstream>
+#include <string>
+#include <vector>
+
+// from ROOT
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TString.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooSelection
+#include "dooselection/tools/StableHash.h"
+
+/**
+ *  @brief Compact preselected training input for TMVAClassification
+ *
+ *  The training cache holds only the branches needed for training (input
+ *  variables and sWeights) and only entries passing the cuts, in a tree
+ *  'signal' and, if signal and background come from different trees or
+ *  cuts, a tree 'background'. The cache file name contains a 64 bit FNV-1a
+ *  hash of the input files (path, size and modification time), tree names,
+ *  cuts and branches, so any change of these creates a new cache. The hash
+ *  does not depend on compiler or library version.
+ *
+ *  Enable it by setting general.cache_directory in the config file.
+ */
+namespace tmvatools {
+
+/**
+ *  @brief Description of the training input to cache
+ */
+struct TrainingInput {
+  std::vector<std::string> files;     ///< input file (signal and background) or signal file and background file
+  std::vector<std::string> trees;     ///< tree name per file
+  TString sig_cut;                    ///< cut on signal
+  TString bkg_cut;                    ///< cut on background
+  std::vector<std::string> branches;  ///< branches needed for training
+};
+
+/**
+ *  @brief Get the cache file name for a training input
+ *
+ *  @param cache_directory directory of cache files
+ *  @param input the training input
+ *  @return file name of the cache
+ */
+inline std::string TrainingCacheFileName(const std::string& cache_directory, const TrainingInput& input) {
+  std::stringstream key;
+  key << "v1";
+  for (unsigned int i=0; i<input.files.size(); ++i) {
+    Long_t id = 0, flags = 0, modtime = 0;
+    Long64_t size = 0;
+    gSystem->GetPathInfo(input.files[i].c_str(), &id, &size, &flags, &modtime);
+    key << ";" << input.files[i] << ":" << size << ":" << modtime << ":" << input.trees[i];
+  }
+  key << ";" << input.sig_cut << ";" << input.bkg_cut;
+  for (std::vector<std::string>::const_iterator it = input.branches.begin(); it != input.branches.end(); ++it) {
+    key << ";" << *it;
+  }
+
+  std::stringstream file_name;
+  file_name << cache_directory << "/tmva_training_cache_" << dooselection::tools::StableHashString(key.str()) << ".root";
+  return file_name.str();
+}
+
+/**
+ *  @brief Copy entries passing a cut and all active branches into a new tree
+ *
+ *  The new tree is created in the current directory.
+ *
+ *  @param tree the input tree
+ *  @param cut cut to apply (empty for none)
+ *  @param name name of the new tree
+ *  @return the new tree
+ */
+inline TTree* CopySelectedEntries(TTree* tree, const TString& cut, const TString& name) {
+  TTree* copy = tree->CloneTree(0);
+  copy->SetName(name);
+
+  TTreeFormula* formula = NULL;
+  if (cut != "") {
+    formula = new TTreeFormula("cache_cut", cut, tree);
+  }
+
+  const Long64_t num_entries = tree->GetEntries();
+  for (Long64_t i=0; i<num_entries; ++i) {
+    tree->GetEntry(i);
+    if (formula != NULL) {
+      formula->GetNdata();
+      if (formula->EvalInstance() == 0) continue;
+    }
+    copy->Fill();
+  }
+  delete formula;
+  return copy;
+}
+
+/**
+ *  @brief Append the names of all leaves used in an expression
+ *
+ *  @param tree the tree
+ *  @param expression expression or cut
+ *  @param leaves vector to append the leaf names to
+ */
+inline void AppendFormulaLeaves(TTree* tree, const TString& expression, std::vector<std::string>& leaves) {
+  TTreeFormula form("form_leaves", expression, tree);
+  for (int i=0; i<form.GetNcodes(); ++i) {
+    TLeaf* leaf = form.GetLeaf(i);
+    if (leaf != NULL) leaves.push_back(leaf->GetName());
+  }
+}
+
+/**
+ *  @brief Activate only the given branches and the branches used in a cut
+ *
+ *  Branches can also be expressions (e.g. "log(B0_PT)"), for these the
+ *  branches used in the expression are activated.
+ *
+ *  @param tree the tree
+ *  @param branches branches or expressions to activate
+ *  @param cut cut whose leaves are to be activated
+ */
+inline void ActivateBranches(TTree* tree, const std::vector<std::string>& branches, const TString& cut) {
+  std::vector<std::string> active_branches;
+  for (std::vector<std::string>::const_iterator it = branches.begin(); it != branches.end(); ++it) {
+    if (*it == "") continue;
+    if (tree->GetLeaf(it->c_str()) != NULL) {
+      active_branches.push_back(*it);
+    } else {
+      AppendFormulaLeaves(tree, *it, active_branches);
+    }
+  }
+  if (cut != "") {
+    AppendFormulaLeaves(tree, cut, active_branches);
+  }
+
+  tree->SetBranchStatus("*", false);
+  for (std::vector<std::string>::const_iterator it = active_branches.begin(); it != active_branches.end(); ++it) {
+    tree->SetBranchStatus(it->c_str(), true);
+  }
+}
+
+/**
+ *  @brief Create the training cache unless it exists already
+ *
+ *  @param file_name file name of the cache
+ *  @param input the training input
+ */
+inline void CreateTrainingCache(const std::string& file_name, const TrainingInput& input) {
+  using namespace doocore::io;
+  if (!gSystem->AccessPathName(file_name.c_str())) {
+    sinfo << "Using training cache " << file_name << endmsg;
+    return;
+  }
+  sinfo << "Creating training cache " << file_name << endmsg;
+  gSystem->mkdir(gSystem->DirName(file_name.c_str()), true);
+
+  // write into a temporary file first, so that concurrent or aborted jobs
+  // never see an incomplete cache
+  std::stringstream temp_file_name;
+  temp_file_name << file_name << ".tmp" << gSystem->GetPid();
+
+  TFile cache_file(temp_file_name.str().c_str(), "RECREATE");
+  for (unsigned int i=0; i<input.files.size(); ++i) {
+    TFile* file = TFile::Open(input.files[i].c_str());
+    if (file == NULL || file->IsZombie()) {
+      serr << "Cannot open input file " << input.files[i] << endmsg;
+      throw 1;
+    }
+    TTree* tree = dynamic_cast<TTree*>(file->Get(input.trees[i].c_str()));
+    if (tree == NULL) {
+      serr << "Cannot find tree " << input.trees[i] << " in file " << input.files[i] << endmsg;
+      throw 2;
+    }
+
+    // a single input file holds signal and background with (possibly)
+    // different cuts
+    std::vector<std::pair<TString,TString> > outputs;
+    if (input.files.size() == 1) {
+      outputs.push_back(std::make_pair(TString("signal"), input.sig_cut));
+      if (input.bkg_cut != input.sig_cut) {
+        outputs.push_back(std::make_pair(TString("background"), input.bkg_cut));
+      }
+    } else {
+      outputs.push_back(std::make_pair(TString(i == 0 ? "signal" : "background"), i == 0 ? input.sig_cut : input.bkg_cut));
+    }
+
+    for (std::vector<std::pair<TString,TString> >::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+      ActivateBranches(tree, input.branches, (*it).second);
+      cache_file.cd();
+      TTree* copy = CopySelectedEntries(tree, (*it).second, (*it).first);
+      sinfo << "Cached " << copy->GetEntries() << " of " << tree->GetEntries() << " entries of " << input.trees[i] << " as " << (*it).first << endmsg;
+      copy->Write();
+    }
+    file->Close();
+    delete file;
+  }
+  cache_file.Close();
+
+  gSystem->Rename(temp_file_name.str().c_str(), file_name.c_str());
+}
+
+/**
+ *  @brief Open signal and background trees of the training cache
+ *
+ *  @param file_name file name of the cache
+ *  @param sig_tree signal tree of the cache
+ *  @param bkg_tree background tree of the cache (might be the same as sig_tree)
+ */
+inline void OpenTrainingCache(const std::string& file_name, TTree*& sig_tree, TTree*& bkg_tree) {
+  TFile* file = TFile::Open(file_name.c_str());
+  if (file == NULL || file->IsZombie()) {
+    doocore::io::serr << "Cannot open training cache " << file_name << doocore::io::endmsg;
+    throw 3;
+  }
+  sig_tree = dynamic_cast<TTree*>(file->Get("signal"));
+  bkg_tree = dynamic_cast<TTree*>(file->Get("background"));
+  if (bkg_tree == NULL) bkg_tree = sig_tree;
+}
+
+} // namespace tmvatools
+
+#endif // DOOSELECTION_TMVATOOLS_TMVATRAININGCACHE_H
@@ -0,0 +1,53 @@
+#ifndef DOOSELECTION_MCTOOLS_DECAYSIGNATURE_H
+#define DOOSELECTION_MCTOOLS_DECAYSIGNATURE_H
+
+// from STL
+#include <cstdint>
+
+namespace dooselection {
+namespace mctools {
+
+/**
+ *  @brief Canonical integer signature of a decay
+ *
+ *  A decay signature is a 64 bit hash of the particle IDs of a decay tree in
+ *  depth-first order, with markers for entering and leaving the daughters of
+ *  a particle. Two decays have the same signature if their decay strings are
+ *  equal (up to hash collisions, which are negligible for the few thousand
+ *  different decays of a sample). Signatures are computed directly from the
+ *  decay matrix, so counting decays does not need any strings.
+ */
+typedef std::uint64_t DecaySignature;
+
+namespace decaysignature {
+
+/// Signature of an empty decay, start value for AddToSignature
+const DecaySignature kEmpty = 0xcbf29ce484222325ULL;
+/// Marker for the start of the daughters of a particle
+const std::int64_t kOpenDaughters = 1LL << 40;
+/// Marker for the end of the daughters of a particle
+const std::int64_t kCloseDaughters = (1LL << 40) + 1;
+/// Marker between two particles on the same level
+const std::int64_t kSeparator = (1LL << 40) + 2;
+/// Marker for an opening bracket (only used for the IDTranslator decay strings)
+const std::int64_t kOpenBracket = (1LL << 40) + 3;
+
+/**
+ *  @brief Adds a particle ID or marker to a signature
+ *
+ *  The value is mixed (splitmix64 finalizer) before it is combined FNV-1a
+ *  style, so that small integers spread over all bits.
+ */
+inline void AddToSignature(DecaySignature& signature, std::int64_t value){
+  std::uint64_t mixed = static_cast<std::uint64_t>(value) + 0x9e3779b97f4a7c15ULL;
+  mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+  mixed = mixed ^ (mixed >> 31);
+  signature = (signature ^ mixed) * 0x100000001b3ULL;
+}
+
+} //namespace decaysignature
+} //namespace mctools
+} //namespace dooselection
+
+#endif // DOOSELECTION_MCTOOLS_DECAYSIGNATURE_H
@@ -0,0 +1,46 @@
+#ifndef DOOSELECTION_MCTOOLS_IDLOOKUP_H
+#define DOOSELECTION_MCTOOLS_IDLOOKUP_H
+
+// from STL
+#include <cstddef>
+
+namespace dooselection {
+namespace mctools {
+
+/**
+ *  @brief Lookup in compile-time tables of particles sorted by MC ID
+ *
+ *  A table is a constexpr array of rows, each with an int member mc_id, sorted
+ *  by strictly increasing MC ID. Both functions are constexpr (in C++11 style,
+ *  with a recursion depth logarithmic in the table size), so a table can be
+ *  checked with static_assert(idlookup::IsSorted(...)) and IDs known at compile
+ *  time can be looked up at compile time.
+ */
+namespace idlookup {
+
+/// True if the rows are sorted by strictly increasing MC ID
+template<class Row>
+constexpr bool IsSorted(const Row* rows, std::size_t num_rows){
+  return num_rows < 2 || (IsSorted(rows, num_rows/2) && rows[num_rows/2-1].mc_id < rows[num_rows/2].mc_id && IsSorted(rows+num_rows/2, num_rows-num_rows/2));
+}
+
+/// Last row with an MC ID not larger than mc_id (or the first row), for num_rows > 0
+template<class Row>
+constexpr const Row* FloorRow(const Row* rows, std::size_t num_rows, int mc_id){
+  // the search interval only depends on num_rows, so the comparison selects a
+  // pointer instead of a branch and random IDs do not cause mispredictions
+  return num_rows == 1 ? rows
+       : FloorRow(rows[num_rows/2].mc_id <= mc_id ? rows+num_rows/2 : rows, num_rows-num_rows/2, mc_id);
+}
+
+/// Row with the given MC ID (binary search), nullptr if there is none
+template<class Row>
+constexpr const Row* Find(const Row* rows, std::size_t num_rows, int mc_id){
+  return num_rows == 0 || FloorRow(rows, num_rows, mc_id)->mc_id != mc_id ? nullptr : FloorRow(rows, num_rows, mc_id);
+}
+
+} //namespace idlookup
+} //namespace mctools
+} //namespace dooselection
+
+#endif // DOOSELECTION_MCTOOLS_IDLOOKUP_H
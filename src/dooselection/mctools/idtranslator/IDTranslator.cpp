@@ -1,132 +1,152 @@
 #include "IDTranslator.h"
 
 #include <sstream>
+#include <cstddef>
+#include <cstdint>
+
+#include "dooselection/mctools/IDLookup.h"
 
 using namespace std;
 
 namespace dooselection {
 namespace mctools {
 
+namespace {
+/// Name of a particle
+struct NameRow {
+  int mc_id;
+  const char* name;
+};
+
+/// Names of particles, sorted by MC ID
+constexpr NameRow kNames[] = {
+  {   -20413, "D1(H)-"},
+  {   -20213, "a1(1260)-"},
+  {   -10413, "D1(2420)-"},
+  {    -5122, "Lambda_b bar"},
+  {    -4132, "Xi c0 bar"},
+  {    -3122, "lambda bar"},
+  {    -2224, "delta--"},
+  {    -2212, "anti-proton"},
+  {    -2114, "delta0 bar"},
+  {    -2112, "anti-neutron"},
+  {     -531, "Bs 0 bar"},
+  {     -521, "B-"},
+  {     -513, "B* 0 bar"},
+  {     -511, "B0 bar"},
+  {     -433, "Ds*-"},
+  {     -431, "Ds-"},
+  {     -425, "D2*0 bar"},
+  {     -423, "D*0 bar"},
+  {     -421, "D0 bar"},
+  {     -415, "D2*(2460)-"},
+  {     -413, "D*(2010)-"},
+  {     -411, "D-"},
+  {     -323, "K*-"},
+  {     -321, "K-"},
+  {     -315, "K2* 0 bar"},
+  {     -313, "K*0 bar"},
+  {     -311, "K0 bar"},
+  {     -215, "a2-"},
+  {     -213, "rho-"},
+  {     -211, "pi-"},
+  {     -115, "a2 0 bar"},
+  {      -16, "anti-tau neutrino"},
+  {      -15, "anti-tau"},
+  {      -14, "anti-muon neutrino"},
+  {      -13, "anti-muon"},
+  {      -12, "anti-e neutrino"},
+  {      -11, "anti-electron"},
+  {       -5, "b bar"},
+  {       -4, "c bar"},
+  {       -3, "s bar"},
+  {       -2, "u bar"},
+  {       -1, "d bar"},
+  {        1, "d"},
+  {        2, "u"},
+  {        3, "s"},
+  {        4, "c"},
+  {        5, "b"},
+  {       11, "electron"},
+  {       12, "e neutrino"},
+  {       13, "muon"},
+  {       14, "muon neutrino"},
+  {       15, "tau"},
+  {       16, "tau neutrino"},
+  {       21, "gluon"},
+  {       22, "gamma"},
+  {      111, "pi0"},
+  {      113, "rho0"},
+  {      115, "a2 0"},
+  {      130, "K0 long"},
+  {      211, "pi+"},
+  {      213, "rho+"},
+  {      215, "a2+"},
+  {      221, "eta"},
+  {      223, "omega"},
+  {      225, "f2"},
+  {      310, "K0 short"},
+  {      311, "K0"},
+  {      313, "K*0"},
+  {      315, "K2* 0"},
+  {      321, "K+"},
+  {      323, "K*+"},
+  {      331, "eta'(958)"},
+  {      333, "phi(1020)"},
+  {      411, "D+"},
+  {      413, "D*(2010)+"},
+  {      415, "D2*(2460)+"},
+  {      421, "D0"},
+  {      423, "D*0"},
+  {      425, "D2*0"},
+  {      431, "Ds+"},
+  {      433, "Ds*+"},
+  {      443, "J/Psi"},
+  {      445, "chi c2(1P)"},
+  {      511, "B0"},
+  {      513, "B* 0"},
+  {      521, "B+"},
+  {      531, "Bs 0"},
+  {     2101, "(ud)0"},
+  {     2112, "neutron"},
+  {     2114, "delta0"},
+  {     2203, "(uu)1"},
+  {     2212, "proton"},
+  {     2214, "delta+"},
+  {     2224, "delta++"},
+  {     3122, "lambda"},
+  {     3212, "sigma 0"},
+  {     4112, "sigma c 0"},
+  {     4132, "Xi c0"},
+  {     5122, "Lambda_b"},
+  {    10413, "D1(2420)+"},
+  {    20213, "a1(1260)+"},
+  {    20413, "D1(H)+"},
+  {    20443, "chi c1(1P)"},
+  {  9010221, "f0(980)"},
+};
+constexpr std::size_t kNumNames = sizeof(kNames)/sizeof(kNames[0]);
+static_assert(idlookup::IsSorted(kNames, kNumNames), "particle names are not sorted by MC ID");
+} // namespace
+
 string IDTranslator::convertMCID(Float_t ID, bool real_names, bool only_abs){
   if (only_abs){
     ID = abs(ID);
   }
-  if (!real_names){
-    stringstream tmp;
-    tmp << ID;
-    string boing = tmp.str();
-    return boing.c_str();
+  const bool integral = fabs(ID) < 1e9 && ID == static_cast<int>(ID) && !(ID == 0 && signbit(ID));
+  // names are only known for integral IDs
+  if (real_names && integral){
+    const NameRow* row = idlookup::Find(kNames, kNumNames, static_cast<int>(ID));
+    if (row != nullptr) return row->name;
   }
-  if      (ID ==     1) return "d";
-  else if (ID ==    -1) return "d bar";
-  else if (ID ==     2) return "u";
-  else if (ID ==    -2) return "u bar";
-  else if (ID ==     3) return "s";
-  else if (ID ==    -3) return "s bar";
-  else if (ID ==     4) return "c";
-  else if (ID ==    -4) return "c bar";
-  else if (ID ==     5) return "b";
-  else if (ID ==    -5) return "b bar";
-  else if (ID ==    11) return "electron";
-  else if (ID ==   -11) return "anti-electron";
-  else if (ID ==    12) return "e neutrino";
-  else if (ID ==   -12) return "anti-e neutrino";
-  else if (ID ==    13) return "muon";
-  else if (ID ==   -13) return "anti-muon";
-  else if (ID ==    14) return "muon neutrino";
-  else if (ID ==   -14) return "anti-muon neutrino";
-  else if (ID ==    15) return "tau";
-  else if (ID ==   -15) return "anti-tau";
-  else if (ID ==    16) return "tau neutrino";
-  else if (ID ==   -16) return "anti-tau neutrino";
-  else if (ID ==    21) return "gluon";
-  else if (ID ==    22) return "gamma";
-  else if (ID ==   111) return "pi0";
-  else if (ID ==   115) return "a2 0";
-  else if (ID ==  -115) return "a2 0 bar";
-  else if (ID ==   211) return "pi+";
-  else if (ID ==  -211) return "pi-";
-  else if (ID ==   215) return "a2+";
-  else if (ID ==  -215) return "a2-";
-  else if (ID ==   221) return "eta";
-  else if (ID ==   223) return "omega";
-  else if (ID ==   225) return "f2";
-  else if (ID ==   311) return "K0";
-  else if (ID ==   315) return "K2* 0";
-  else if (ID ==  -315) return "K2* 0 bar";
-  else if (ID ==  -311) return "K0 bar";
-  else if (ID ==   321) return "K+";
-  else if (ID ==  -321) return "K-";
-  else if (ID ==   113) return "rho0";
-  else if (ID ==   213) return "rho+";
-  else if (ID ==  -213) return "rho-";
-  else if (ID ==   130) return "K0 long";
-  else if (ID ==   310) return "K0 short";
-  else if (ID ==   313) return "K*0";
-  else if (ID ==  -313) return "K*0 bar";
-  else if (ID ==   323) return "K*+";
-  else if (ID ==  -323) return "K*-";
-  else if (ID ==   331) return "eta'(958)";
-  else if (ID ==   433) return "Ds*+";
-  else if (ID ==  -433) return "Ds*-";
-  else if (ID ==   443) return "J/Psi";
-  else if (ID ==   411) return "D+";
-  else if (ID ==  -411) return "D-";
-  else if (ID ==   415) return "D2*(2460)+";
-  else if (ID ==  -415) return "D2*(2460)-";
-  else if (ID ==   421) return "D0";
-  else if (ID ==  -421) return "D0 bar";
-  else if (ID ==   431) return "Ds+";
-  else if (ID ==  -431) return "Ds-";
-  else if (ID ==   423) return "D*0";
-  else if (ID ==  -423) return "D*0 bar";
-  else if (ID ==   413) return "D*(2010)+";
-  else if (ID ==  -413) return "D*(2010)-";
-  else if (ID ==   425) return "D2*0";
-  else if (ID ==  -425) return "D2*0 bar";
-  else if (ID ==   445) return "chi c2(1P)";
-  else if (ID ==   511) return "B0";
-  else if (ID ==  -511) return "B0 bar";
-  else if (ID ==   521) return "B+";
-  else if (ID ==  -521) return "B-";
-  else if (ID ==   531) return "Bs 0";
-  else if (ID ==  -531) return "Bs 0 bar";
-  else if (ID ==   513) return "B* 0";
-  else if (ID ==  -513) return "B* 0 bar";
-  else if (ID ==  2101) return "(ud)0";
-  else if (ID ==  2203) return "(uu)1";
-  else if (ID ==  2112) return "neutron";
-  else if (ID == -2112) return "anti-neutron";
-  else if (ID ==  2212) return "proton";
-  else if (ID == -2212) return "anti-proton";
-  else if (ID ==  2224) return "delta++";
-  else if (ID == -2224) return "delta--";
-  else if (ID ==  2214) return "delta+";
-  else if (ID ==  2114) return "delta0";
-  else if (ID == -2114) return "delta0 bar";
-  else if (ID ==  3122) return "lambda";
-  else if (ID == -3122) return "lambda bar";
-  else if (ID ==  3212) return "sigma 0";
-  else if (ID ==  4112) return "sigma c 0";
-  else if (ID ==  4132) return "Xi c0";
-  else if (ID ==  5122) return "Lambda_b";
-  else if (ID == -5122) return "Lambda_b bar";
-  else if (ID == -4132) return "Xi c0 bar";
-  else if (ID == 10413) return "D1(2420)+";
-  else if (ID ==-10413) return "D1(2420)-";
-  else if (ID == 20213) return "a1(1260)+";
-  else if (ID ==-20213) return "a1(1260)-";
-  else if (ID == 20413) return "D1(H)+";
-  else if (ID ==-20413) return "D1(H)-";
-  else if (ID == 20443) return "chi c1(1P)";
-  else if (ID == 9010221) return "f0(980)";
-  else if (ID == 333) return "phi(1020)";
-  else{
-    stringstream tmp;
-    tmp << ID;
-    string boing = tmp.str();
-    return boing.c_str();
+  // below 1e6 the stream prints integral values like integers
+  if (integral && fabs(ID) < 1e6){
+    return to_string(static_cast<int>(ID));
   }
+  stringstream tmp;
+  tmp << ID;
+  string boing = tmp.str();
+  return boing.c_str();
 }
 
 int IDTranslator::checkparticle (Float_t decaymatrixelement){
@@ -162,5 +182,48 @@ string IDTranslator::makedecaystring (Float_t decaymatrix[][25], int rows, int c
   return decaystring;
 }
 
+namespace {
+/// Adds the tokens makedecaystring would append to a signature instead of a string
+void addtodecaysignature (DecaySignature& signature, Float_t decaymatrix[][25], int rows, int columns, int row, int column, bool only_abs){
+  const std::int64_t ID = static_cast<std::int64_t>(only_abs ? fabs(decaymatrix[row][column]) : decaymatrix[row][column]);
+
+  for (int i=row+1; i<rows; i++){
+    for (int j=column+1; j>0; j--){
+      if (IDTranslator::checkparticle(decaymatrix[i][j]) == 1){
+        if (i==1){
+          decaysignature::AddToSignature(signature, ID);
+          decaysignature::AddToSignature(signature, decaysignature::kOpenDaughters);
+          return addtodecaysignature(signature, decaymatrix, rows, columns, i, j, only_abs);
+        }
+        if (j==column+1){
+          decaysignature::AddToSignature(signature, decaysignature::kOpenBracket);
+          decaysignature::AddToSignature(signature, ID);
+          decaysignature::AddToSignature(signature, decaysignature::kOpenDaughters);
+          return addtodecaysignature(signature, decaymatrix, rows, columns, i, j, only_abs);
+        }
+        if (j==column){
+          decaysignature::AddToSignature(signature, ID);
+          decaysignature::AddToSignature(signature, decaysignature::kSeparator);
+          return addtodecaysignature(signature, decaymatrix, rows, columns, i, j, only_abs);
+        }
+        if (j<column)
+          decaysignature::AddToSignature(signature, ID);
+        for (int l=column-j; l>0; l--)   decaysignature::AddToSignature(signature, decaysignature::kCloseDaughters);
+        decaysignature::AddToSignature(signature, decaysignature::kSeparator);
+        return addtodecaysignature(signature, decaymatrix, rows, columns, i, j, only_abs);
+      }
+    }
+  }
+  decaysignature::AddToSignature(signature, ID);
+  for (int j=column-1; j>0; j--)   decaysignature::AddToSignature(signature, decaysignature::kCloseDaughters);
+}
+} // namespace
+
+DecaySignature IDTranslator::makedecaysignature (Float_t decaymatrix[][25], int rows, int columns, bool only_abs){
+  DecaySignature signature = decaysignature::kEmpty;
+  addtodecaysignature(signature, decaymatrix, rows, columns, 0, 0, only_abs);
+  return signature;
+}
+
 } //namespace mctools
 } //namespace dooselection
@@ -6,6 +6,9 @@
 
 #include "TROOT.h"
 
+// from project
+#include "dooselection/mctools/DecaySignature.h"
+
 /**
  * @namespace dooselection::mctools
  * @brief Tools for Monte Carlo (MC)
@@ -29,6 +32,8 @@ namespace IDTranslator{
   std::string convertMCID(Float_t ID, bool real_names, bool only_abs);
   int checkparticle (Float_t decaymatrixelement);
   std::string makedecaystring (Float_t decaymatrix[][25], int rows, int columns, int row, int column, std::string decaystring, bool real_names, bool only_abs);
+  /// Signature of the decay string makedecaystring(decaymatrix, rows, columns, 0, 0, "", true, only_abs) without building it
+  DecaySignature makedecaysignature (Float_t decaymatrix[][25], int rows, int columns, bool only_abs);
 }
 
 } //namespace mctools
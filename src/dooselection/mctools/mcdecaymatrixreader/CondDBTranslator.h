@@ -4,12 +4,12 @@
 #include "TString.h"
 
 // from STL
-#include <map>
 #include <string>
 
 
 // from Project
 #include "Particle.h"
+#include "ParticleTable.h"
 
 
 /**
@@ -53,7 +53,7 @@ public:
   /**
    *  @brief Default constructor for CondDBTranslator
    *
-   *  Reads the particle MC ID table and creates the two maps
+   *  Uses the process-wide particle table, which is only read on the first use (see ParticleTable)
    */
   CondDBTranslator();
   
@@ -130,27 +130,21 @@ public:
    */
   Particle CreateMinimalParticle(int ID);
 
-  
-private:
   /**
-   *  @brief All complete lines from the particle table are saved in this map and can be accessed through their related mc ids  
+   *  @brief Method to look up the table entry of a given MC ID
    *
-   */
-  std::map<int, std::string> table_lines_;
-
-  /**
-   *  @brief Private method to get specific information out of a CondDB Line
+   *  If an ID is not included in the CondDBTable, a warning is printed and NULL is returned.
    *
    */
-  std::string GetInfoFromCondDBLine(std::string CondDBLine, int Startpoint);
+  const ParticleTableEntry* GetCorrespondingEntry(int ID) const;
+
   
+private:
   /**
-   *  @brief Method to translate a given MC ID of a particle into the corresponding line in the CondDB Table, which is returned as a string
-   *
-   *  If an ID is not included in the CondDBTable, than an empty string is returned.
+   *  @brief The shared particle table
    *
    */
-  std::string GetCorrespondingLine(int ID);
+  const ParticleTable& table_;
 
 };
 
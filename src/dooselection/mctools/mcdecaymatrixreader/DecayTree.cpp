@@ -0,0 +1,178 @@
+// from STL
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+// from Project
+#include "DecayTree.h"
+
+
+namespace dooselection {
+namespace mctools {
+namespace mcdecaymatrixreader {
+
+namespace {
+/// Name of particles not included in the particle table
+const std::string kEmptyName;
+} // namespace
+
+
+DecayTree::DecayTree(){
+
+}
+
+void DecayTree::Clear(){
+  mc_id_.clear();
+  parent_.clear();
+  first_daughter_.clear();
+  last_daughter_.clear();
+  next_sibling_.clear();
+  entry_.clear();
+}
+
+int DecayTree::AddNode(int mc_id, const ParticleTableEntry* entry, int parent){
+  const int node = size();
+  mc_id_.push_back(mc_id);
+  parent_.push_back(parent);
+  first_daughter_.push_back(-1);
+  last_daughter_.push_back(-1);
+  next_sibling_.push_back(-1);
+  entry_.push_back(entry);
+
+  if (parent >= 0){
+    if (last_daughter_[parent] < 0){
+      first_daughter_[parent] = node;
+    }
+    else {
+      next_sibling_[last_daughter_[parent]] = node;
+    }
+    last_daughter_[parent] = node;
+  }
+  return node;
+}
+
+const std::string& DecayTree::name(int node) const{
+  return entry_[node] != NULL ? entry_[node]->name : kEmptyName;
+}
+
+const std::string& DecayTree::antiparticlename(int node) const{
+  return entry_[node] != NULL ? entry_[node]->antiparticlename : kEmptyName;
+}
+
+
+void DecayTree::AppendLabel(int node, Label label, std::string& out) const{
+  char buffer[32];
+  switch (label){
+    case kName:
+      out += name(node);
+      break;
+    case kAntiparticleName:
+      out += antiparticlename(node);
+      break;
+    case kMCID:
+      snprintf(buffer, sizeof(buffer), "%d", mc_id_[node]);
+      out += buffer;
+      break;
+    case kAbsMCID:
+      // Particle::GetCompleteAbsMCIDDecay() streams fabs(mc_id), i.e. a double with default precision
+      snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(std::abs(mc_id_[node])));
+      out += buffer;
+      break;
+  }
+}
+
+void DecayTree::AppendDecay(int node, Label label, Label daughter_label, bool complete, std::string& out) const{
+  AppendLabel(node, label, out);
+  int daughter = first_daughter_[node];
+  if (daughter >= 0){
+    out += " (";
+    do {
+      if (complete){
+        AppendDecay(daughter, daughter_label, daughter_label, true, out);
+      }
+      else {
+        AppendLabel(daughter, daughter_label, out);
+      }
+      daughter = next_sibling_[daughter];
+      if (daughter >= 0){
+        out += " ";
+      }
+    } while (daughter >= 0);
+    out += ")";
+  }
+}
+
+
+void DecayTree::AppendDecay(int node, std::string& out) const{
+  AppendDecay(node, kName, kName, false, out);
+}
+
+void DecayTree::AppendCompleteDecay(int node, std::string& out) const{
+  AppendDecay(node, kName, kName, true, out);
+}
+
+void DecayTree::AppendConjugatedDecay(int node, std::string& out) const{
+  AppendDecay(node, kAntiparticleName, kAntiparticleName, false, out);
+}
+
+void DecayTree::AppendConjugatedCompleteDecay(int node, std::string& out) const{
+  AppendDecay(node, kAntiparticleName, kAntiparticleName, true, out);
+}
+
+void DecayTree::AppendConjugatedInitialStateDecay(int node, std::string& out) const{
+  AppendDecay(node, kAntiparticleName, kName, false, out);
+}
+
+void DecayTree::AppendConjugatedInitialStateCompleteDecay(int node, std::string& out) const{
+  AppendDecay(node, kAntiparticleName, kName, true, out);
+}
+
+void DecayTree::AppendConjugatedFinalStateDecay(int node, std::string& out) const{
+  AppendDecay(node, kName, kAntiparticleName, false, out);
+}
+
+void DecayTree::AppendConjugatedFinalStateCompleteDecay(int node, std::string& out) const{
+  AppendDecay(node, kName, kAntiparticleName, true, out);
+}
+
+void DecayTree::AppendCompleteMCIDDecay(int node, std::string& out) const{
+  AppendDecay(node, kMCID, kMCID, true, out);
+}
+
+void DecayTree::AppendCompleteAbsMCIDDecay(int node, std::string& out) const{
+  AppendDecay(node, kAbsMCID, kAbsMCID, true, out);
+}
+
+void DecayTree::AppendCompleteFinalStateAbsMCIDDecay(int node, std::string& out) const{
+  AppendDecay(node, kName, kAbsMCID, true, out);
+}
+
+
+Particle DecayTree::CreateParticle(int node, bool full_properties) const{
+  Particle new_particle;
+  new_particle.set_mc_id(mc_id_[node]);
+
+  const ParticleTableEntry* particle_entry = entry_[node];
+  if (particle_entry != NULL){
+    new_particle.set_name(particle_entry->name);
+    new_particle.set_antiparticlename(particle_entry->antiparticlename);
+    if (full_properties){
+      new_particle.set_charge(particle_entry->charge);
+      new_particle.set_mass(particle_entry->mass);
+      new_particle.set_ctaugamma(particle_entry->ctaugamma);
+      new_particle.set_maxwidth(particle_entry->maxwidth);
+      new_particle.set_evtgenname(particle_entry->evtgenname);
+      new_particle.set_pythiaID(std::to_string(particle_entry->pythia_id));
+    }
+  }
+
+  for (int daughter = first_daughter_[node]; daughter >= 0; daughter = next_sibling_[daughter]){
+    new_particle.AddDaughterParticle(CreateParticle(daughter, full_properties));
+  }
+  return new_particle;
+}
+
+} //namespace mcdecaymatrixreader
+} //namespace mctools
+} //namespace dooselection
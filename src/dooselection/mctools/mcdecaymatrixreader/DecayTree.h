@@ -0,0 +1,143 @@
+#ifndef DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_DecayTree_H
+#define DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_DecayTree_H
+
+// from STL
+#include <vector>
+#include <string>
+
+// from Project
+#include "Particle.h"
+#include "ParticleTable.h"
+
+
+namespace dooselection {
+namespace mctools {
+namespace mcdecaymatrixreader {
+
+
+/** @class DecayTree
+ *  @brief Flat representation of a decay tree read from a decay matrix
+ *
+ *  All particles of a decay are stored as nodes in plain arrays, linked by the
+ *  indices of their parent, first daughter and next sibling. Node 0 is the
+ *  initial state particle. Particle properties are not copied, each node only
+ *  refers to its entry in the shared ParticleTable.
+ *
+ *  The tree is meant to be reused for every event: Clear() keeps the memory of
+ *  the node arrays, so after the first few events filling the tree (see
+ *  MCDecayMatrixReader::readDecayTree()) and appending its decay strings to an
+ *  existing string do not allocate any memory.
+ *
+ *  The decay string methods correspond to the methods of the same name in
+ *  Particle, called on the particle of the given node.
+ */
+class DecayTree {
+
+public:
+  /**
+   *  @brief Constructor creating an empty tree
+   *
+   */
+  DecayTree();
+
+  /**
+   *  @brief Removes all nodes, but keeps the allocated memory
+   *
+   */
+  void Clear();
+
+  /**
+   *  @brief Adds a particle as last daughter of the node parent (-1 for the initial state particle) and returns its node
+   *
+   *  entry is the particle table entry of the particle (NULL if it is not included in the table).
+   */
+  int AddNode(int mc_id, const ParticleTableEntry* entry, int parent);
+
+  /**
+   *  @brief Getter methods for the nodes, -1 is returned if there is no parent, daughter or sibling
+   *
+   */
+  int size() const{return static_cast<int>(mc_id_.size());}
+  int mc_id(int node) const{return mc_id_[node];}
+  int parent(int node) const{return parent_[node];}
+  int first_daughter(int node) const{return first_daughter_[node];}
+  int next_sibling(int node) const{return next_sibling_[node];}
+  const ParticleTableEntry* entry(int node) const{return entry_[node];}
+
+  /**
+   *  @brief Name (or antiparticle name) of a node, empty if the particle is not included in the particle table
+   *
+   */
+  const std::string& name(int node) const;
+  const std::string& antiparticlename(int node) const;
+
+  /**
+   *  @brief Decay strings as in Particle, appended to out
+   *
+   */
+  void AppendDecay(int node, std::string& out) const;
+  void AppendCompleteDecay(int node, std::string& out) const;
+  void AppendConjugatedDecay(int node, std::string& out) const;
+  void AppendConjugatedCompleteDecay(int node, std::string& out) const;
+  void AppendConjugatedInitialStateDecay(int node, std::string& out) const;
+  void AppendConjugatedInitialStateCompleteDecay(int node, std::string& out) const;
+  void AppendConjugatedFinalStateDecay(int node, std::string& out) const;
+  void AppendConjugatedFinalStateCompleteDecay(int node, std::string& out) const;
+  void AppendCompleteMCIDDecay(int node, std::string& out) const;
+  void AppendCompleteAbsMCIDDecay(int node, std::string& out) const;
+  void AppendCompleteFinalStateAbsMCIDDecay(int node, std::string& out) const;
+
+  /**
+   *  @brief Decay strings as in Particle, for convenience returned as new string
+   *
+   */
+  std::string GetDecay(int node=0) const{std::string out; AppendDecay(node, out); return out;}
+  std::string GetCompleteDecay(int node=0) const{std::string out; AppendCompleteDecay(node, out); return out;}
+  std::string GetConjugatedCompleteDecay(int node=0) const{std::string out; AppendConjugatedCompleteDecay(node, out); return out;}
+  std::string GetCompleteAbsMCIDDecay(int node=0) const{std::string out; AppendCompleteAbsMCIDDecay(node, out); return out;}
+
+  /**
+   *  @brief Creates a Particle (including all of its daughter particles) from a node
+   *
+   *  With full_properties all particle properties are set, as in CondDBTranslator::CreateFullPropParticle(),
+   *  otherwise only the names, as in CondDBTranslator::CreateMinimalParticle().
+   */
+  Particle CreateParticle(int node, bool full_properties) const;
+
+private:
+  /**
+   *  @brief How a particle is written in a decay string
+   *
+   */
+  enum Label {kName, kAntiparticleName, kMCID, kAbsMCID};
+
+  /**
+   *  @brief Appends a node and its daughters to out, the daughters (and their daughters if complete) with daughter_label
+   *
+   */
+  void AppendDecay(int node, Label label, Label daughter_label, bool complete, std::string& out) const;
+
+  /**
+   *  @brief Appends the label of a node to out
+   *
+   */
+  void AppendLabel(int node, Label label, std::string& out) const;
+
+  /**
+   *  @brief Node arrays
+   *
+   */
+  std::vector<int> mc_id_;
+  std::vector<int> parent_;
+  std::vector<int> first_daughter_;
+  std::vector<int> last_daughter_;
+  std::vector<int> next_sibling_;
+  std::vector<const ParticleTableEntry*> entry_;
+};
+
+} //namespace mcdecaymatrixreader
+} //namespace mctools
+} //namespace dooselection
+
+
+#endif // DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_DecayTree_H
@@ -1,5 +1,6 @@
 // from STL
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 // from Project
@@ -27,34 +28,65 @@ MCDecayMatrixReader::~MCDecayMatrixReader(){
 
 
 
-Particle MCDecayMatrixReader::createDecayingParticle(Float_t* decaymatrix, int rows, int columns, int row, int column){
-  Particle tempParticle = internal_translator_->CreateFullPropParticle(decaymatrix[row*columns+column]);
+void MCDecayMatrixReader::readDecayTree(const Float_t* decaymatrix, int rows, int columns, DecayTree& tree, int row, int column) const{
+  tree.Clear();
+  addToDecayTree(decaymatrix, rows, columns, row, column, -1, tree);
+}
+
+
+void MCDecayMatrixReader::addToDecayTree(const Float_t* decaymatrix, int rows, int columns, int row, int column, int parent, DecayTree& tree) const{
+  const int ID = decaymatrix[row*columns+column];
+  const int node = tree.AddNode(ID, internal_translator_->GetCorrespondingEntry(ID), parent);
   if (column+1 < columns){
-    for (int i=row+1; checkparticle(decaymatrix[i*columns+column]) !=1 && i<rows; i++){
+    for (int i=row+1; i<rows && checkparticle(decaymatrix[i*columns+column]) !=1; i++){
       if (checkparticle(decaymatrix[i*columns+column+1]) == 1){
-        tempParticle.AddDaughterParticle(createDecayingParticle(decaymatrix, rows, columns, i, column+1));
+        addToDecayTree(decaymatrix, rows, columns, i, column+1, node, tree);
       }
     }
   }
-  return tempParticle;
+}
+
+
+Particle MCDecayMatrixReader::createDecayingParticle(Float_t* decaymatrix, int rows, int columns, int row, int column){
+  readDecayTree(decaymatrix, rows, columns, decay_tree_, row, column);
+  return decay_tree_.CreateParticle(0, true);
 }
 
 
 Particle MCDecayMatrixReader::createMinimalDecayingParticle(Float_t* decaymatrix, int rows, int columns, int row, int column){
-  Particle tempParticle = internal_translator_->CreateMinimalParticle(decaymatrix[row*columns+column]);
+  readDecayTree(decaymatrix, rows, columns, decay_tree_, row, column);
+  return decay_tree_.CreateParticle(0, false);
+}
+
+
+DecaySignature MCDecayMatrixReader::createDecaySignature(const Float_t* decaymatrix, int rows, int columns, bool abs_initial_state, bool abs_final_state) const{
+  DecaySignature signature = decaysignature::kEmpty;
+  addToDecaySignature(signature, decaymatrix, rows, columns, 0, 0, abs_initial_state, abs_final_state);
+  return signature;
+}
+
+
+void MCDecayMatrixReader::addToDecaySignature(DecaySignature& signature, const Float_t* decaymatrix, int rows, int columns, int row, int column, bool abs_id, bool abs_daughters) const{
+  const int ID = decaymatrix[row*columns+column];
+  decaysignature::AddToSignature(signature, abs_id ? std::abs(ID) : ID);
+  bool has_daughters = false;
   if (column+1 < columns){
-    for (int i=row+1; checkparticle(decaymatrix[i*columns+column]) !=1 && i<rows; i++){
+    for (int i=row+1; i<rows && checkparticle(decaymatrix[i*columns+column]) !=1; i++){
       if (checkparticle(decaymatrix[i*columns+column+1]) == 1){
-        tempParticle.AddDaughterParticle(createMinimalDecayingParticle(decaymatrix, rows, columns, i, column+1));
+        decaysignature::AddToSignature(signature, has_daughters ? decaysignature::kSeparator : decaysignature::kOpenDaughters);
+        has_daughters = true;
+        addToDecaySignature(signature, decaymatrix, rows, columns, i, column+1, abs_daughters, abs_daughters);
       }
     }
   }
-  return tempParticle;
+  if (has_daughters){
+    decaysignature::AddToSignature(signature, decaysignature::kCloseDaughters);
+  }
 }
 
 
-int MCDecayMatrixReader::checkparticle (Float_t decaymatrixelement){
-  for(std::vector<int>::iterator it = ignoredparticles_.begin(); it != ignoredparticles_.end(); ++it){
+int MCDecayMatrixReader::checkparticle (Float_t decaymatrixelement) const{
+  for(std::vector<int>::const_iterator it = ignoredparticles_.begin(); it != ignoredparticles_.end(); ++it){
     if (fabs(decaymatrixelement) == *it)
       return -1;
   }
@@ -8,6 +8,8 @@
 // from project
 #include "Particle.h"
 #include "CondDBTranslator.h"
+#include "DecayTree.h"
+#include "dooselection/mctools/DecaySignature.h"
 
 
 
@@ -79,7 +81,7 @@ public:
    *  If certain particles shall be excluded, than they are treated as if they weren't there.
    *
    */
-  int checkparticle (Float_t decaymatrixelement);
+  int checkparticle (Float_t decaymatrixelement) const;
   
   
   /**
@@ -89,10 +91,20 @@ public:
   void set_IDs_of_ignored_particles(std::vector<int> ignored_particle_ids) { ignoredparticles_ = ignored_particle_ids; }
 
   
+  /**
+   *  @brief This method reads the decay in the given array into a flat decay tree, starting with the particle in the given row and column.
+   *
+   *  The tree is cleared first. Reusing the same tree for all events, no memory is allocated once the
+   *  tree has grown to the size of the largest decay. This method does not change the reader.
+   *
+   */
+  void readDecayTree(const Float_t *decaymatrix, int rows, int columns, DecayTree& tree, int row=0, int column=0) const;
+
+  
   /**
    *  @brief This method creates a particle (including all of its daugther particles) from the given array derived from the decay matrix.
    *
-   *  
+   *  The decay is read with readDecayTree(), the particles are created from the decay tree.
    *
    */
   Particle createDecayingParticle(Float_t *decaymatrix, int rows, int columns, int row, int column);
@@ -107,12 +119,30 @@ public:
   Particle createMinimalDecayingParticle(Float_t *decaymatrix, int rows, int columns, int row, int column);
 
   
+  /**
+   *  @brief This method computes the signature of the decay in the given array without creating any particles.
+   *
+   *  The decay tree is traversed as in createMinimalDecayingParticle(decaymatrix, rows, columns, 0, 0).
+   *  If abs_initial_state (abs_final_state) is set, the charge of the initial state particle (of all
+   *  daughter particles) is ignored by using the absolute value of its MC ID. This corresponds to
+   *
+   *  (false, false): Particle::GetCompleteDecay()
+   *  (true, true):   Particle::GetCompleteAbsMCIDDecay()
+   *  (false, true):  Particle::GetCompleteFinalStateAbsMCIDDecay()
+   *  (true, false):  initial state conjugation ignored, final state with charges
+   *
+   *  This method does not change the reader and can be called from several threads at once.
+   *
+   */
+  DecaySignature createDecaySignature(const Float_t *decaymatrix, int rows, int columns, bool abs_initial_state, bool abs_final_state) const;
+
+  
 private:
   
   /**
    *  @brief Internal Instance of the CondDBTranslator, it is only created once to save memory and time
    *
-   *  If the CondDBTranslator object would be created multiple times, it would read out the CondDBparticletable again and again. This would be very ineffective and time consuming.
+   *  The CondDB particle table itself is read only once per process and shared by all translators (see ParticleTable).
    *
    *
    */
@@ -125,6 +155,24 @@ private:
    */
   std::vector<int> ignoredparticles_;
 
+  /**
+   *  @brief Recursive part of createDecaySignature, adds a particle and its daughters to the signature
+   *
+   */
+  void addToDecaySignature(DecaySignature& signature, const Float_t *decaymatrix, int rows, int columns, int row, int column, bool abs_id, bool abs_daughters) const;
+
+  /**
+   *  @brief Recursive part of readDecayTree, adds a particle and its daughters as daughter of the node parent
+   *
+   */
+  void addToDecayTree(const Float_t *decaymatrix, int rows, int columns, int row, int column, int parent, DecayTree& tree) const;
+
+  /**
+   *  @brief Decay tree reused by createDecayingParticle and createMinimalDecayingParticle
+   *
+   */
+  DecayTree decay_tree_;
+
 };
   
 } //namespace mcdecaymatrixreader
@@ -43,7 +43,7 @@ namespace mcdecaymatrixreader {
  *  
  *  If many particles are produced (like in the MCDecayMatrixReader), it is more efficient to 
  *  create one CondDBTranslator instance and create the particles using the  Particle CondDBTranslator::CreateParticle(int ID) method.
- *  The latter is more efficient, because the Cond DB file is loaded only once instead of being loaded again and again for each particle.
+ *  The latter is more efficient, because all properties are taken from one lookup in the shared particle table (see ParticleTable).
  *
  *  Besides providing particle properties this class conatins a vector of the daughter particles,
  *  which can be filled manually. The MCDecayMatrixReader fills this vector automatically 
@@ -0,0 +1,77 @@
+// from STL
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+// from Project
+#include "ParticleTable.h"
+#include "ParticleTableData.h"
+#include "dooselection/mctools/IDLookup.h"
+
+
+namespace dooselection {
+namespace mctools {
+namespace mcdecaymatrixreader {
+
+namespace {
+/// Charge in units of e, fractional charges like -1/3 included
+double ParseCharge(const std::string& charge){
+  std::string::size_type slash = charge.find('/');
+  if (slash == std::string::npos) return atof(charge.c_str());
+  return atof(charge.substr(0, slash).c_str())/atof(charge.substr(slash+1).c_str());
+}
+
+/// Mass in MeV from a value with unit (e.g. "9.9MeV")
+double ParseMass(const std::string& mass){
+  char* unit_begin = NULL;
+  const double value = strtod(mass.c_str(), &unit_begin);
+  const std::string unit(unit_begin);
+  if (unit == "eV") return value*1e-6;
+  else if (unit == "keV") return value*1e-3;
+  else if (unit == "GeV") return value*1e3;
+  else if (unit == "TeV") return value*1e6;
+  else return value;
+}
+} // namespace
+
+
+static_assert(idlookup::IsSorted(particletabledata::kRows, particletabledata::kNumRows), "particle table data is not sorted by MC ID");
+
+
+const ParticleTable& ParticleTable::Instance(){
+  static const ParticleTable table;
+  return table;
+}
+
+
+ParticleTable::ParticleTable(){
+  // the table is compiled in (see cmake/GenerateParticleTableData.cmake), only the numerical values are parsed here
+  entries_.reserve(particletabledata::kNumRows);
+  for (std::size_t i = 0; i < particletabledata::kNumRows; ++i){
+    const particletabledata::Row& row = particletabledata::kRows[i];
+    ParticleTableEntry entry;
+    entry.mc_id = row.mc_id;
+    entry.name = row.name;
+    entry.charge = row.charge;
+    entry.charge_value = ParseCharge(entry.charge);
+    entry.mass = row.mass;
+    entry.mass_value = ParseMass(entry.mass);
+    entry.ctaugamma = row.ctaugamma;
+    entry.maxwidth = row.maxwidth;
+    entry.evtgenname = row.evtgenname;
+    entry.pythia_id = row.pythia_id;
+    entry.antiparticlename = row.antiparticlename;
+    entries_.push_back(entry);
+  }
+}
+
+
+const ParticleTableEntry* ParticleTable::Find(int ID) const{
+  // search the compact compiled-in rows, the entries are in the same order
+  const particletabledata::Row* row = idlookup::Find(particletabledata::kRows, particletabledata::kNumRows, ID);
+  return row != nullptr ? &entries_[row - particletabledata::kRows] : NULL;
+}
+
+} //namespace mcdecaymatrixreader
+} //namespace mctools
+} //namespace dooselection
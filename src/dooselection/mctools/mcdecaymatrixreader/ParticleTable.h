@@ -0,0 +1,90 @@
+#ifndef DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTable_H
+#define DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTable_H
+
+// from STL
+#include <vector>
+#include <string>
+
+// from Project
+
+
+namespace dooselection {
+namespace mctools {
+namespace mcdecaymatrixreader {
+
+
+/** @struct ParticleTableEntry
+ *  @brief One particle of the CondDB particle table with already parsed fields
+ *
+ *  String fields are stored without blanks, exactly as they were returned by the
+ *  CondDBTranslator before (e.g. "9.9MeV"). A self-conjugated particle has its own
+ *  name as antiparticle name.
+ */
+struct ParticleTableEntry {
+  int mc_id;
+  std::string name;
+  std::string charge;
+  double charge_value;           ///< charge in units of e
+  std::string mass;
+  double mass_value;             ///< mass in MeV
+  std::string ctaugamma;
+  std::string maxwidth;
+  std::string evtgenname;
+  int pythia_id;
+  std::string antiparticlename;
+};
+
+
+/** @class ParticleTable
+ *  @brief Process-wide, immutable CondDB particle table
+ *
+ *  The CondDB particle table is compiled into the library as constexpr array sorted by
+ *  MC ID (generated from CondDB_particle_table.txt at build time). The entries are
+ *  created once per process, on the first call of ParticleTable::Instance(), without
+ *  reading any file. All CondDBTranslator instances share this table, so creating a
+ *  translator costs nothing and a lookup is a binary search over the entries.
+ */
+class ParticleTable {
+
+public:
+  /**
+   *  @brief Access to the table, which is created on the first call (thread-safe)
+   *
+   */
+  static const ParticleTable& Instance();
+
+  /**
+   *  @brief Method to look up a particle by its MC ID
+   *
+   *  Returns NULL if the ID is not included in the CondDB table.
+   */
+  const ParticleTableEntry* Find(int ID) const;
+
+  /**
+   *  @brief Getter method for all particles, sorted by MC ID
+   *
+   */
+  const std::vector<ParticleTableEntry>& entries() const{return entries_;}
+
+private:
+  /**
+   *  @brief Private constructor creating the entries from the compiled-in table
+   *
+   */
+  ParticleTable();
+  ParticleTable(const ParticleTable&);
+  ParticleTable& operator=(const ParticleTable&);
+
+  /**
+   *  @brief All particles of the table, sorted by MC ID
+   *
+   */
+  std::vector<ParticleTableEntry> entries_;
+};
+
+} //namespace mcdecaymatrixreader
+} //namespace mctools
+} //namespace dooselection
+
+
+#endif // DOOSELECTION_MCTOOLS_MCDECAYMATRIXREADER_ParticleTable_H
@@ -75,7 +75,7 @@ void ArrayFlattenerReducer::PrepareSpecialBranches() {
     
     sinfo << "The following leaves will be flattened: " << endmsg;
     // loop over all interim leaves and check if array length is name_array_length_
-    // fill leaves_map_double_ and leaves_map_int_ based on leaf_array_length_
+    // fill columns_double_, columns_float_ and columns_int_ based on leaves_array_length_
     for (std::vector<ReducerLeaf<Float_t>* >::const_iterator it = GetInterimLeavesBegin(); it != GetInterimLeavesEnd(); ++it) {
       
       // iterate over all set length leaves and check if interim leaf is matching
@@ -84,15 +84,15 @@ void ArrayFlattenerReducer::PrepareSpecialBranches() {
         if ((*it)->LengthLeafName() == name_array_length) {
           if ((*it)->type() == "Double_t") {
             ReducerLeaf<Double_t>& flat_leaf = CreateDoubleLeaf((*it)->name()+"_flat");
-            leaves_map_double_[&flat_leaf] = *it;
+            columns_double_.push_back(FlatColumn<Double_t>(&flat_leaf, *it));
             sdebug << "  " << (*it)->name() << " -> " << flat_leaf.name() << " (double)" << endmsg;
           } else if ((*it)->type() == "Float_t") {
             ReducerLeaf<Float_t>& flat_leaf = CreateFloatLeaf((*it)->name()+"_flat");
-            leaves_map_float_[&flat_leaf] = *it;
+            columns_float_.push_back(FlatColumn<Float_t>(&flat_leaf, *it));
             sdebug << "  " << (*it)->name() << " -> " << flat_leaf.name() << " (float)" << endmsg;
           } else if ((*it)->type() == "Int_t") {
             ReducerLeaf<Int_t>& flat_leaf = CreateIntLeaf((*it)->name()+"_flat");
-            leaves_map_int_[&flat_leaf] = *it;
+            columns_int_.push_back(FlatColumn<Int_t>(&flat_leaf, *it));
             sdebug << "  " << (*it)->name() << " -> " << flat_leaf.name() << " (int)" << endmsg;
           }
         }
@@ -105,36 +105,54 @@ bool ArrayFlattenerReducer::FlatLeavesPassSpecialCuts() {
   return true;
 }
 
+void ArrayFlattenerReducer::GatherColumns(int num_rows) {
+  for (std::vector<FlatColumn<Double_t> >::iterator it = columns_double_.begin(); it != columns_double_.end(); ++it) {
+    const Double_t* array = static_cast<const Double_t*>(it->array_leaf->branch_address());
+    it->values.assign(array, array+num_rows);
+  }
+  for (std::vector<FlatColumn<Float_t> >::iterator it = columns_float_.begin(); it != columns_float_.end(); ++it) {
+    const Float_t* array = static_cast<const Float_t*>(it->array_leaf->branch_address());
+    it->values.assign(array, array+num_rows);
+  }
+  for (std::vector<FlatColumn<Int_t> >::iterator it = columns_int_.begin(); it != columns_int_.end(); ++it) {
+    const Int_t* array = static_cast<const Int_t*>(it->array_leaf->branch_address());
+    it->values.assign(array, array+num_rows);
+  }
+}
+
+void ArrayFlattenerReducer::SetFlatLeaves(int row) {
+  *leaf_array_index_ = row;
+  for (std::vector<FlatColumn<Double_t> >::iterator it = columns_double_.begin(); it != columns_double_.end(); ++it) {
+    *(it->flat_leaf) = it->values[row];
+  }
+  for (std::vector<FlatColumn<Float_t> >::iterator it = columns_float_.begin(); it != columns_float_.end(); ++it) {
+    *(it->flat_leaf) = it->values[row];
+  }
+  for (std::vector<FlatColumn<Int_t> >::iterator it = columns_int_.begin(); it != columns_int_.end(); ++it) {
+    *(it->flat_leaf) = it->values[row];
+  }
+}
+
 void ArrayFlattenerReducer::FillOutputTree() {
   if (leaves_array_length_.size() == 0) {
     if (FlatLeavesPassSpecialCuts()) {
       FlushEvent();
     }
   } else {
-    int num_pvs = leaf_array_length_->GetValue();
-    for (int i=0; i<num_pvs; ++i) {
-      // sdebug << "i = " << i << endmsg;
-      *leaf_array_index_ = i;
-      for (std::map<ReducerLeaf<Double_t>*, const ReducerLeaf<Float_t>*>::iterator it = leaves_map_double_.begin();
-           it != leaves_map_double_.end(); ++it) {
-        (*it->first) = it->second->GetValue(i);
-        // sdebug << " " << it->first->name() << " = " << it->first->GetValue() << endmsg;
-      }
-      for (std::map<ReducerLeaf<Float_t>*, const ReducerLeaf<Float_t>*>::iterator it = leaves_map_float_.begin();
-           it != leaves_map_float_.end(); ++it) {
-        (*it->first) = it->second->GetValue(i);
-        //sdebug << " " << it->first->name() << " = " << it->first->GetValue() << endmsg;
-      }
-      for (std::map<ReducerLeaf<Int_t>*, const ReducerLeaf<Float_t>*>::iterator it = leaves_map_int_.begin();
-           it != leaves_map_int_.end(); ++it) {
-        (*it->first) = it->second->GetValue(i);
-        //sdebug << " " << it->first->name() << " = " << it->first->GetValue() << endmsg;
-      }
-      
-      if(FlatLeavesPassSpecialCuts()) {
+    const int num_rows = std::max(0, static_cast<int>(leaf_array_length_->GetValue()));
+    GatherColumns(num_rows);
+    
+    // the cut hook sees the flat leaves of one row at a time
+    row_mask_.assign(num_rows, 0);
+    for (int i=0; i<num_rows; ++i) {
+      SetFlatLeaves(i);
+      row_mask_[i] = FlatLeavesPassSpecialCuts();
+    }
+    
+    for (int i=0; i<num_rows; ++i) {
+      if (row_mask_[i]) {
+        SetFlatLeaves(i);
         FlushEvent();
-      } else {
-        //skip this index
       }
     }
   }
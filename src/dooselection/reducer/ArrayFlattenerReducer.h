@@ -2,8 +2,8 @@
 #define DOOSELECTION_REDUCER_ARRAYFLATTENERREDUCER_H
 
 // from STL
-#include <map>
 #include <string>
+#include <vector>
 
 // from ROOT
 
@@ -27,6 +27,11 @@
  *  Leaves to be flattened are determined by array length leaves. All leaves 
  *  having one of these as array length will be flattened.
  *
+ *  Flattening works in bulk per event: all array leaves are first copied into 
+ *  contiguous columns of their own type, then FlatLeavesPassSpecialCuts() is 
+ *  evaluated for every row to get a mask of accepted rows, and finally all 
+ *  accepted rows of the event are written.
+ *
  **/
 namespace dooselection {
 namespace reducer {
@@ -62,6 +67,37 @@ class ArrayFlattenerReducer : virtual public Reducer {
   virtual void FillOutputTree();
   
  private:
+  /**
+   *  @brief Flat leaf with the according array-based leaf and its values of the current event
+   */
+  template <class T>
+  struct FlatColumn {
+    FlatColumn(ReducerLeaf<T>* flat_leaf_, const ReducerLeaf<Float_t>* array_leaf_)
+      : flat_leaf(flat_leaf_), array_leaf(array_leaf_), values() {}
+    
+    ReducerLeaf<T>* flat_leaf;
+    const ReducerLeaf<Float_t>* array_leaf;
+    std::vector<T> values;
+  };
+  
+  /**
+   *  @brief Copy the array-based leaves of the current event into the columns
+   *
+   *  The array-based leaves are of the same type as their flat leaves, so each
+   *  array is copied as a whole without any conversion.
+   *
+   *  @param num_rows number of array entries in the current event
+   */
+  void GatherColumns(int num_rows);
+  
+  /**
+   *  @brief Set the flat leaves (and the index leaf) to one row of the columns
+   *
+   *  @param row array index of the row
+   */
+  void SetFlatLeaves(int row);
+  
+
   /**
    *  @brief Name of index array
    */
@@ -83,19 +119,24 @@ class ArrayFlattenerReducer : virtual public Reducer {
   ReducerLeaf<Int_t>* leaf_array_index_;
   
   /**
-   *  @brief Map containing all created flat float leaves and according array-based leaves
+   *  @brief Columns of all created flat float leaves
+   */
+  std::vector<FlatColumn<Float_t> > columns_float_;
+  
+  /**
+   *  @brief Columns of all created flat double leaves
    */
-  std::map<ReducerLeaf<Float_t>*, const ReducerLeaf<Float_t>*> leaves_map_float_;
+  std::vector<FlatColumn<Double_t> > columns_double_;
   
   /**
-   *  @brief Map containing all created flat double leaves and according array-based leaves
+   *  @brief Columns of all created flat int leaves
    */
-  std::map<ReducerLeaf<Double_t>*, const ReducerLeaf<Float_t>*> leaves_map_double_;
+  std::vector<FlatColumn<Int_t> > columns_int_;
   
   /**
-   *  @brief Map containing all created flat int leaves and according array-based leaves
+   *  @brief Mask of rows of the current event passing FlatLeavesPassSpecialCuts()
    */
-  std::map<ReducerLeaf<Int_t>*, const ReducerLeaf<Float_t>*> leaves_map_int_;
+  std::vector<char> row_mask_;
   
 };
 
@@ -0,0 +1 @@
+#include "ArrayReductionReducerLeaf.h"
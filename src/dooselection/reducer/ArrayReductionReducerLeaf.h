@@ -0,0 +1,371 @@
+#ifndef DOOSELECTION_REDUCER_ARRAYREDUCTIONREDUCERLEAF_H
+#define DOOSELECTION_REDUCER_ARRAYREDUCTIONREDUCERLEAF_H
+
+// from STL
+#include <vector>
+#include <limits>
+
+// from ROOT
+#include "TString.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "dooselection/reducer/ReducerLeaf.h"
+
+// forward decalarations
+
+/**
+ * @class dooselection::reducer::ArrayReductionReducerLeaf
+ *
+ * @brief Reducer leaf reducing an array-based leaf to a single number
+ *
+ * This helper class represents a leaf in a tree. For each entry it reduces an
+ * array-based leaf (e.g. one value per PV) to its minimum, maximum, index of
+ * the minimum or maximum, sum or number of elements above a threshold. Unlike
+ * flattening, the number of entries in the output tree does not change.
+ *
+ * Elements can be excluded from the reduction by a mask expression that is
+ * evaluated for each array element (e.g. "B0_IPCHI2_PV>0") and by a leaf
+ * holding an index to exclude (e.g. the index of the best PV). If no element
+ * is left, min, max, argmin and argmax are set to the default value.
+ *
+ * The array is copied into a contiguous buffer once per entry and the
+ * reductions are done in branch-free loops over this buffer and the mask.
+ */
+
+namespace dooselection {
+namespace reducer {
+
+/**
+ * @brief Reductions supported by ArrayReductionReducerLeaf
+ */
+enum ArrayReduction {
+  kArrayMinimum,
+  kArrayMaximum,
+  kArrayArgMinimum,
+  kArrayArgMaximum,
+  kArraySum,
+  kArrayCountAbove
+};
+
+template <class T>
+class ArrayReductionReducerLeaf : public ReducerLeaf<T> {
+ public:
+  ArrayReductionReducerLeaf(TString name, TString title, TString type, TTree* tree, T default_value=T());
+
+  virtual ~ArrayReductionReducerLeaf() {
+    if (mask_formula_ != NULL) delete mask_formula_;
+    if (excluded_index_leaf_ != NULL) delete excluded_index_leaf_;
+  }
+
+  /** @name Leaf value determination
+   *  These functions assure setting the leaves value correctly.
+   */
+  ///@{
+  /**
+   * @brief Update the leaf value by reducing the array of the current entry.
+   *
+   * @return whether the reduction set the value
+   */
+  virtual bool UpdateValue();
+  ///@}
+
+  /** @name Array reduction operations
+   *  These functions set the reduction to perform
+   */
+  ///@{
+  /**
+   *  @brief Set array-based leaf and reduction
+   *
+   *  @param array_leaf array-based interim leaf to reduce
+   *  @param reduction reduction to perform
+   *  @param threshold threshold for kArrayCountAbove (elements > threshold are counted)
+   */
+  void SetReduction(const ReducerLeaf<Float_t>& array_leaf, ArrayReduction reduction, double threshold=0.0);
+
+  /**
+   *  @brief Only use array elements passing a mask expression
+   *
+   *  The expression is evaluated for each array element as TTreeFormula
+   *  instance on the tree of this leaf.
+   *
+   *  @param mask_expression cut string, e.g. "B0_IPCHI2_PV>0"
+   */
+  void SetMask(const TString& mask_expression);
+
+  /**
+   *  @brief Exclude the array element with the index stored in a leaf
+   *
+   *  @param index_leaf leaf holding the index to exclude (no element is excluded for an index out of range)
+   */
+  template<class T1>
+  void SetExcludedIndex(const ReducerLeaf<T1>& index_leaf);
+  ///@}
+
+ private:
+  /**
+   *  @brief Copy the array of the current entry into values_
+   *
+   *  @param length number of array elements
+   */
+  template<class T1>
+  void GatherValues(int length) {
+    const T1* array = static_cast<const T1*>(array_leaf_->branch_address());
+    values_.assign(array, array+length);
+  }
+
+  /**
+   *  @brief Reduce values_ according to mask_
+   *
+   *  @param value result of the reduction
+   *  @return whether any element passed the mask (always true for sum and count)
+   */
+  bool Reduce(double& value) const;
+
+  /**
+   *  @brief Array-based leaf to reduce
+   */
+  const ReducerLeaf<Float_t>* array_leaf_;
+
+  /**
+   *  @brief Reduction to perform
+   */
+  ArrayReduction reduction_;
+
+  /**
+   *  @brief Threshold for kArrayCountAbove
+   */
+  double threshold_;
+
+  /**
+   *  @brief Formula for the mask expression (NULL if not set)
+   */
+  TTreeFormula* mask_formula_;
+
+  /**
+   *  @brief Leaf holding the index to exclude (NULL if not set)
+   */
+  ReducerLeaf<T>* excluded_index_leaf_;
+
+  /**
+   *  @brief Array values of the current entry
+   */
+  std::vector<double> values_;
+
+  /**
+   *  @brief Mask of array elements to use for the current entry
+   */
+  std::vector<char> mask_;
+};
+
+template <class T>
+ArrayReductionReducerLeaf<T>::ArrayReductionReducerLeaf(TString name, TString title, TString type, TTree* tree, T default_value)
+: ReducerLeaf<T>(name, title, type, tree, default_value),
+  array_leaf_(NULL),
+  reduction_(kArrayMinimum),
+  threshold_(0.0),
+  mask_formula_(NULL),
+  excluded_index_leaf_(NULL),
+  values_(),
+  mask_()
+{
+}
+
+template <class T>
+void ArrayReductionReducerLeaf<T>::SetReduction(const ReducerLeaf<Float_t>& array_leaf, ArrayReduction reduction, double threshold) {
+  array_leaf_ = &array_leaf;
+  reduction_  = reduction;
+  threshold_  = threshold;
+  this->AddDependentLeaf(array_leaf.name());
+
+  switch (reduction) {
+    case kArrayMinimum:
+      std::cout << "Leaf " << this->name() << " = min(" << array_leaf.name() << "[])" << std::endl;
+      break;
+    case kArrayMaximum:
+      std::cout << "Leaf " << this->name() << " = max(" << array_leaf.name() << "[])" << std::endl;
+      break;
+    case kArrayArgMinimum:
+      std::cout << "Leaf " << this->name() << " = argmin(" << array_leaf.name() << "[])" << std::endl;
+      break;
+    case kArrayArgMaximum:
+      std::cout << "Leaf " << this->name() << " = argmax(" << array_leaf.name() << "[])" << std::endl;
+      break;
+    case kArraySum:
+      std::cout << "Leaf " << this->name() << " = sum(" << array_leaf.name() << "[])" << std::endl;
+      break;
+    case kArrayCountAbove:
+      std::cout << "Leaf " << this->name() << " = count(" << array_leaf.name() << "[] > " << threshold << ")" << std::endl;
+      break;
+  }
+}
+
+template <class T>
+void ArrayReductionReducerLeaf<T>::SetMask(const TString& mask_expression) {
+  if (mask_formula_ != NULL) delete mask_formula_;
+  mask_formula_ = new TTreeFormula(this->name()+"_mask", mask_expression, this->tree());
+  for (int i=0; i<mask_formula_->GetNcodes(); ++i) {
+    if (mask_formula_->GetLeaf(i) != NULL) {
+      this->AddDependentLeaf(mask_formula_->GetLeaf(i)->GetName());
+    }
+  }
+  std::cout << "Leaf " << this->name() << " only uses array elements with " << mask_expression << std::endl;
+}
+
+template <class T> template<class T1>
+void ArrayReductionReducerLeaf<T>::SetExcludedIndex(const ReducerLeaf<T1>& index_leaf) {
+  // as in ReducerLeaf<T>::SetOperation(), the index leaf is accessed through a
+  // generic ReducerLeaf<T> which casts according to the type string
+  if (excluded_index_leaf_ != NULL) delete excluded_index_leaf_;
+  excluded_index_leaf_ = new ReducerLeaf<T>(index_leaf.name(), index_leaf.title(), index_leaf.type(), index_leaf.tree());
+  excluded_index_leaf_->set_branch_address(index_leaf.branch_address());
+  this->AddDependentLeaf(index_leaf.name());
+  std::cout << "Leaf " << this->name() << " excludes array element " << index_leaf.name() << std::endl;
+}
+
+template <class T>
+bool ArrayReductionReducerLeaf<T>::UpdateValue() {
+  if (array_leaf_ == NULL) {
+    *(this->branch_address_templ_) = this->default_value_;
+    return false;
+  }
+
+  const int length = array_leaf_->Length();
+  switch (array_leaf_->l_type()) {
+    case kFloat:
+      GatherValues<Float_t>(length);
+      break;
+    case kDouble:
+      GatherValues<Double_t>(length);
+      break;
+    case kInt:
+      GatherValues<Int_t>(length);
+      break;
+    case kUInt:
+      GatherValues<UInt_t>(length);
+      break;
+    case kShort:
+      GatherValues<Short_t>(length);
+      break;
+    case kUShort:
+      GatherValues<UShort_t>(length);
+      break;
+    case kLong64:
+      GatherValues<Long64_t>(length);
+      break;
+    case kULong64:
+      GatherValues<ULong64_t>(length);
+      break;
+    default:
+      values_.resize(length);
+      for (int i=0; i<length; ++i) {
+        values_[i] = array_leaf_->GetValue(i);
+      }
+      break;
+  }
+
+  mask_.assign(length, 1);
+  if (mask_formula_ != NULL) {
+    const int num_instances = mask_formula_->GetNdata();
+    for (int i=0; i<length; ++i) {
+      mask_[i] = i < num_instances && mask_formula_->EvalInstance(i) != 0;
+    }
+  }
+  if (excluded_index_leaf_ != NULL) {
+    const int excluded_index = static_cast<int>(excluded_index_leaf_->GetValue());
+    if (excluded_index >= 0 && excluded_index < length) {
+      mask_[excluded_index] = 0;
+    }
+  }
+
+  double value = 0.0;
+  if (Reduce(value)) {
+    *(this->branch_address_templ_) = static_cast<T>(value);
+  } else {
+    *(this->branch_address_templ_) = this->default_value_;
+  }
+  return true;
+}
+
+template <class T>
+bool ArrayReductionReducerLeaf<T>::Reduce(double& value) const {
+  const int length = static_cast<int>(values_.size());
+  const double* values = values_.data();
+  const char* mask = mask_.data();
+
+  // all loops select instead of branching on the mask, so that they can be
+  // vectorized (sum, count, min, max) or at least do not mispredict
+  int num_passed = 0;
+  for (int i=0; i<length; ++i) {
+    num_passed += mask[i];
+  }
+
+  switch (reduction_) {
+    case kArraySum: {
+      double sum = 0.0;
+      for (int i=0; i<length; ++i) {
+        sum += mask[i] ? values[i] : 0.0;
+      }
+      value = sum;
+      return true;
+    }
+    case kArrayCountAbove: {
+      int count = 0;
+      for (int i=0; i<length; ++i) {
+        count += mask[i] & (values[i] > threshold_);
+      }
+      value = count;
+      return true;
+    }
+    case kArrayMinimum: {
+      double minimum = std::numeric_limits<double>::infinity();
+      for (int i=0; i<length; ++i) {
+        const double v = mask[i] ? values[i] : std::numeric_limits<double>::infinity();
+        minimum = v < minimum ? v : minimum;
+      }
+      value = minimum;
+      return num_passed > 0;
+    }
+    case kArrayMaximum: {
+      double maximum = -std::numeric_limits<double>::infinity();
+      for (int i=0; i<length; ++i) {
+        const double v = mask[i] ? values[i] : -std::numeric_limits<double>::infinity();
+        maximum = v > maximum ? v : maximum;
+      }
+      value = maximum;
+      return num_passed > 0;
+    }
+    case kArrayArgMinimum: {
+      double minimum = std::numeric_limits<double>::infinity();
+      int index = -1;
+      for (int i=0; i<length; ++i) {
+        const bool better = mask[i] && (index < 0 || values[i] < minimum);
+        minimum = better ? values[i] : minimum;
+        index = better ? i : index;
+      }
+      value = index;
+      return index >= 0;
+    }
+    case kArrayArgMaximum: {
+      double maximum = -std::numeric_limits<double>::infinity();
+      int index = -1;
+      for (int i=0; i<length; ++i) {
+        const bool better = mask[i] && (index < 0 || values[i] > maximum);
+        maximum = better ? values[i] : maximum;
+        index = better ? i : index;
+      }
+      value = index;
+      return index >= 0;
+    }
+  }
+  return false;
+}
+
+} // namespace reducer
+} // namespace dooselection
+
+#endif // DOOSELECTION_REDUCER_ARRAYREDUCTIONREDUCERLEAF_H
@@ -0,0 +1,268 @@
+#include "BDTForest.h"
+
+// from STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// from BOOST
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+
+namespace dooselection {
+namespace reducer {
+
+using namespace doocore::io;
+
+BDTForest::BDTForest(const std::string& xml_file) :
+  grad_boost_(false),
+  regression_trees_(false),
+  use_yes_no_leaf_(true)
+{
+  using boost::property_tree::ptree;
+
+  // method options as in TMVA::MethodBDT (with TMVA's defaults)
+  std::string boost_type("AdaBoost");
+  std::string use_yes_no_leaf("True");
+
+  // missing elements and attributes or malformed values throw ptree_error,
+  // callers only expect int
+  try {
+    ptree pt;
+    try {
+      boost::property_tree::read_xml(xml_file, pt);
+    } catch (const boost::property_tree::xml_parser_error& e) {
+      serr << "BDTForest::BDTForest(...): Cannot read weight file " << xml_file << ": " << e.what() << endmsg;
+      throw 1;
+    }
+
+    const ptree& setup = pt.get_child("MethodSetup");
+    const std::string method = setup.get<std::string>("<xmlattr>.Method", "");
+    if (method.compare(0, 5, "BDT::") != 0) {
+      serr << "BDTForest::BDTForest(...): Weight file " << xml_file << " is for method " << method << ", not a BDT." << endmsg;
+      throw 2;
+    }
+
+    for (ptree::const_iterator it = setup.get_child("Options").begin(); it != setup.get_child("Options").end(); ++it) {
+      if ((*it).first != "Option") continue;
+      const std::string name = (*it).second.get<std::string>("<xmlattr>.name", "");
+      if (name == "BoostType") boost_type = (*it).second.data();
+      if (name == "UseYesNoLeaf") use_yes_no_leaf = (*it).second.data();
+    }
+    grad_boost_      = boost_type == "Grad";
+    // gradient boosting never uses yes/no leaves (TMVA::MethodBDT::GetGradBoostMVA(...))
+    use_yes_no_leaf_ = !grad_boost_ && (use_yes_no_leaf == "True" || use_yes_no_leaf == "T" || use_yes_no_leaf == "1");
+
+    for (ptree::const_iterator it = setup.get_child("Variables").begin(); it != setup.get_child("Variables").end(); ++it) {
+      if ((*it).first != "Variable") continue;
+      variables_.push_back((*it).second.get<std::string>("<xmlattr>.Expression"));
+    }
+
+    if (setup.get<int>("Transformations.<xmlattr>.NTransformations", 0) != 0) {
+      serr << "BDTForest::BDTForest(...): Weight file " << xml_file << " uses variable transformations. These are not supported." << endmsg;
+      throw 3;
+    }
+    if (setup.get<int>("Classes.<xmlattr>.NClass", 2) > 2) {
+      serr << "BDTForest::BDTForest(...): Weight file " << xml_file << " is a multiclass BDT. This is not supported." << endmsg;
+      throw 4;
+    }
+
+    const ptree& weights = setup.get_child("Weights");
+    // older TMVA versions wrote the analysis type as TreeType
+    int analysis_type = weights.get<int>("<xmlattr>.AnalysisType", weights.get<int>("<xmlattr>.TreeType", 0));
+    regression_trees_ = analysis_type == 1;
+
+    try {
+      for (ptree::const_iterator it = weights.begin(); it != weights.end(); ++it) {
+        if ((*it).first != "BinaryTree") continue;
+
+        const ptree& tree = (*it).second;
+        ptree::const_assoc_iterator it_root = tree.find("Node");
+        if (it_root == tree.not_found()) {
+          serr << "BDTForest::BDTForest(...): Tree without nodes in weight file " << xml_file << endmsg;
+          throw 5;
+        }
+        std::pair<int,int> root = AddNode((*it_root).second, 0);
+        roots_.push_back(root.first);
+        depths_.push_back(root.second);
+        boost_weights_.push_back(tree.get<Double_t>("<xmlattr>.boostWeight", 1.0));
+      }
+    } catch (int e) {
+      serr << "BDTForest::BDTForest(...): Cannot read trees in weight file " << xml_file << endmsg;
+      throw e;
+    }
+  } catch (const boost::property_tree::ptree_error& e) {
+    serr << "BDTForest::BDTForest(...): Unexpected content in weight file " << xml_file << ": " << e.what() << endmsg;
+    throw 10;
+  }
+
+  std::vector<int> columns(variables_.size());
+  for (unsigned int i=0; i<columns.size(); ++i) {
+    columns[i] = i;
+  }
+  SetFeatureColumns(columns);
+
+  sinfo << "BDTForest::BDTForest(...): Read " << roots_.size() << " trees with " << node_variables_.size() << " nodes from " << xml_file << " (" << boost_type << ")." << endmsg;
+}
+
+template<class PTree>
+std::pair<int,int> BDTForest::AddNode(const PTree& node, int depth) {
+  const int index = node_variables_.size();
+  node_variables_.push_back(0);
+  node_thresholds_.push_back(0.0);
+  node_children_.push_back(index);
+  node_children_.push_back(index);
+  node_responses_.push_back(0.0);
+
+  if (node.template get<int>("<xmlattr>.NCoef", 0) > 0) {
+    serr << "BDTForest::AddNode(...): Fisher cuts are not supported." << endmsg;
+    throw 6;
+  }
+
+  // leaves keep pointing to themselves, evaluation as in
+  // TMVA::DecisionTree::CheckEvent(...)
+  const int node_type = node.template get<int>("<xmlattr>.nType");
+  if (node_type != 0) {
+    if (regression_trees_) {
+      node_responses_[index] = node.template get<Float_t>("<xmlattr>.res");
+    } else if (use_yes_no_leaf_) {
+      node_responses_[index] = node_type;
+    } else {
+      node_responses_[index] = node.template get<Float_t>("<xmlattr>.purity");
+    }
+    return std::make_pair(index, depth);
+  }
+
+  int index_left  = -1;
+  int index_right = -1;
+  int max_depth   = depth;
+  for (typename PTree::const_iterator it = node.begin(); it != node.end(); ++it) {
+    if ((*it).first != "Node") continue;
+    std::pair<int,int> daughter = AddNode((*it).second, depth+1);
+    const std::string pos = (*it).second.template get<std::string>("<xmlattr>.pos");
+    if (pos == "l") index_left  = daughter.first;
+    if (pos == "r") index_right = daughter.first;
+    max_depth = std::max(max_depth, daughter.second);
+  }
+  if (index_left < 0 || index_right < 0) {
+    serr << "BDTForest::AddNode(...): Intermediate node without two daughters." << endmsg;
+    throw 7;
+  }
+
+  // TMVA::DecisionTreeNode::GoesRight(...): x >= cut goes right if the cut
+  // type is true, otherwise it goes left
+  const bool cut_type = node.template get<int>("<xmlattr>.cType") != 0;
+  node_variables_[index]      = node.template get<int>("<xmlattr>.IVar");
+  node_thresholds_[index]     = node.template get<Float_t>("<xmlattr>.Cut");
+  node_children_[2*index]     = cut_type ? index_left  : index_right;
+  node_children_[2*index+1]   = cut_type ? index_right : index_left;
+
+  if (node_variables_[index] < 0 || node_variables_[index] >= static_cast<int>(variables_.size())) {
+    serr << "BDTForest::AddNode(...): Node cuts on unknown variable " << node_variables_[index] << endmsg;
+    throw 8;
+  }
+
+  return std::make_pair(index, max_depth);
+}
+
+void BDTForest::SetFeatureColumns(const std::vector<int>& columns) {
+  if (columns.size() != variables_.size()) {
+    serr << "BDTForest::SetFeatureColumns(...): Got " << columns.size() << " columns for " << variables_.size() << " variables." << endmsg;
+    throw 9;
+  }
+  columns_ = columns;
+
+  node_columns_.resize(node_variables_.size());
+  for (unsigned int i=0; i<node_variables_.size(); ++i) {
+    node_columns_[i] = columns_[node_variables_[i]];
+  }
+}
+
+void BDTForest::Evaluate(const Float_t* features, std::size_t num_events, std::size_t stride, Double_t* values, Buffers& buffers) const {
+  const int* node_columns        = node_columns_.data();
+  const Float_t* node_thresholds = node_thresholds_.data();
+  const int* node_children       = node_children_.data();
+  const Double_t* node_responses = node_responses_.data();
+
+  std::vector<Double_t>& sums = buffers.sums;
+  std::vector<int>& nodes     = buffers.nodes;
+  sums.assign(num_events, 0.0);
+  nodes.resize(num_events);
+  Double_t norm = 0.0;
+
+  // trees are summed in the same order as in TMVA::MethodBDT to get identical
+  // rounding
+  for (std::size_t t=0; t<roots_.size(); ++t) {
+    std::fill(nodes.begin(), nodes.end(), roots_[t]);
+
+    for (int d=0; d<depths_[t]; ++d) {
+      for (std::size_t e=0; e<num_events; ++e) {
+        const int node = nodes[e];
+        nodes[e] = node_children[2*node + (features[e*stride+node_columns[node]] >= node_thresholds[node])];
+      }
+    }
+
+    if (grad_boost_) {
+      for (std::size_t e=0; e<num_events; ++e) {
+        sums[e] += node_responses[nodes[e]];
+      }
+    } else {
+      const Double_t weight = boost_weights_[t];
+      for (std::size_t e=0; e<num_events; ++e) {
+        sums[e] += weight*node_responses[nodes[e]];
+      }
+      norm += weight;
+    }
+  }
+
+  for (std::size_t e=0; e<num_events; ++e) {
+    // TMVA::Reader returns -999 for events with NaN inputs
+    bool has_nan = false;
+    for (std::vector<int>::const_iterator it = columns_.begin(); it != columns_.end(); ++it) {
+      if (std::isnan(features[e*stride+(*it)])) has_nan = true;
+    }
+
+    if (has_nan) {
+      values[e] = -999;
+    } else if (grad_boost_) {
+      values[e] = 2.0/(1.0+std::exp(-2.0*sums[e]))-1;
+    } else {
+      values[e] = (norm > std::numeric_limits<double>::epsilon()) ? sums[e]/norm : 0;
+    }
+  }
+}
+
+Double_t BDTForest::Evaluate(const Float_t* features) const {
+  // TMVA::Reader returns -999 for events with NaN inputs
+  for (std::vector<int>::const_iterator it = columns_.begin(); it != columns_.end(); ++it) {
+    if (std::isnan(features[*it])) return -999;
+  }
+
+  // same summation order as for batches
+  Double_t sum  = 0.0;
+  Double_t norm = 0.0;
+  for (std::size_t t=0; t<roots_.size(); ++t) {
+    int node = roots_[t];
+    for (int d=0; d<depths_[t]; ++d) {
+      node = node_children_[2*node + (features[node_columns_[node]] >= node_thresholds_[node])];
+    }
+    if (grad_boost_) {
+      sum += node_responses_[node];
+    } else {
+      sum  += boost_weights_[t]*node_responses_[node];
+      norm += boost_weights_[t];
+    }
+  }
+
+  if (grad_boost_) {
+    return 2.0/(1.0+std::exp(-2.0*sum))-1;
+  } else {
+    return (norm > std::numeric_limits<double>::epsilon()) ? sum/norm : 0;
+  }
+}
+
+} // namespace reducer
+} // namespace dooselection
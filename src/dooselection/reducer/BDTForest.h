@@ -0,0 +1,185 @@
+#ifndef DOOSELECTION_REDUCER_BDTFOREST_H
+#define DOOSELECTION_REDUCER_BDTFOREST_H
+
+// from STL
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// from ROOT
+#include "Rtypes.h"
+
+/** @class dooselection::reducer::BDTForest
+ *  @brief Native evaluation of TMVA BDT/BDTG weight files
+ *
+ *  This class reads a TMVA BDT weight file (XML format) and evaluates the
+ *  boosted decision trees without TMVA::Reader. All trees of the forest are
+ *  stored in flat node arrays (feature index, threshold, child indices, leaf
+ *  response). Leaves point to themselves, so that every tree is evaluated
+ *  with a fixed number of steps and without branches. Events are processed in
+ *  batches, looping over events in the innermost loop to allow the compiler
+ *  to vectorize the tree traversal.
+ *
+ *  Evaluation follows TMVA::MethodBDT exactly (Float_t inputs and cuts, same
+ *  summation order), so results are identical to TMVA::Reader. Supported are
+ *  classification forests with AdaBoost-like or gradient boosting without
+ *  variable transformations and Fisher cuts. For unsupported weight files the
+ *  constructor throws.
+ *
+ *  @section bdtforest_usage Usage
+ *
+ *  @code
+ *  BDTForest forest("weights/TMVAClassification_BDTG.weights.xml");
+ *
+ *  // features of num_events events, num_columns values per event
+ *  std::vector<Float_t> features;
+ *  std::vector<Double_t> values(num_events);
+ *  BDTForest::Buffers buffers;
+ *  forest.Evaluate(&features[0], num_events, num_columns, &values[0], buffers);
+ *  @endcode
+ **/
+namespace dooselection {
+namespace reducer {
+class BDTForest {
+ public:
+  /**
+   *  @brief Constructor reading a TMVA weight file
+   *
+   *  @param xml_file TMVA BDT weight file
+   */
+  BDTForest(const std::string& xml_file);
+
+  /**
+   *  @brief Input variable expressions in the order of the weight file
+   */
+  const std::vector<std::string>& variables() const { return variables_; }
+
+  /**
+   *  @brief Number of trees in the forest
+   */
+  std::size_t num_trees() const { return roots_.size(); }
+
+  /**
+   *  @brief Set columns of input variables in the feature matrix
+   *
+   *  By default the i-th variable of the weight file is expected in column i.
+   *
+   *  @param columns column in the feature matrix for each input variable
+   */
+  void SetFeatureColumns(const std::vector<int>& columns);
+
+  /**
+   *  @brief Buffers for the evaluation of a batch of events
+   *
+   *  Reused between calls of Evaluate(...) to avoid allocations per batch. 
+   *  A forest can be evaluated from several threads at once, each thread 
+   *  needs its own buffers.
+   */
+  struct Buffers {
+    std::vector<Double_t> sums; ///< sum of tree responses per event
+    std::vector<int> nodes;     ///< current node per event
+  };
+
+  /**
+   *  @brief Evaluate the forest for a batch of events
+   *
+   *  @param features feature matrix (row-major, one row per event)
+   *  @param num_events number of events (rows)
+   *  @param stride number of columns per row
+   *  @param values output array of size num_events for the classifier values
+   *  @param buffers buffers to use, resized as needed
+   */
+  void Evaluate(const Float_t* features, std::size_t num_events, std::size_t stride, Double_t* values, Buffers& buffers) const;
+
+  /**
+   *  @brief Evaluate the forest for one event
+   *
+   *  @param features features of the event
+   *  @return classifier value
+   */
+  Double_t Evaluate(const Float_t* features) const;
+
+ private:
+  /**
+   *  @brief Add node and its daughters from XML into the node arrays
+   *
+   *  @param node the XML node (boost::property_tree::ptree)
+   *  @param depth depth of this node
+   *  @return index of the node and maximum depth below
+   */
+  template<class PTree>
+  std::pair<int,int> AddNode(const PTree& node, int depth);
+
+  /**
+   *  @brief Input variable expressions
+   */
+  std::vector<std::string> variables_;
+
+  /**
+   *  @brief Column in feature matrix for each input variable
+   */
+  std::vector<int> columns_;
+
+  /**
+   *  @brief Input variable index per node as in weight file
+   */
+  std::vector<int> node_variables_;
+
+  /**
+   *  @brief Column in feature matrix to compare per node
+   */
+  std::vector<int> node_columns_;
+
+  /**
+   *  @brief Cut value per node
+   */
+  std::vector<Float_t> node_thresholds_;
+
+  /**
+   *  @brief Daughter indices per node
+   *
+   *  Node i continues with node_children_[2*i+(x>=cut)]. Leaves point to
+   *  themselves.
+   */
+  std::vector<int> node_children_;
+
+  /**
+   *  @brief Tree response per node (only used for leaves)
+   */
+  std::vector<Double_t> node_responses_;
+
+  /**
+   *  @brief Root node index per tree
+   */
+  std::vector<int> roots_;
+
+  /**
+   *  @brief Maximum depth per tree
+   */
+  std::vector<int> depths_;
+
+  /**
+   *  @brief Boost weight per tree
+   */
+  std::vector<Double_t> boost_weights_;
+
+  /**
+   *  @brief Whether the forest is gradient boosted
+   */
+  bool grad_boost_;
+
+  /**
+   *  @brief Whether the trees are regression trees (response instead of purity)
+   */
+  bool regression_trees_;
+
+  /**
+   *  @brief Whether leaves return +-1 instead of purity
+   */
+  bool use_yes_no_leaf_;
+};
+} // namespace reducer
+} // namespace dooselection
+
+#endif // DOOSELECTION_REDUCER_BDTFOREST_H
@@ -2,7 +2,7 @@
 
 // from STL
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <utility>
 
 // from ROOT
@@ -38,8 +38,6 @@ BkgCategorizerReducer::~BkgCategorizerReducer() {
 }
 
 void BkgCategorizerReducer::PrepareSpecialBranches() {
-  std::string decaystring = "";
-  
   sinfo << "Starting analysis of MC associated decays." << endmsg;
  
   if (decay_matrix_length_leaf_ == NULL && decay_matrix_length_leaf_ != NULL) {
@@ -64,41 +62,34 @@ void BkgCategorizerReducer::PrepareSpecialBranches() {
     interim_tree_->SetBranchStatus(br_depth->GetName(), true);
     interim_tree_->SetBranchStatus(br_matrix->GetName(), true);
     
-    // Fill the map with decay-strings
+    // Count the decays by their signature, strings are only created for the most common decays below
     for (Int_t ev = 0; ev < interim_tree_->GetEntries(); ev++) {
       interim_tree_->GetEntry(ev);
       if (!(decay_depth_leaf_->GetValue() < 1)){
-        std::string decay_string = IDTranslator::makedecaystring(decay_matrix_, *decay_matrix_length_lptr_, columns_, 0, 0, decaystring, true, true);
-        std::map<std::string,int>::const_iterator iter = decay_counter_.find(decay_string);
-
-        if (iter == decay_counter_.end()) {
-          decay_counter_.insert (pair<std::string,int>(decay_string,1));
-        } else {
-          decay_counter_[decay_string]++;
-        }
+        mctools::DecaySignature signature = IDTranslator::makedecaysignature(decay_matrix_, *decay_matrix_length_lptr_, columns_, true);
+        DecayCount& decay_count = decay_counter_.insert(std::make_pair(signature, DecayCount{0, ev})).first->second;
+        decay_count.count++;
       }
-      decaystring = "";
     }
     
-    interim_tree_->SetBranchStatus("*", true);
-    
-    std::map<std::string,int>::const_iterator iter; 
-    
+    // For equal counts, the decay occuring first wins
     sinfo << "Finished analysing most common decays: " << endmsg;
-    for (std::size_t i=0; i< max_number_decays_ && i<decay_counter_.size(); ++i) {
-      std::string max_key = "";
-      int max_counts = 0;
-      for (iter=decay_counter_.begin(); iter!=decay_counter_.end(); iter++) {
-        if (iter->second > max_counts) {
-          max_counts = iter->second;
-          max_key    = iter->first;
+    for (std::size_t i=0; i< max_number_decays_ && !decay_counter_.empty(); ++i) {
+      std::unordered_map<mctools::DecaySignature,DecayCount>::iterator max_iter = decay_counter_.begin();
+      for (std::unordered_map<mctools::DecaySignature,DecayCount>::iterator iter=decay_counter_.begin(); iter!=decay_counter_.end(); iter++) {
+        if (iter->second.count > max_iter->second.count || (iter->second.count == max_iter->second.count && iter->second.first_entry < max_iter->second.first_entry)) {
+          max_iter = iter;
         }
       }
-      decay_vector_.push_back(std::pair<int,std::string>(decay_counter_[max_key],max_key));
+      interim_tree_->GetEntry(max_iter->second.first_entry);
+      decay_vector_.push_back(std::pair<int,std::string>(max_iter->second.count, IDTranslator::makedecaystring(decay_matrix_, *decay_matrix_length_lptr_, columns_, 0, 0, "", true, true)));
+      decay_signatures_.push_back(max_iter->first);
       sinfo << "Number: " << i+1 << ", Decay: " << decay_vector_.at(i).second << ", Count: " << decay_vector_.at(i).first << endmsg;
-      decay_counter_.erase(max_key);  
+      decay_counter_.erase(max_iter);
     } 
     
+    interim_tree_->SetBranchStatus("*", true);
+    
     background_category_lptr_ = (Int_t*)background_category_leaf_->branch_address();
     sinfo << "Background categories according to this table will be put into leaf " << background_category_leaf_->name() << endmsg;
     
@@ -114,9 +105,9 @@ void BkgCategorizerReducer::PrepareSpecialBranches() {
 void BkgCategorizerReducer::UpdateSpecialLeaves() {
   if (decay_depth_leaf_ != NULL) {
     if (!(decay_depth_leaf_->GetValue() < 1)) {
-      std::string decaystring = IDTranslator::makedecaystring(decay_matrix_, *decay_matrix_length_lptr_, columns_, 0, 0, "", true, true);
+      const mctools::DecaySignature signature = IDTranslator::makedecaysignature(decay_matrix_, *decay_matrix_length_lptr_, columns_, true);
       std::size_t j = 0;
-      while(j < max_number_decays_ && j < decay_vector_.size() && decaystring != decay_vector_.at(j).second){
+      while(j < max_number_decays_ && j < decay_vector_.size() && signature != decay_signatures_.at(j)){
         j++;
       }
       if (j==max_number_decays_){
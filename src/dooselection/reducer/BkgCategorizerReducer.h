@@ -5,9 +5,12 @@
 
 // from STL
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <utility>
 
+// from DooSelection
+#include "dooselection/mctools/DecaySignature.h"
+
 /** \class dooselection::reducer::BkgCategorizerReducer
  *  \brief Derived Reducer to generate background categories based on TupleToolMCDecayTree
  *
@@ -104,6 +107,13 @@ protected:
   virtual void UpdateFurtherSpecialLeaves() {}
   
 private:
+  /**
+   *  @brief Number of occurences of a decay and the first entry it occurs in (to render its decay string)
+   **/
+  struct DecayCount {
+    int       count;
+    Long64_t  first_entry;
+  };
   /**
    *  @brief Leaf for background category to be inserted into tuple
    **/
@@ -146,13 +156,17 @@ private:
    **/
   std::string           decay_matrix_name_;
   /**
-   *  @brief Map for decay counting
+   *  @brief Map for decay counting, decays are identified by their signature
    **/
-  std::map<std::string,int> decay_counter_;
+  std::unordered_map<mctools::DecaySignature,DecayCount> decay_counter_;
   /**
    *  @brief Sorted vector with background categories and string representation
    **/
   std::vector<std::pair<int,std::string> > decay_vector_;
+  /**
+   *  @brief Decay signatures of the background categories in decay_vector_
+   **/
+  std::vector<mctools::DecaySignature> decay_signatures_;
   /**
    *  @brief Maximum number of decays to categorize
    **/
@@ -1,8 +1,12 @@
 #include "BkgCategorizerReducer2.h"
 
 // from STL
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <string>
-#include <map>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 
 // from ROOT
@@ -15,7 +19,7 @@
 
 // From project
 #include "dooselection/mctools/mcdecaymatrixreader/MCDecayMatrixReader.h"
-#include "dooselection/mctools/mcdecaymatrixreader/Particle.h"
+#include "dooselection/mctools/mcdecaymatrixreader/DecayTree.h"
 
 using std::pair;
 using namespace doocore::io;
@@ -24,6 +28,8 @@ using namespace dooselection::mctools;
 namespace dooselection {
   namespace reducer {
     
+    const Long64_t BkgCategorizerReducer2::block_size_;
+
     BkgCategorizerReducer2::BkgCategorizerReducer2() :
     background_category_leaf_(NULL),
     background_category_lptr_(NULL),
@@ -32,11 +38,150 @@ namespace dooselection {
     decay_depth_leaf_(NULL),
     decay_counter_(),
     max_number_decays_(40),
+    num_threads_(1),
     mode_(ChargesIrrel)
     {}
     
     BkgCategorizerReducer2::~BkgCategorizerReducer2() {}
     
+    mctools::DecaySignature BkgCategorizerReducer2::ComputeDecaySignature(const Float_t* decay_matrix, int decay_matrix_length) const {
+      const bool abs_initial_state = (mode_ == ChargesIrrel || mode_ == ChargesInStIrrel);
+      const bool abs_final_state   = (mode_ == ChargesIrrel || mode_ == ChargesFinalStIrrel);
+      return decay_matrix_reader_.createDecaySignature(decay_matrix, decay_matrix_length, columns_, abs_initial_state, abs_final_state);
+    }
+    
+    void BkgCategorizerReducer2::CountDecays() {
+      const Long64_t num_entries = interim_tree_->GetEntries();
+      const std::size_t matrix_size = static_cast<std::size_t>(columns_)*rows_;
+      
+      // two buffers, so that the next block is read while the last one is counted
+      std::vector<Float_t> blocks[2];
+      std::vector<Int_t> block_lengths[2];
+      Long64_t block_entries[2] = {0, 0};
+      std::vector<DecayCounter> counters(num_threads_);
+      
+      // reading the tree is sequential, entries without decay get length -1
+      auto read_block = [&](Long64_t block_index) {
+        std::vector<Float_t>& block = blocks[block_index%2];
+        std::vector<Int_t>& lengths = block_lengths[block_index%2];
+        block.resize(static_cast<std::size_t>(block_size_)*matrix_size);
+        lengths.resize(block_size_);
+        const Long64_t block_start = block_index*block_size_;
+        block_entries[block_index%2] = std::min(block_size_, num_entries-block_start);
+        for (Long64_t row=0; row<block_entries[block_index%2]; ++row) {
+          interim_tree_->GetEntry(block_start+row);
+          if (!(decay_depth_leaf_->GetValue() < 1)) {
+            std::copy(decay_matrix_, decay_matrix_+matrix_size, block.begin()+row*matrix_size);
+            lengths[row] = *decay_matrix_length_lptr_;
+          } else {
+            lengths[row] = -1;
+          }
+        }
+      };
+      auto count_rows = [&](Long64_t block_index, Long64_t row_begin, Long64_t row_end, unsigned int t) {
+        const std::vector<Float_t>& block = blocks[block_index%2];
+        const std::vector<Int_t>& lengths = block_lengths[block_index%2];
+        for (Long64_t row=row_begin; row<row_end; ++row) {
+          if (lengths[row] < 0) continue;
+          DecayCount& decay_count = counters[t].insert(std::make_pair(ComputeDecaySignature(&block[row*matrix_size], lengths[row]), DecayCount{0, block_index*block_size_+row})).first->second;
+          decay_count.count++;
+        }
+      };
+      
+      const Long64_t num_blocks = (num_entries+block_size_-1)/block_size_;
+      if (num_threads_ == 1) {
+        for (Long64_t block_index=0; block_index<num_blocks; ++block_index) {
+          read_block(block_index);
+          count_rows(block_index, 0, block_entries[block_index%2], 0);
+        }
+      } else {
+        // the workers are started once for the whole pass, each computes and 
+        // counts the signatures of its share of the rows of every block
+        std::mutex block_mutex;
+        std::condition_variable block_read, block_counted;
+        Long64_t num_blocks_read = 0;
+        std::vector<Long64_t> num_blocks_counted(num_threads_, 0);
+        auto count_blocks = [&](unsigned int t) {
+          for (Long64_t block_index=0; block_index<num_blocks; ++block_index) {
+            {
+              std::unique_lock<std::mutex> lock(block_mutex);
+              block_read.wait(lock, [&]{return num_blocks_read > block_index;});
+            }
+            const Long64_t entries = block_entries[block_index%2];
+            const Long64_t rows_per_thread = (entries+num_threads_-1)/num_threads_;
+            count_rows(block_index, std::min(t*rows_per_thread, entries), std::min((t+1)*rows_per_thread, entries), t);
+            {
+              std::lock_guard<std::mutex> lock(block_mutex);
+              ++num_blocks_counted[t];
+            }
+            block_counted.notify_one();
+          }
+        };
+        
+        std::vector<std::thread> threads;
+        for (unsigned int t=0; t<num_threads_; ++t) {
+          threads.push_back(std::thread(count_blocks, t));
+        }
+        for (Long64_t block_index=0; block_index<num_blocks; ++block_index) {
+          // the buffer of block_index-2 is overwritten, so all workers must be done with it
+          if (block_index >= 2) {
+            std::unique_lock<std::mutex> lock(block_mutex);
+            block_counted.wait(lock, [&]{return *std::min_element(num_blocks_counted.begin(), num_blocks_counted.end()) >= block_index-1;});
+          }
+          read_block(block_index);
+          {
+            std::lock_guard<std::mutex> lock(block_mutex);
+            num_blocks_read = block_index+1;
+          }
+          block_read.notify_all();
+        }
+        for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it) {
+          (*it).join();
+        }
+      }
+      
+      // merge the counters of all threads
+      decay_counter_.swap(counters[0]);
+      for (unsigned int t=1; t<num_threads_; ++t) {
+        for (DecayCounter::const_iterator iter=counters[t].begin(); iter!=counters[t].end(); ++iter) {
+          std::pair<DecayCounter::iterator,bool> inserted = decay_counter_.insert(*iter);
+          if (!inserted.second) {
+            inserted.first->second.count += iter->second.count;
+            inserted.first->second.first_entry = std::min(inserted.first->second.first_entry, iter->second.first_entry);
+          }
+        }
+      }
+    }
+    
+    namespace {
+      /// Ordering of decays by count, equal counts by first occurence
+      template<class DecayEntry>
+      bool MoreCommonDecay(const DecayEntry& lhs, const DecayEntry& rhs) {
+        return lhs.second.count > rhs.second.count || (lhs.second.count == rhs.second.count && lhs.second.first_entry < rhs.second.first_entry);
+      }
+    }
+    
+    std::vector<std::pair<mctools::DecaySignature,BkgCategorizerReducer2::DecayCount> > BkgCategorizerReducer2::MostCommonDecays() const {
+      typedef std::pair<mctools::DecaySignature,DecayCount> DecayEntry;
+      
+      // bounded heap with the least common of the selected decays on top
+      std::vector<DecayEntry> heap;
+      if (max_number_decays_ <= 0) return heap;
+      heap.reserve(max_number_decays_);
+      for (DecayCounter::const_iterator iter=decay_counter_.begin(); iter!=decay_counter_.end(); ++iter) {
+        if (heap.size() < static_cast<std::size_t>(max_number_decays_)) {
+          heap.push_back(*iter);
+          std::push_heap(heap.begin(), heap.end(), MoreCommonDecay<DecayEntry>);
+        } else if (MoreCommonDecay<DecayEntry>(*iter, heap.front())) {
+          std::pop_heap(heap.begin(), heap.end(), MoreCommonDecay<DecayEntry>);
+          heap.back() = *iter;
+          std::push_heap(heap.begin(), heap.end(), MoreCommonDecay<DecayEntry>);
+        }
+      }
+      std::sort_heap(heap.begin(), heap.end(), MoreCommonDecay<DecayEntry>);
+      return heap;
+    }
+    
     void BkgCategorizerReducer2::PrepareSpecialBranches() {
       sinfo << "Starting analysis of MC associated decays." << endmsg;
       
@@ -73,106 +218,26 @@ namespace dooselection {
         br_matrix->SetAddress(decay_matrix_);
 
 
-        //Create the temporary particle, which is overwritten for each event in the event loop below by the decay_matrix_reader_
-        //After the particle is overwritten the DecayStrings are created using methods from the particle class
-        dooselection::mctools::mcdecaymatrixreader::Particle tempParticle;
-
-        
-        // Fill the map with decay-strings
-        for (Int_t ev = 0; ev < interim_tree_->GetEntries(); ev++) {
-          interim_tree_->GetEntry(ev);
-          // Debug output to check content of decay matrices
-          //          std::cout << "DecayMatrix Length: " << decay_matrix_length_leaf_->GetValue() << ", DecayMatrix Depth: " << decay_depth_leaf_->GetValue() << ", Motherparticle: " << decay_matrix_[0][0] << std::endl << std::endl;
-          if (!(decay_depth_leaf_->GetValue() < 1)){
-            
-//            //Debug output to print decay matrices on the terminal
-//            for (int i=0; i<*decay_matrix_length_lptr_; ++i){
-//              for (int j=0; j<columns_; ++j){
-//                std::cout << decay_matrix_[i*columns_+j] << " ";
-//              }
-//                std::cout << std::endl;
-//            }
-            
-            
-            tempParticle = decay_matrix_reader_.createMinimalDecayingParticle(decay_matrix_, *decay_matrix_length_lptr_, columns_, 0, 0);
-            std::string decay_string = tempParticle.GetCompleteDecay();
-            std::map<std::string,int>::const_iterator iter = decay_counter_.find(decay_string);
-            
-            if (mode_ == ChargesRel){
-              if (iter != decay_counter_.end()){
-                decay_counter_[decay_string]++;
-              }
-              else {
-                decay_counter_.insert (pair<std::string,int>(decay_string,1));
-                decay_string_referencer.insert(pair<std::string, std::string>(decay_string,decay_string));
-              }
-            }
-            else if (mode_ == ChargesIrrel){
-              std::string decay_string_absmcid = tempParticle.GetCompleteAbsMCIDDecay();
-              iter = decay_counter_.find(decay_string_absmcid);
-              if (iter != decay_counter_.end()){
-                decay_counter_[decay_string_absmcid]++;
-              }
-              else {
-                decay_counter_.insert (pair<std::string,int>(decay_string_absmcid,1));
-                decay_string_referencer.insert(pair<std::string, std::string>(decay_string_absmcid,decay_string));
-              }
-            }
-            else if (mode_ == ChargesFinalStIrrel){
-              std::string decay_string_finalstate_absmcid = tempParticle.GetCompleteFinalStateAbsMCIDDecay();
-              iter = decay_counter_.find(decay_string_finalstate_absmcid);
-              if (iter != decay_counter_.end()){
-                decay_counter_[decay_string_finalstate_absmcid]++;
-              }
-              else {
-                decay_counter_.insert (pair<std::string,int>(decay_string_finalstate_absmcid,1));
-                decay_string_referencer.insert(pair<std::string, std::string>(decay_string_finalstate_absmcid,decay_string));
-              }
-            }
-            else if (mode_ == ChargesInStIrrel){
-              std::string decay_string_initialstate_conjugated = tempParticle.GetConjugatedInitialStateCompleteDecay();
-              iter = decay_counter_.find(decay_string_initialstate_conjugated);
-              if (iter != decay_counter_.end()){
-                decay_counter_[decay_string_initialstate_conjugated]++;
-              }
-              else {
-                decay_counter_.insert (pair<std::string,int>(decay_string_initialstate_conjugated,1));
-                decay_string_referencer.insert(pair<std::string, std::string>(decay_string_initialstate_conjugated,decay_string));
-              }
-            }
-          }
-        }
-        
-        interim_tree_->SetBranchStatus("*", true);
-        
-        
-        
-        
-        
-        
-        //Sort Decays and fill two Vectors, one with the most appearing Decays and one with their count value
-        std::map<std::string,int>::const_iterator iter;
-        std::map<std::string,std::string>::iterator iter_decay_referencer;
+        // Count the decays by their signature, strings are only created for the most common decays below
+        CountDecays();
         
+        //Fill two Vectors, one with the most appearing Decays and one with their count value
         sinfo << "Finished analysing most common decays: " << endmsg;
-        for (int i=0; i < max_number_decays_ && (unsigned)i<decay_string_referencer.size(); ++i) {
-          std::string max_key = "";
-          int max_counts = 0;
-          for (iter=decay_counter_.begin(); iter!=decay_counter_.end(); iter++) {
-            if (iter->second > max_counts) {
-              max_counts = iter->second;
-              max_key    = iter->first;
-            }
-          }
-          iter_decay_referencer = decay_string_referencer.find(max_key);
-          
-          decay_vector_.push_back(std::pair<int,std::string>(decay_counter_[max_key],max_key));
+        std::vector<std::pair<mctools::DecaySignature,DecayCount> > most_common_decays = MostCommonDecays();
+        dooselection::mctools::mcdecaymatrixreader::DecayTree decay_tree;
+        for (std::size_t i=0; i < most_common_decays.size(); ++i) {
+          // the decay string with particle names is taken from the first entry of this decay
+          interim_tree_->GetEntry(most_common_decays[i].second.first_entry);
+          decay_matrix_reader_.readDecayTree(decay_matrix_, *decay_matrix_length_lptr_, columns_, decay_tree);
+          decay_vector_.push_back(std::pair<int,std::string>(most_common_decays[i].second.count, decay_tree.GetCompleteDecay()));
+          decay_signatures_.push_back(most_common_decays[i].first);
           
-          sinfo << "Number: " << i+1 << ", Decay: " << iter_decay_referencer->second << ", Count: " << decay_vector_.at(i).first << endmsg;
-          decay_counter_.erase(max_key);
+          sinfo << "Number: " << i+1 << ", Decay: " << decay_vector_.at(i).second << ", Count: " << decay_vector_.at(i).first << endmsg;
         }
+        decay_counter_.clear();
+
+        interim_tree_->SetBranchStatus("*", true);
 
-                
         background_category_lptr_ = (Int_t*)background_category_leaf_->branch_address();
         sinfo << "Background categories according to this table will be put into leaf " << background_category_leaf_->name() << endmsg;
         
@@ -188,26 +253,10 @@ namespace dooselection {
     void BkgCategorizerReducer2::UpdateSpecialLeaves() {
       if (decay_depth_leaf_ != NULL) {
         if (!(decay_depth_leaf_->GetValue() < 1)) {
-          dooselection::mctools::mcdecaymatrixreader::Particle tempParticle;
-          std::string decaystring = "";
-          
-          tempParticle = decay_matrix_reader_.createMinimalDecayingParticle(decay_matrix_, *decay_matrix_length_lptr_, columns_, 0, 0);
-          
-          if (mode_ == ChargesRel) {
-            decaystring = tempParticle.GetCompleteDecay();
-          }
-          else if (mode_ == ChargesIrrel) {
-            decaystring = tempParticle.GetCompleteAbsMCIDDecay();
-          }
-          else if (mode_ == ChargesFinalStIrrel) {
-            decaystring = tempParticle.GetCompleteFinalStateAbsMCIDDecay();
-          }
-          else if (mode_ == ChargesInStIrrel) {
-            decaystring = tempParticle.GetConjugatedInitialStateCompleteDecay();
-          }
+          const mctools::DecaySignature signature = ComputeDecaySignature(decay_matrix_, *decay_matrix_length_lptr_);
           
           int j = 0;
-          while(j < max_number_decays_ && (unsigned)j < decay_vector_.size() && decaystring != decay_vector_.at(j).second){
+          while(j < max_number_decays_ && (unsigned)j < decay_vector_.size() && signature != decay_signatures_.at(j)){
             j++;
           }
           if (j==max_number_decays_){
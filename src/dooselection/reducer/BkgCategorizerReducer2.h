@@ -5,10 +5,11 @@
 
 // from STL
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <utility>
 
 // from DooSelection
+#include "dooselection/mctools/DecaySignature.h"
 #include "dooselection/mctools/mcdecaymatrixreader/MCDecayMatrixReader.h"
 
 
@@ -75,6 +76,14 @@ namespace dooselection {
        *  @brief Setter for the number of different decays that are taken into account, default is 40
        **/
       void set_max_number_of_decays(int max_number_of_decays){ max_number_decays_ = max_number_of_decays; }
+      /**
+       *  @brief Setter for the number of threads used to count the decays before the event loop (default: 1)
+       *
+       *  The decay matrices are read block by block from the interim tree. The
+       *  decay signatures of each block are computed and counted on all threads,
+       *  each with its own counter, and the counters are merged at the end.
+       **/
+      void set_num_threads(unsigned int num_threads) { num_threads_ = num_threads > 0 ? num_threads : 1; }
       /**
        *  @brief Setter for decay_matrix_length_
        **/
@@ -136,6 +145,30 @@ namespace dooselection {
       virtual void UpdateFurtherSpecialLeaves() {}
       
     private:
+      /**
+       *  @brief Number of occurences of a decay and the first entry it occurs in (to render its decay string)
+       **/
+      struct DecayCount {
+        int       count;
+        Long64_t  first_entry;
+      };
+      /**
+       *  @brief Map of decay signatures to their counts
+       **/
+      typedef std::unordered_map<mctools::DecaySignature,DecayCount> DecayCounter;
+      /**
+       *  @brief Signature of the decay in a decay matrix, according to mode_
+       **/
+      mctools::DecaySignature ComputeDecaySignature(const Float_t* decay_matrix, int decay_matrix_length) const;
+      /**
+       *  @brief Counts the decays of all entries of the interim tree on num_threads_ threads
+       **/
+      void CountDecays();
+      /**
+       *  @brief Most common decays in decreasing order (at most max_number_decays_), equal counts ordered by first occurence
+       **/
+      std::vector<std::pair<mctools::DecaySignature,DecayCount> > MostCommonDecays() const;
+
       /**
        *  @brief Leaf for background category to be inserted into tuple
        **/
@@ -177,21 +210,29 @@ namespace dooselection {
        **/
       std::string                       decay_matrix_name_;
       /**
-       *  @brief Map for decay counting
+       *  @brief Map for decay counting, decays are identified by their signature
        **/
-      std::map<std::string,int>         decay_counter_;
-      /**
-       *  @brief Map to reference decay strings based on particle MC IDs to the related decay strings with particle names
-       **/
-      std::map<std::string,std::string> decay_string_referencer;
+      DecayCounter                      decay_counter_;
       /**
        *  @brief Sorted vector with background categories and string representation
        **/
       std::vector<std::pair<int,std::string> > decay_vector_;
+      /**
+       *  @brief Decay signatures of the background categories in decay_vector_
+       **/
+      std::vector<mctools::DecaySignature> decay_signatures_;
       /**
        *  @brief Maximum number of decays to categorize
        **/
       int                               max_number_decays_;
+      /**
+       *  @brief Number of threads for counting the decays
+       **/
+      unsigned int                      num_threads_;
+      /**
+       *  @brief Number of entries per block when counting the decays
+       **/
+      static const Long64_t             block_size_ = 4096;
       /**
        *  @brief MCDecayMatrixReader object, it provides functionality to read a given decay matrix to create particles with fully setted properties
        **/
@@ -0,0 +1,34 @@
+#include "CounterRandom.h"
+
+namespace dooselection {
+namespace reducer {
+
+const std::uint32_t CounterRandom::kMultiplier0;
+const std::uint32_t CounterRandom::kMultiplier1;
+const std::uint32_t CounterRandom::kWeyl0;
+const std::uint32_t CounterRandom::kWeyl1;
+
+namespace {
+/// splitmix64 finalizer
+std::uint64_t Mix(std::uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+} // namespace
+
+std::uint64_t CounterRandom::EntryKey(std::int64_t run, std::int64_t event, std::int64_t candidate) {
+  return Mix(Mix(Mix(static_cast<std::uint64_t>(run)) ^ static_cast<std::uint64_t>(event)) ^ static_cast<std::uint64_t>(candidate));
+}
+
+std::uint32_t CounterRandom::Stream(const char* name) {
+  std::uint32_t hash = 2166136261u;
+  for (; *name != '\0'; ++name) {
+    hash = (hash ^ static_cast<unsigned char>(*name))*16777619u;
+  }
+  return hash;
+}
+
+} // namespace reducer
+} // namespace dooselection
@@ -0,0 +1,147 @@
+#ifndef DOOSELECTION_REDUCER_COUNTERRANDOM_H
+#define DOOSELECTION_REDUCER_COUNTERRANDOM_H
+
+// from STL
+#include <array>
+#include <cstdint>
+
+/** @class dooselection::reducer::CounterRandom
+ *  @brief Counter-based random generator (Philox4x32-10)
+ *
+ *  Unlike TRandom3, this generator has no state that advances with each drawn
+ *  number. A random number is a pure function of the seed, an entry key, a
+ *  stream and an index:
+ *
+ *  @code
+ *  CounterRandom random(42);
+ *  std::uint64_t key = CounterRandom::EntryKey(run_number, event_number, candidate);
+ *  double u = random.Uniform(key, CounterRandom::Stream("idxRandom"));
+ *  @endcode
+ *
+ *  The entry key is derived from stable identifiers of a candidate (run and
+ *  event number, candidate index), so the same candidate always gets the same
+ *  random numbers independent of the entry order, the number of threads or
+ *  the splitting of the input into chunks. Different streams (e.g. one per
+ *  leaf) give independent numbers for the same entry key.
+ *
+ *  Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+ *  3", SC11) generates four 32 bit words per 128 bit counter in ten rounds of
+ *  32x32->64 bit multiplications. The counter consists of the entry key, the
+ *  stream and the block index (index/4), the key is the seed.
+ **/
+namespace dooselection {
+namespace reducer {
+
+class CounterRandom {
+ public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param seed seed (Philox key)
+   */
+  explicit CounterRandom(std::uint64_t seed=0)
+    : key_lo_(static_cast<std::uint32_t>(seed)),
+      key_hi_(static_cast<std::uint32_t>(seed >> 32))
+  {}
+
+  /**
+   *  @brief Entry key from stable identifiers of a candidate
+   *
+   *  @param run run number
+   *  @param event event number
+   *  @param candidate candidate index in the event (if more than one candidate per event)
+   *  @return 64 bit entry key
+   */
+  static std::uint64_t EntryKey(std::int64_t run, std::int64_t event, std::int64_t candidate=0);
+
+  /**
+   *  @brief Stream number from a name (e.g. leaf name), FNV-1a hash
+   */
+  static std::uint32_t Stream(const char* name);
+
+  /**
+   *  @brief Four random 32 bit words for one counter
+   *
+   *  @param entry_key entry key (see EntryKey())
+   *  @param stream stream number
+   *  @param block block index, words 4*block to 4*block+3
+   */
+  std::array<std::uint32_t,4> Generate(std::uint64_t entry_key, std::uint32_t stream, std::uint32_t block) const {
+    std::uint32_t c0 = static_cast<std::uint32_t>(entry_key);
+    std::uint32_t c1 = static_cast<std::uint32_t>(entry_key >> 32);
+    std::uint32_t c2 = stream;
+    std::uint32_t c3 = block;
+    std::uint32_t k0 = key_lo_;
+    std::uint32_t k1 = key_hi_;
+    for (int round=0; round<10; ++round) {
+      Round(c0, c1, c2, c3, k0, k1);
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    std::array<std::uint32_t,4> words = {{c0, c1, c2, c3}};
+    return words;
+  }
+
+  /**
+   *  @brief Random 32 bit word with index for an entry key and stream
+   */
+  std::uint32_t Word(std::uint64_t entry_key, std::uint32_t stream, std::uint32_t index=0) const {
+    return Generate(entry_key, stream, index/4)[index%4];
+  }
+
+  /**
+   *  @brief Uniform random number in (0,1)
+   */
+  double Uniform(std::uint64_t entry_key, std::uint32_t stream, std::uint32_t index=0) const {
+    return ToUniform(Word(entry_key, stream, index));
+  }
+
+  /**
+   *  @brief Random integer in [0,n) (as TRandom::Integer(n))
+   */
+  std::uint32_t Integer(std::uint32_t n, std::uint64_t entry_key, std::uint32_t stream, std::uint32_t index=0) const {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(Word(entry_key, stream, index))*n) >> 32);
+  }
+
+ private:
+  static const std::uint32_t kMultiplier0 = 0xD2511F53;
+  static const std::uint32_t kMultiplier1 = 0xCD9E8D57;
+  static const std::uint32_t kWeyl0 = 0x9E3779B9;
+  static const std::uint32_t kWeyl1 = 0xBB67AE85;
+
+  /**
+   *  @brief One Philox round on a counter
+   */
+  static void Round(std::uint32_t& c0, std::uint32_t& c1, std::uint32_t& c2, std::uint32_t& c3, std::uint32_t k0, std::uint32_t k1) {
+    const std::uint64_t product0 = static_cast<std::uint64_t>(kMultiplier0)*c0;
+    const std::uint64_t product1 = static_cast<std::uint64_t>(kMultiplier1)*c2;
+    const std::uint32_t new_c0 = static_cast<std::uint32_t>(product1 >> 32) ^ c1 ^ k0;
+    const std::uint32_t new_c2 = static_cast<std::uint32_t>(product0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<std::uint32_t>(product1);
+    c3 = static_cast<std::uint32_t>(product0);
+    c0 = new_c0;
+    c2 = new_c2;
+  }
+
+  /**
+   *  @brief Map a 32 bit word to (0,1)
+   */
+  static double ToUniform(std::uint32_t word) {
+    return (word + 0.5)*(1.0/4294967296.0);
+  }
+
+  /**
+   *  @brief Lower 32 bit of the seed
+   */
+  std::uint32_t key_lo_;
+
+  /**
+   *  @brief Upper 32 bit of the seed
+   */
+  std::uint32_t key_hi_;
+};
+
+} // namespace reducer
+} // namespace dooselection
+
+#endif // DOOSELECTION_REDUCER_COUNTERRANDOM_H
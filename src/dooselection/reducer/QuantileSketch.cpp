@@ -0,0 +1,123 @@
+#include "QuantileSketch.h"
+
+// from STL
+#include <algorithm>
+#include <cmath>
+
+namespace dooselection {
+namespace reducer {
+
+QuantileSketch::QuantileSketch(unsigned int k, std::uint64_t seed)
+  : k_(std::max(k, 8u)),
+    count_(0),
+    size_(0),
+    max_size_(0),
+    compactors_(),
+    random_state_(seed != 0 ? seed : 1)
+{
+  Grow();
+}
+
+std::size_t QuantileSketch::Capacity(std::size_t level) const {
+  // lower levels get geometrically smaller capacities (factor 2/3 per level)
+  const std::size_t depth = compactors_.size()-level-1;
+  return static_cast<std::size_t>(std::ceil(k_*std::pow(2./3., static_cast<double>(depth))))+1;
+}
+
+void QuantileSketch::Grow() {
+  compactors_.push_back(std::vector<double>());
+  max_size_ = 0;
+  for (std::size_t level=0; level<compactors_.size(); ++level) {
+    max_size_ += Capacity(level);
+  }
+}
+
+unsigned int QuantileSketch::RandomBit() {
+  random_state_ ^= random_state_ << 13;
+  random_state_ ^= random_state_ >> 7;
+  random_state_ ^= random_state_ << 17;
+  return static_cast<unsigned int>(random_state_ >> 63);
+}
+
+void QuantileSketch::Compress() {
+  while (size_ >= max_size_) {
+    for (std::size_t level=0; level<compactors_.size(); ++level) {
+      if (compactors_[level].size() >= Capacity(level)) {
+        if (level+1 >= compactors_.size()) {
+          Grow();
+        }
+        std::vector<double>& compactor = compactors_[level];
+        std::vector<double>& next = compactors_[level+1];
+        std::sort(compactor.begin(), compactor.end());
+
+        // an odd value stays on this level
+        double kept_value = 0.0;
+        const bool keep_last = compactor.size()%2 == 1;
+        if (keep_last) {
+          kept_value = compactor.back();
+          compactor.pop_back();
+        }
+        for (std::size_t i=RandomBit(); i<compactor.size(); i+=2) {
+          next.push_back(compactor[i]);
+        }
+        size_ -= compactor.size()/2;
+        compactor.clear();
+        if (keep_last) {
+          compactor.push_back(kept_value);
+        }
+        break;
+      }
+    }
+  }
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+  while (compactors_.size() < other.compactors_.size()) {
+    Grow();
+  }
+  for (std::size_t level=0; level<other.compactors_.size(); ++level) {
+    compactors_[level].insert(compactors_[level].end(), other.compactors_[level].begin(), other.compactors_[level].end());
+    size_ += other.compactors_[level].size();
+  }
+  count_ += other.count_;
+  if (size_ >= max_size_) Compress();
+}
+
+std::vector<std::pair<double,double> > QuantileSketch::WeightedValues() const {
+  std::vector<std::pair<double,double> > weighted_values;
+  weighted_values.reserve(size_);
+  double weight = 1.0;
+  for (std::size_t level=0; level<compactors_.size(); ++level, weight*=2.0) {
+    for (std::vector<double>::const_iterator it = compactors_[level].begin(); it != compactors_[level].end(); ++it) {
+      weighted_values.push_back(std::make_pair(*it, weight));
+    }
+  }
+  std::sort(weighted_values.begin(), weighted_values.end());
+  return weighted_values;
+}
+
+std::vector<double> QuantileSketch::Quantiles(const std::vector<double>& probabilities) const {
+  const std::vector<std::pair<double,double> > weighted_values = WeightedValues();
+  std::vector<double> quantiles;
+  quantiles.reserve(probabilities.size());
+  if (weighted_values.empty()) {
+    quantiles.resize(probabilities.size(), 0.0);
+    return quantiles;
+  }
+
+  // weights are powers of 2, so the cumulative weights are exact
+  double cumulative_weight = 0.0;
+  std::size_t i = 0;
+  for (std::vector<double>::const_iterator it = probabilities.begin(); it != probabilities.end(); ++it) {
+    const double rank = *it*count_;
+    while (i+1 < weighted_values.size() && cumulative_weight+weighted_values[i].second < rank) {
+      cumulative_weight += weighted_values[i].second;
+      ++i;
+    }
+    quantiles.push_back(weighted_values[i].first);
+  }
+  return quantiles;
+}
+
+} // namespace reducer
+} // namespace dooselection
@@ -0,0 +1,127 @@
+#ifndef DOOSELECTION_REDUCER_QUANTILESKETCH_H
+#define DOOSELECTION_REDUCER_QUANTILESKETCH_H
+
+// from STL
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+/** @class dooselection::reducer::QuantileSketch
+ *  @brief Streaming quantile sketch (KLL) with bounded memory.
+ *
+ *  Values are added one by one. The sketch keeps a hierarchy of compactors:
+ *  level h holds values with weight 2^h. Whenever the sketch is full, the
+ *  lowest full level is sorted and every second value (random offset) is moved
+ *  to the next level. The memory is O(k log(n/k)) for n values and the rank
+ *  error of the quantiles is about 1.7/k (k=200: below 1%).
+ *
+ *  Sketches are mergeable: sketches filled on separate threads (or files) can
+ *  be merged into one sketch with the same accuracy.
+ **/
+namespace dooselection {
+namespace reducer {
+
+class QuantileSketch {
+ public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param k size parameter controlling accuracy and memory
+   *  @param seed seed for the random offsets of compactions
+   */
+  explicit QuantileSketch(unsigned int k=200, std::uint64_t seed=0x2545f4914f6cdd1dULL);
+
+  /**
+   *  @brief Add a value
+   */
+  void Add(double value) {
+    compactors_[0].push_back(value);
+    ++count_;
+    if (++size_ >= max_size_) Compress();
+  }
+
+  /**
+   *  @brief Merge another sketch into this one
+   */
+  void Merge(const QuantileSketch& other);
+
+  /**
+   *  @brief Number of values added (including merged sketches)
+   */
+  std::uint64_t count() const { return count_; }
+
+  /**
+   *  @brief Approximate quantiles
+   *
+   *  For each probability p the smallest retained value with a cumulative
+   *  weight of at least p*count() is returned.
+   *
+   *  @param probabilities probabilities in increasing order
+   *  @return quantiles for all probabilities
+   */
+  std::vector<double> Quantiles(const std::vector<double>& probabilities) const;
+
+  /**
+   *  @brief Retained values with their weights, sorted by value
+   *
+   *  The weights sum up to count(), so these are a weighted sample of all
+   *  values added.
+   */
+  std::vector<std::pair<double,double> > WeightedValues() const;
+
+ private:
+  /**
+   *  @brief Capacity of compactor at level
+   */
+  std::size_t Capacity(std::size_t level) const;
+
+  /**
+   *  @brief Add a new level on top and update the maximum size
+   */
+  void Grow();
+
+  /**
+   *  @brief Compact full levels until the sketch is below its maximum size
+   */
+  void Compress();
+
+  /**
+   *  @brief Random bit for the offset of a compaction (xorshift64)
+   */
+  unsigned int RandomBit();
+
+  /**
+   *  @brief Size parameter
+   */
+  unsigned int k_;
+
+  /**
+   *  @brief Number of values added
+   */
+  std::uint64_t count_;
+
+  /**
+   *  @brief Number of values retained in all levels
+   */
+  std::size_t size_;
+
+  /**
+   *  @brief Maximum number of values retained before compressing
+   */
+  std::size_t max_size_;
+
+  /**
+   *  @brief Values on each level, level h has weight 2^h
+   */
+  std::vector<std::vector<double> > compactors_;
+
+  /**
+   *  @brief State of the random generator
+   */
+  std::uint64_t random_state_;
+};
+
+} // namespace reducer
+} // namespace dooselection
+
+#endif // DOOSELECTION_REDUCER_QUANTILESKETCH_H
@@ -692,25 +692,43 @@ void Reducer::RenameBranches(std::vector<ReducerLeaf<Float_t>* >* leaves, const
 template<class T>
 void Reducer::InitializeOutputBranches(TTree* tree, const std::vector<ReducerLeaf<T>* >& leaves) {
   for (typename std::vector<ReducerLeaf<T>* >::const_iterator it = leaves.begin(); it != leaves.end(); ++it) {
-    (*it)->CreateBranch(tree);
+    // transient leaves are only used internally
+    if (!(*it)->transient()) {
+      (*it)->CreateBranch(tree);
+    }
   }
 }
   
 template<class T1,class T2>
 std::vector<ReducerLeaf<T1>*> Reducer::PurgeOutputBranches(const std::vector<ReducerLeaf<T1>* >& leaves, const std::vector<ReducerLeaf<T2>* >& interim_leaves) const {
   std::vector<ReducerLeaf<T1>* > purged_leaves;
+  auto interim_leaf_exists = [&interim_leaves](const TString& name) {
+    for (typename std::vector<ReducerLeaf<T2>* >::const_iterator it_ex = interim_leaves.begin(); it_ex != interim_leaves.end(); ++it_ex) {
+      if ((*it_ex)->name() == name) return true;
+    }
+    return false;
+  };
   for (typename std::vector<ReducerLeaf<T1>* >::const_iterator it = leaves.begin(); it != leaves.end(); ++it) {
-    bool found = false;
-    if (overwrite_existing_leaves_) {
+    if ((*it)->transient()) {
+      // transient leaves do not create branches, but must not shadow interim
+      // or other new leaves in lookups by name
+      const ReducerLeaf<T1>* leaf = *it;
+      auto name_taken = [&](const TString& name) {
+        return interim_leaf_exists(name) || OtherLeafExists(name, leaf);
+      };
+      if (name_taken((*it)->name())) {
+        TString new_name = (*it)->name() + "_transient";
+        while (name_taken(new_name)) new_name += "_1";
+        swarn << "Transient leaf " << (*it)->name() << " collides with an existing leaf. Will rename to " << new_name << "." << endmsg;
+        (*it)->set_name(new_name);
+      }
+      purged_leaves.push_back(*it);
+    }
+    else if (overwrite_existing_leaves_) {
       purged_leaves.push_back(*it);
     }
     else {
-      for (typename std::vector<ReducerLeaf<T2>* >::const_iterator it_ex = interim_leaves.begin(); it_ex != interim_leaves.end(); ++it_ex) {
-        if ((*it_ex)->name() == (*it)->name()) {
-          found = true;
-          break;
-        }
-      }
+      const bool found = interim_leaf_exists((*it)->name());
       if (found) {
         swarn << "New leaf " << (*it)->name() << " already existing. Will ignore." << endmsg;
       } else {
@@ -17,6 +17,7 @@
 #include "TTreeFormula.h"
 
 #include "ReducerLeaf.h"
+#include "ArrayReductionReducerLeaf.h"
 
 // forward declarations
 class TFile;
@@ -70,6 +71,9 @@ class RooArgSet;
  * // create custom branches via built-in functions here
  * my_reducer.CreateDoubleCopyLeaf(...);
  *
+ * // helper leaves needed only to compute other leaves are not written
+ * my_reducer.CreateTransientDoubleCopyLeaf(...);
+ *
  * // step 2: Run. Prepare more higher level leaves, running event loop with 
  * //         best candidate selection and writing events into output tree.
  * my_reducer.Run();
@@ -168,6 +172,9 @@ class Reducer {
   
   void set_output_file_path(TString const&);
   void set_output_tree_path(TString const&);
+
+  TString const& input_file_path() const { return input_file_path_; }
+  TString const& input_tree_path() const { return input_tree_path_; }
   ///@}
   
   /** @name Input tree processing
@@ -184,6 +191,13 @@ class Reducer {
    *  @param num_events_process number of events to process
    */
   void set_num_events_process(int num_events_process) { num_events_process_ = num_events_process; }
+
+  /**
+   *  @brief Get number of events in input tree to process
+   *
+   *  @return number of events to process (-1 for all events)
+   */
+  int num_events_process() const { return num_events_process_; }
   ///@}
   
   /** @name Branch keeping/omitting
@@ -643,6 +657,72 @@ class Reducer {
     int_leaves_.push_back(leaf);
   }
   ///@}
+
+  /** @name Transient leaf creation
+   *  Functions creating new transient leaves. These are updated for each entry
+   *  like all other new leaves and can be used by other leaves and derived
+   *  Reducers, but are not written into the output tree. A transient leaf 
+   *  named like an interim leaf is renamed (suffix "_transient") during 
+   *  initialization, so that lookups by name stay unambiguous.
+   */
+  ///@{
+  ReducerLeaf<Double_t>& CreateTransientDoubleLeaf(TString name, Double_t default_value=0.0) {
+    ReducerLeaf<Double_t>& new_leaf(CreateDoubleLeaf(name, default_value));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+  template<class T>
+  ReducerLeaf<Double_t>& CreateTransientDoubleCopyLeaf(TString name, const ReducerLeaf<T>& leaf_to_copy, double c=1.0) {
+    ReducerLeaf<Double_t>& new_leaf(CreateDoubleCopyLeaf(name, leaf_to_copy, c));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+
+  ReducerLeaf<Float_t>& CreateTransientFloatLeaf(TString name, Float_t default_value=0.0) {
+    ReducerLeaf<Float_t>& new_leaf(CreateFloatLeaf(name, default_value));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+  template<class T>
+  ReducerLeaf<Float_t>& CreateTransientFloatCopyLeaf(TString name, const ReducerLeaf<T>& leaf_to_copy, double c=1.0) {
+    ReducerLeaf<Float_t>& new_leaf(CreateFloatCopyLeaf(name, leaf_to_copy, c));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+
+  ReducerLeaf<Int_t>& CreateTransientIntLeaf(TString name, Int_t default_value=0) {
+    ReducerLeaf<Int_t>& new_leaf(CreateIntLeaf(name, default_value));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+  template<class T>
+  ReducerLeaf<Int_t>& CreateTransientIntCopyLeaf(TString name, const ReducerLeaf<T>& leaf_to_copy, double c=1.0) {
+    ReducerLeaf<Int_t>& new_leaf(CreateIntCopyLeaf(name, leaf_to_copy, c));
+    new_leaf.set_transient(true);
+    return new_leaf;
+  }
+  ///@}
+
+  /** @name Array reduction leaf creation
+   *  Functions creating new leaves that reduce an array-based interim leaf to a
+   *  single number per entry (see ArrayReductionReducerLeaf), e.g. the minimum
+   *  over all PVs. A mask expression and an index leaf to exclude can be set on
+   *  the returned leaf. The output tree keeps one entry per candidate.
+   */
+  ///@{
+  ArrayReductionReducerLeaf<Double_t>& CreateDoubleArrayReductionLeaf(TString name, const ReducerLeaf<Float_t>& array_leaf, ArrayReduction reduction, Double_t default_value=0.0, double threshold=0.0) {
+    ArrayReductionReducerLeaf<Double_t>* new_leaf(new ArrayReductionReducerLeaf<Double_t>(name, name, "Double_t", interim_tree_, default_value));
+    new_leaf->SetReduction(array_leaf, reduction, threshold);
+    double_leaves_.push_back(new_leaf);
+    return *new_leaf;
+  }
+  ArrayReductionReducerLeaf<Int_t>& CreateIntArrayReductionLeaf(TString name, const ReducerLeaf<Float_t>& array_leaf, ArrayReduction reduction, Int_t default_value=-1, double threshold=0.0) {
+    ArrayReductionReducerLeaf<Int_t>* new_leaf(new ArrayReductionReducerLeaf<Int_t>(name, name, "Int_t", interim_tree_, default_value));
+    new_leaf->SetReduction(array_leaf, reduction, threshold);
+    int_leaves_.push_back(new_leaf);
+    return *new_leaf;
+  }
+  ///@}
   
  protected:
   /**
@@ -830,7 +910,8 @@ class Reducer {
    *
    *  All leaves that already exist in the interim tree, but are also to be 
    *  created will be purged by this function from the list of leaves 
-   *  supplied.
+   *  supplied. Transient leaves are kept, but renamed if another interim or 
+   *  new leaf has the same name.
    *
    *  @param leaves vector of leaves to purge
    *  @param interim_leaves vector of leaves to compare against
@@ -839,6 +920,28 @@ class Reducer {
   template<class T1,class T2>
   std::vector<ReducerLeaf<T1>*> PurgeOutputBranches(const std::vector<ReducerLeaf<T1>* >& leaves, const std::vector<ReducerLeaf<T2>* >& interim_leaves) const;
   
+  /**
+   *  @brief Check if a leaf other than a given one has a certain name
+   *
+   *  All interim and new leaves are checked.
+   *
+   *  @param name name to check
+   *  @param leaf leaf to ignore
+   *  @return whether another leaf has this name
+   */
+  bool OtherLeafExists(const TString& name, const void* leaf) const {
+    return OtherLeafExists(name, leaf, interim_leaves_) || OtherLeafExists(name, leaf, float_leaves_) ||
+           OtherLeafExists(name, leaf, double_leaves_) || OtherLeafExists(name, leaf, int_leaves_) ||
+           OtherLeafExists(name, leaf, ulong_leaves_) || OtherLeafExists(name, leaf, long_leaves_);
+  }
+  template<class T>
+  bool OtherLeafExists(const TString& name, const void* leaf, const std::vector<ReducerLeaf<T>* >& leaves) const {
+    for (typename std::vector<ReducerLeaf<T>* >::const_iterator it = leaves.begin(); it != leaves.end(); ++it) {
+      if (*it != leaf && (*it)->name() == name) return true;
+    }
+    return false;
+  }
+  
   /**
    *  @brief Activate all dependent leaves of given leaf list
    *
@@ -864,6 +967,7 @@ class Reducer {
         }
       }
       
+      leaf->ActivateDependentLeaves(input_tree_);
       leaf->ActivateDependentConditionLeaves(input_tree_);
     }
   }
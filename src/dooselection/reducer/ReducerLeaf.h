@@ -4,6 +4,9 @@
 // from STL
 #include <iostream>
 #include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
 
 // from Boost
 #include <boost/algorithm/string.hpp>
@@ -18,6 +21,9 @@
 // from DooCore
 #include "doocore/io/MsgStream.h"
 
+// from project
+#include "dooselection/reducer/CounterRandom.h"
+
 // forward decalarations
 class TLeaf;
 enum ReducerLeafOperations {
@@ -27,6 +33,7 @@ enum ReducerLeafOperations {
   kDivideLeaves,
   kEqualLeaf,
   kRandomizeLeaf,
+  kCounterRandomizeLeaf,
   kLogLeaf,
   kMinimum,
   kMaximum,
@@ -54,6 +61,29 @@ enum LeafDataType {
   kUChar,
   kUnknownType,
 };
+
+/**
+ *  @brief Value of an integer-like leaf at a branch address, widened to 64 bit
+ *
+ *  Unlike ReducerLeaf<T>::GetValue(), the value is not converted to T first,
+ *  so that 64 bit run and event numbers are not truncated or rounded.
+ */
+inline std::int64_t IntegerLeafValue(const void* address, LeafDataType type) {
+  switch (type) {
+    case kDouble:  return static_cast<std::int64_t>(*static_cast<const Double_t*>(address));
+    case kInt:     return *static_cast<const Int_t*>(address);
+    case kFloat:   return static_cast<std::int64_t>(*static_cast<const Float_t*>(address));
+    case kULong64: return static_cast<std::int64_t>(*static_cast<const ULong64_t*>(address));
+    case kLong64:  return *static_cast<const Long64_t*>(address);
+    case kUInt:    return *static_cast<const UInt_t*>(address);
+    case kBool:    return *static_cast<const Bool_t*>(address);
+    case kShort:   return *static_cast<const Short_t*>(address);
+    case kUShort:  return *static_cast<const UShort_t*>(address);
+    case kChar:    return *static_cast<const Char_t*>(address);
+    case kUChar:   return *static_cast<const UChar_t*>(address);
+    default:       return 0;
+  }
+}
   
 template <class T>
 class ReducerLeaf;
@@ -123,6 +153,14 @@ public:
   LeafDataType l_type() const { return l_type_; }
   
   TTree* tree() const { return tree_; }
+
+  /**
+   *  @brief Whether the leaf is transient
+   *
+   *  Transient leaves are updated every entry like all other leaves, but are
+   *  never written into the output tree.
+   */
+  bool transient() const { return transient_; }
   TBranch* branch() { return leaf_->GetBranch(); }
   TString LeafString() const ;   ///< return leaf string for branch creation
 
@@ -151,6 +189,7 @@ public:
   ///@{
   const TString& set_name(const TString& new_name) { name_=new_name; title_=new_name; return name_; }
   void set_branch_address(void* ptr) { branch_address_ = ptr; }
+  void set_transient(bool transient) { transient_ = transient; }
   void SetDefaultValue(T value) {
     default_value_ = value;
   }
@@ -288,6 +327,47 @@ public:
     random_generator_ = random_generator;
     SetOperation<T,T>(*this,*this,kRandomizeLeaf,1.0,1.0);
   }
+
+  /**
+   *  @brief Set leaf to contain reproducible random values
+   *
+   *  The leaf will contain random numbers between 0 and 2^30 from a 
+   *  counter-based generator, keyed by run and event number of the entry and 
+   *  the name of this leaf. Unlike Randomize(TRandom*), each candidate gets the
+   *  same random number independent of the entry order or splitting of the 
+   *  input. For more than one candidate per event, use the overload with a 
+   *  candidate leaf.
+   *
+   *  @param random_generator a counter-based random generator to use.
+   *  @param run_leaf leaf with the run number
+   *  @param event_leaf leaf with the event number
+   */
+  template<class T1, class T2>
+  void Randomize(const CounterRandom* random_generator, const ReducerLeaf<T1>& run_leaf, const ReducerLeaf<T2>& event_leaf) {
+    counter_random_generator_ = random_generator;
+    random_stream_ = CounterRandom::Stream(name());
+    // key leaves are read in their own type, not through a ReducerLeaf<T>
+    random_key_leaves_.clear();
+    random_key_leaves_.push_back(std::make_pair(static_cast<const void*>(run_leaf.branch_address()), run_leaf.l_type()));
+    random_key_leaves_.push_back(std::make_pair(static_cast<const void*>(event_leaf.branch_address()), event_leaf.l_type()));
+    SetOperation<T1,T2>(run_leaf,event_leaf,kCounterRandomizeLeaf,1.0,1.0);
+  }
+
+  /**
+   *  @brief Set leaf to contain reproducible random values
+   *
+   *  @param random_generator a counter-based random generator to use.
+   *  @param run_leaf leaf with the run number
+   *  @param event_leaf leaf with the event number
+   *  @param candidate_leaf leaf with the index of the candidate in the event
+   */
+  template<class T1, class T2, class T3>
+  void Randomize(const CounterRandom* random_generator, const ReducerLeaf<T1>& run_leaf, const ReducerLeaf<T2>& event_leaf, const ReducerLeaf<T3>& candidate_leaf) {
+    Randomize(random_generator, run_leaf, event_leaf);
+    random_key_leaves_.push_back(std::make_pair(static_cast<const void*>(candidate_leaf.branch_address()), candidate_leaf.l_type()));
+    AddDependentLeaf(candidate_leaf.name());
+    std::cout << "Leaf " << name() << " uses candidate index " << candidate_leaf.name() << std::endl;
+  }
   ///@}
   
   /** @name Access dependent leaves
@@ -307,6 +387,31 @@ public:
   const ReducerLeaf<T>* leaf_pointer_two() const {
     return leaf_pointer_two_;
   }
+
+  /**
+   *  @brief Register a further leaf this leaf depends on
+   *
+   *  For dependencies beyond leaf_pointer_one() and leaf_pointer_two(), so 
+   *  that their branches are activated with ActivateDependentLeaves().
+   *
+   *  @param leaf_name name of the dependent leaf
+   */
+  void AddDependentLeaf(const TString& leaf_name) {
+    dependent_leaf_names_.push_back(leaf_name);
+  }
+
+  /**
+   *  @brief Activate all further dependent leaves for a given tree
+   *
+   *  @param tree the TTree to activate dependent leaves in
+   */
+  void ActivateDependentLeaves(TTree* tree) const {
+    for (auto leaf_name : dependent_leaf_names_) {
+      if (tree->GetLeaf(leaf_name) != NULL) {
+        tree->SetBranchStatus(leaf_name, 1);
+      }
+    }
+  }
   ///@}
   
   /**
@@ -382,6 +487,11 @@ private:
    *  @brief Pointer to first other leaf for operations
    */
   ReducerLeaf<T>* leaf_pointer_two_;
+
+  /**
+   *  @brief Names of further leaves this leaf depends on
+   */
+  std::vector<TString> dependent_leaf_names_;
   
   double leaf_factor_one_;            ///< leaf factor for basic arithmatic ops
   double leaf_factor_two_;            ///< leaf factor for basic arithmatic ops
@@ -393,6 +503,26 @@ private:
    *  @brief Connected random generator
    */
   TRandom* random_generator_;
+
+  /**
+   *  @brief Connected counter-based random generator
+   */
+  const CounterRandom* counter_random_generator_;
+
+  /**
+   *  @brief Stream of the counter-based random generator for this leaf
+   */
+  std::uint32_t random_stream_;
+
+  /**
+   *  @brief Branch addresses and types of run, event and (optional) candidate leaves for counter-based random numbers
+   */
+  std::vector<std::pair<const void*, LeafDataType> > random_key_leaves_;
+
+  /**
+   *  @brief Whether the leaf is not to be written into the output tree
+   */
+  bool transient_;
 };
 
 template <class T>
@@ -408,8 +538,13 @@ branch_address_(NULL),
 tree_(tree),
 leaf_pointer_one_(NULL),
 leaf_pointer_two_(NULL),
+dependent_leaf_names_(),
 leaf_operation_(kNoneOperation),
-random_generator_(NULL)
+random_generator_(NULL),
+counter_random_generator_(NULL),
+random_stream_(0),
+random_key_leaves_(),
+transient_(false)
 {
   SetLeafType();
   branch_address_templ_ = new T();
@@ -429,8 +564,13 @@ branch_address_(leaf->GetValuePointer()),
 tree_(NULL),
 leaf_pointer_one_(NULL),
 leaf_pointer_two_(NULL),
+dependent_leaf_names_(),
 leaf_operation_(kNoneOperation),
-random_generator_(NULL)
+random_generator_(NULL),
+counter_random_generator_(NULL),
+random_stream_(0),
+random_key_leaves_(),
+transient_(false)
 {
   SetLeafType();
 }
@@ -448,10 +588,15 @@ branch_address_(r.branch_address_),
 tree_(r.tree_),
 leaf_pointer_one_(r.leaf_pointer_one_),
 leaf_pointer_two_(r.leaf_pointer_two_),
+dependent_leaf_names_(r.dependent_leaf_names_),
 leaf_factor_one_(r.leaf_factor_one_),
 leaf_factor_two_(r.leaf_factor_two_),
 leaf_operation_(r.leaf_operation_),
-random_generator_(NULL)
+random_generator_(NULL),
+counter_random_generator_(r.counter_random_generator_),
+random_stream_(r.random_stream_),
+random_key_leaves_(r.random_key_leaves_),
+transient_(r.transient_)
 {        
   //std::cout << "copy    constructor: " << &r << " -> " << this << ", name: " << name_ << "|" << &name_ << " (untemplated): " << branch_address_ << ", (templated): " << branch_address_templ_ << std::endl;
 }
@@ -644,6 +789,15 @@ bool ReducerLeaf<T>::UpdateValue() {
         *branch_address_templ_ = random_generator_->Rndm()*1073741824.0;
         matched = true;
         break;
+      case kCounterRandomizeLeaf: {
+        const std::int64_t candidate = random_key_leaves_.size() > 2 ? IntegerLeafValue(random_key_leaves_[2].first, random_key_leaves_[2].second) : 0;
+        const std::uint64_t entry_key = CounterRandom::EntryKey(IntegerLeafValue(random_key_leaves_[0].first, random_key_leaves_[0].second),
+                                                                IntegerLeafValue(random_key_leaves_[1].first, random_key_leaves_[1].second),
+                                                                candidate);
+        *branch_address_templ_ = counter_random_generator_->Uniform(entry_key, random_stream_)*1073741824.0;
+        matched = true;
+        break;
+      }
       case kConditionsMap:
         if (!conditions_map_.empty()) {
           return EvalConditions();
@@ -690,6 +844,9 @@ void ReducerLeaf<T>::SetOperation(const ReducerLeaf<T1>& l1, const ReducerLeaf<T
     case kRandomizeLeaf:
       std::cout << "Leaf " << name() << " = random number" << std::endl;
       break;
+    case kCounterRandomizeLeaf:
+      std::cout << "Leaf " << name() << " = random number(" << l1.name() << ", " << l2.name() << ")" << std::endl;
+      break;
     default:
       break;
   }
@@ -703,6 +860,8 @@ void ReducerLeaf<T>::SetOperation(const ReducerLeaf<T1>& l1, const ReducerLeaf<T
   // does not matter.
   // Their value is returned via ReducerLeaf<T>::GetValue() which checks type_ 
   // entry and casts accordingly.
+  // for kCounterRandomizeLeaf, the run and event leaves are only needed as 
+  // dependencies, their values are read via IntegerLeafValue()
   if (operation != kRandomizeLeaf) {
     leaf_pointer_one_ = new ReducerLeaf<T>(l1.name(), l1.title(), l1.type(), l1.tree());
     leaf_pointer_one_->branch_address_ = l1.branch_address();
@@ -1,12 +1,27 @@
 #include "SPlotterReducer.h"
 
+// from STL
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 // from Boost
 #include <boost/assign/std/vector.hpp>
+#include <boost/filesystem.hpp>
+
+// from ROOT
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TObjArray.h"
+#include "TTree.h"
 
 // from RooFit
 #include "RooDataSet.h"
 #include "RooAbsPdf.h"
 #include "RooSimultaneous.h"
+#include "RooRealVar.h"
+#include "RooCmdArg.h"
+#include "RooLinkedList.h"
 
 // from DooCore
 #include <doocore/io/EasyTuple.h>
@@ -18,6 +33,9 @@
 #include <doofit/plotting/Plot/PlotSimultaneous.h>
 #include <doofit/plotting/Plot/PlotConfig.h>
 
+// from project
+#include "dooselection/tools/StableHash.h"
+
 using namespace boost::assign;
 using namespace doocore::io;
 using namespace doofit::plotting;
@@ -25,11 +43,37 @@ using namespace doofit::plotting;
 namespace dooselection {
 namespace reducer {
 
+namespace {
+/// Write all contents of a fit argument (including sub arguments) into a stream
+void SerializeCmdArg(std::ostream& out, const RooCmdArg& arg) {
+  out << arg.GetName() << "(" << arg.getInt(0) << "," << arg.getInt(1) << "," << arg.getDouble(0) << "," << arg.getDouble(1);
+  for (int i=0; i<3; ++i) {
+    out << "," << (arg.getString(i) != NULL ? arg.getString(i) : "");
+  }
+  for (int i=0; i<2; ++i) {
+    out << "," << (arg.getObject(i) != NULL ? arg.getObject(i)->GetName() : "");
+    out << "," << (arg.getSet(i) != NULL ? arg.getSet(i)->contentsString() : "");
+  }
+  TIterator* it_sub_args = arg.subArgs().MakeIterator();
+  TObject* sub_arg = NULL;
+  while ((sub_arg = it_sub_args->Next())) {
+    const RooCmdArg* sub_cmd_arg = dynamic_cast<const RooCmdArg*>(sub_arg);
+    if (sub_cmd_arg != NULL) {
+      out << ",";
+      SerializeCmdArg(out, *sub_cmd_arg);
+    }
+  }
+  delete it_sub_args;
+  out << ")";
+}
+} // namespace
+
 SPlotterReducer::SPlotterReducer(doofit::fitter::splot::SPlotFit2& spf, RooArgSet observables) :
   splotfit_(spf),
   observables_(observables),
   plot_directory_("PlotSPlotterReducer"),
-  ext_fit_args_(NULL)
+  ext_fit_args_(NULL),
+  num_cpu_(-1)
 {
   set_old_style_interim_tree(true);
 }
@@ -40,69 +84,276 @@ void SPlotterReducer::ProcessInputTree() {
 
   
 void SPlotterReducer::CreateSpecialBranches() {
-  doocore::io::EasyTuple etuple(interim_tree_, observables_);
-  RooDataSet& data = etuple.ConvertToDataSet();
-    
-  splotfit_.set_input_data(&data);
-  splotfit_.Fit(ext_fit_args_);
+  std::string cache_file_path;
+  if (!cache_directory_.empty()) {
+    cache_file_path = (boost::filesystem::path(cache_directory_) / ("splot_" + CacheKey() + ".root")).string();
+  }
   
+  if (!cache_file_path.empty() && ReadCache(cache_file_path)) {
+    sinfo << "SPlotterReducer::CreateSpecialBranches(): Using cached fit result and sweights from " << cache_file_path << endmsg;
+  } else {
+    doocore::io::EasyTuple etuple(interim_tree_, observables_);
+    RooDataSet& data = etuple.ConvertToDataSet();
+    
+    if (num_cpu_ > 0) {
+      splotfit_.set_num_cpu(num_cpu_);
+    }
+    splotfit_.set_input_data(&data);
+    splotfit_.Fit(ext_fit_args_);
+    
 //  int argc = 1;
 //  
 //  char ** argv;
 //  argv = new char[1];
 //  argv[0] = new char[10];
 //  argv[0] = "";
-  
+    
 //  char* argv[1];
 //  strcpy( argv[0], "" );
 //  argv[0] = "";
+    
+    PlotConfig cfg_plot("cfg_plot");
+    cfg_plot.InitializeOptions();
+    cfg_plot.set_plot_directory(plot_directory_);
+    
+    bool sim_pdf = dynamic_cast<const RooSimultaneous*>(&splotfit_.pdf()) != NULL;
+    
+    TIterator* it_observables = observables_.createIterator();
+    TObject* object = NULL;
+    while ((object = it_observables->Next())) {
+      RooRealVar* observable = dynamic_cast<RooRealVar*>(object);
+      if (observable != NULL && splotfit_.pdf().dependsOn(*observable)) {
+        if (sim_pdf) {
+          PlotSimultaneous myplot(cfg_plot, *observable, data, dynamic_cast<const RooSimultaneous&>(splotfit_.pdf()), components_plot_);
+          myplot.PlotIt();
+        } else {
+          Plot myplot(cfg_plot, *observable, data, splotfit_.pdf(), components_plot_);
+          myplot.PlotIt();
+        }
+      }
+    }
+    delete it_observables;
+    
+    // get sweight maps from SPlotFit2
+    std::map<std::string,RooDataSet*> sweighted_datasets = splotfit_.GetSwDataSets();
+    
+    if (data.numEntries() != interim_tree_->GetEntries()) {
+      doocore::io::serr << "Number of entries in interim tree and sweighted datasets mismatch!" << doocore::io::endmsg;
+      doocore::io::serr << "RooFit dataset contains:    " << data.numEntries() << " entries." << doocore::io::endmsg;;
+      doocore::io::serr << "Tree contains:              " << interim_tree_->GetEntries() << " entries." << doocore::io::endmsg;;
+      
+      throw 314;
+    }
+    
+    // extract all sweights once into one contiguous array, so that the event 
+    // loop does not need to access the RooDataSets at all
+    const unsigned int num_components = sweighted_datasets.size();
+    const int num_entries             = data.numEntries();
+    sweights_.assign(static_cast<size_t>(num_entries)*num_components, -1000);
+    
+    unsigned int c = 0;
+    for (std::map<std::string,RooDataSet*>::const_iterator it = sweighted_datasets.begin();
+         it != sweighted_datasets.end(); ++it, ++c) {
+      sweight_components_.push_back((*it).first);
+      
+      RooDataSet* sweighted_data = (*it).second;
+      for (int i=0; i<num_entries; ++i) {
+        sweighted_data->get(i);
+        sweights_[static_cast<size_t>(i)*num_components+c] = sweighted_data->weight();
+      }
+    }
+    
+    if (!cache_file_path.empty()) {
+      WriteCache(cache_file_path);
+    }
+  }
   
-  PlotConfig cfg_plot("cfg_plot");
-  cfg_plot.InitializeOptions();
-  cfg_plot.set_plot_directory(plot_directory_);
+  interim_tree_->SetBranchStatus("*", 1);
   
-  bool sim_pdf = dynamic_cast<const RooSimultaneous*>(&splotfit_.pdf()) != NULL;
+  for (std::vector<std::string>::const_iterator it = sweight_components_.begin();
+       it != sweight_components_.end(); ++it) {
+    doocore::io::sinfo << "SPlotterReducer::CreateSpecialBranches(): Creating leaf for sweights " << (*it)+"_sw" << doocore::io::endmsg;
+    sweight_leaves_.push_back(&CreateDoubleLeaf((*it)+"_sw", -1000));
+  }
+}
+
+std::string SPlotterReducer::CacheKey() const {
+  std::stringstream key;
+  key << std::setprecision(17);
   
+  // input data
+  key << input_file_path() << ";" << input_tree_path() << ";" << cut_string() << ";" << num_events_process() << ";";
+  boost::filesystem::path input_path(input_file_path().Data());
+  if (boost::filesystem::exists(input_path)) {
+    key << boost::filesystem::file_size(input_path) << ";" << boost::filesystem::last_write_time(input_path) << ";";
+  }
+  
+  // observables including ranges
   TIterator* it_observables = observables_.createIterator();
-  TObject* object = NULL;
-  while ((object = it_observables->Next())) {
-    RooRealVar* observable = dynamic_cast<RooRealVar*>(object);
-    if (observable != NULL && splotfit_.pdf().dependsOn(*observable)) {
-      if (sim_pdf) {
-        PlotSimultaneous myplot(cfg_plot, *observable, data, dynamic_cast<const RooSimultaneous&>(splotfit_.pdf()), components_plot_);
-        myplot.PlotIt();
+  RooAbsArg* observable = NULL;
+  while ((observable = dynamic_cast<RooAbsArg*>(it_observables->Next()))) {
+    key << observable->GetName();
+    RooRealVar* var = dynamic_cast<RooRealVar*>(observable);
+    if (var != NULL) {
+      key << "[" << var->getMin() << "," << var->getMax() << "]";
+    }
+    key << ";";
+  }
+  delete it_observables;
+  
+  // PDF structure
+  RooArgSet* components = splotfit_.pdf().getComponents();
+  TIterator* it_components = components->createIterator();
+  RooAbsArg* component = NULL;
+  while ((component = dynamic_cast<RooAbsArg*>(it_components->Next()))) {
+    key << component->ClassName() << "::" << component->GetName() << "(";
+    TIterator* it_servers = component->serverIterator();
+    RooAbsArg* server = NULL;
+    while ((server = dynamic_cast<RooAbsArg*>(it_servers->Next()))) {
+      key << server->GetName() << ",";
+    }
+    delete it_servers;
+    key << ");";
+  }
+  delete it_components;
+  delete components;
+  
+  // start parameters of the PDF
+  RooArgSet* parameters = splotfit_.pdf().getParameters(observables_);
+  TIterator* it_parameters = parameters->createIterator();
+  RooAbsArg* parameter = NULL;
+  while ((parameter = dynamic_cast<RooAbsArg*>(it_parameters->Next()))) {
+    key << parameter->GetName();
+    RooRealVar* var = dynamic_cast<RooRealVar*>(parameter);
+    if (var != NULL) {
+      key << "=" << var->getVal() << "[" << var->getMin() << "," << var->getMax() << "]" << (var->isConstant() ? "C" : "");
+    }
+    key << ";";
+  }
+  delete it_parameters;
+  delete parameters;
+  
+  // external fit arguments
+  if (ext_fit_args_ != NULL) {
+    TIterator* it_fit_args = ext_fit_args_->MakeIterator();
+    TObject* fit_arg = NULL;
+    while ((fit_arg = it_fit_args->Next())) {
+      const RooCmdArg* cmd_arg = dynamic_cast<const RooCmdArg*>(fit_arg);
+      if (cmd_arg != NULL) {
+        SerializeCmdArg(key, *cmd_arg);
       } else {
-        Plot myplot(cfg_plot, *observable, data, splotfit_.pdf(), components_plot_);
-        myplot.PlotIt();
+        key << fit_arg->GetName();
       }
+      key << ";";
     }
+    delete it_fit_args;
   }
+  
+  return dooselection::tools::StableHashString(key.str());
+}
 
-  interim_tree_->SetBranchStatus("*", 1);
+bool SPlotterReducer::ReadCache(const std::string& cache_file_path) {
+  if (!boost::filesystem::exists(cache_file_path)) {
+    return false;
+  }
   
-  // get sweight maps from SPlotFit2
-  sweighted_datasets_ = splotfit_.GetSwDataSets();
+  TDirectory* directory_before = gDirectory;
+  TFile cache_file(cache_file_path.c_str(), "READ");
+  TTree* tree_sweights            = dynamic_cast<TTree*>(cache_file.Get("sweights"));
+  RooArgSet* parameters_cached    = dynamic_cast<RooArgSet*>(cache_file.Get("parameters"));
   
-  if (data.numEntries() != interim_tree_->GetEntries()) {
-    doocore::io::serr << "Number of entries in interim tree and sweighted datasets mismatch!" << doocore::io::endmsg;
-    doocore::io::serr << "RooFit dataset contains:    " << data.numEntries() << " entries." << doocore::io::endmsg;;
-    doocore::io::serr << "Tree contains:              " << interim_tree_->GetEntries() << " entries." << doocore::io::endmsg;;
-    
-    throw 314;
+  if (tree_sweights == NULL || parameters_cached == NULL || tree_sweights->GetEntries() != interim_tree_->GetEntries()) {
+    swarn << "SPlotterReducer::ReadCache(...): Cache file " << cache_file_path << " is invalid or does not match interim tree. Will fit again." << endmsg;
+    delete parameters_cached;
+    cache_file.Close();
+    directory_before->cd();
+    return false;
+  }
+  
+  TObjArray* branches               = tree_sweights->GetListOfBranches();
+  const unsigned int num_components = branches->GetEntries();
+  const Long64_t num_entries        = tree_sweights->GetEntries();
+  std::vector<Double_t> values(num_components);
+  
+  sweight_components_.clear();
+  for (unsigned int c=0; c<num_components; ++c) {
+    sweight_components_.push_back((*branches)[c]->GetName());
+    tree_sweights->SetBranchAddress((*branches)[c]->GetName(), &values[c]);
   }
+  
+  sweights_.resize(static_cast<size_t>(num_entries)*num_components);
+  for (Long64_t i=0; i<num_entries; ++i) {
+    tree_sweights->GetEntry(i);
+    std::copy(values.begin(), values.end(), sweights_.begin()+static_cast<size_t>(i)*num_components);
+  }
+  
+  // restore fitted parameters so that the PDF is in the same state as after a fit
+  RooArgSet* parameters = splotfit_.pdf().getParameters(observables_);
+  TIterator* it_parameters = parameters->createIterator();
+  RooRealVar* parameter = NULL;
+  while ((parameter = dynamic_cast<RooRealVar*>(it_parameters->Next()))) {
+    RooRealVar* parameter_cached = dynamic_cast<RooRealVar*>(parameters_cached->find(parameter->GetName()));
+    if (parameter_cached != NULL) {
+      parameter->setVal(parameter_cached->getVal());
+      parameter->setError(parameter_cached->getError());
+    }
+  }
+  delete it_parameters;
+  delete parameters;
+  delete parameters_cached;
+  
+  cache_file.Close();
+  directory_before->cd();
+  return true;
+}
 
-  for (std::map<std::string,RooDataSet*>::const_iterator it = sweighted_datasets_.begin();
-       it != sweighted_datasets_.end(); ++it) {
-    doocore::io::sinfo << "SPlotterReducer::CreateSpecialBranches(): Creating leaf for sweights " << (*it).first+"_sw" << doocore::io::endmsg;
-    sweight_leaves_[(*it).first] = &CreateDoubleLeaf((*it).first+"_sw", -1000);
+void SPlotterReducer::WriteCache(const std::string& cache_file_path) const {
+  boost::filesystem::create_directories(cache_directory_);
+  
+  TDirectory* directory_before = gDirectory;
+  TFile cache_file(cache_file_path.c_str(), "RECREATE");
+  if (!cache_file.IsOpen()) {
+    swarn << "SPlotterReducer::WriteCache(...): Cannot open cache file " << cache_file_path << ". Fit result will not be cached." << endmsg;
+    directory_before->cd();
+    return;
   }
+  
+  const unsigned int num_components = sweight_components_.size();
+  std::vector<Double_t> values(num_components);
+  
+  // tree is owned and deleted by the cache file
+  TTree* tree_sweights = new TTree("sweights", "sweights");
+  for (unsigned int c=0; c<num_components; ++c) {
+    tree_sweights->Branch(sweight_components_[c].c_str(), &values[c], (sweight_components_[c]+"/D").c_str());
+  }
+  
+  const size_t num_entries = num_components > 0 ? sweights_.size()/num_components : 0;
+  for (size_t i=0; i<num_entries; ++i) {
+    std::copy(sweights_.begin()+i*num_components, sweights_.begin()+(i+1)*num_components, values.begin());
+    tree_sweights->Fill();
+  }
+  tree_sweights->Write();
+  
+  RooArgSet* parameters          = splotfit_.pdf().getParameters(observables_);
+  RooAbsCollection* parameters_snapshot = parameters->snapshot();
+  cache_file.WriteTObject(parameters_snapshot, "parameters");
+  delete parameters_snapshot;
+  delete parameters;
+  
+  cache_file.Close();
+  directory_before->cd();
+  sinfo << "SPlotterReducer::WriteCache(...): Fit result and sweights cached in " << cache_file_path << endmsg;
 }
 
 void SPlotterReducer::UpdateSpecialLeaves() {
-  for (std::map<std::string,RooDataSet*>::const_iterator it = sweighted_datasets_.begin(), end = sweighted_datasets_.end();
-       it != end; ++it) {
-    (*it).second->get(selected_entry_);
-    *sweight_leaves_[(*it).first] = (*it).second->weight();
+  const unsigned int num_components = sweight_leaves_.size();
+  
+  // the event loop might load one entry past the end of the interim tree
+  if (num_components == 0 || static_cast<size_t>(selected_entry_)*num_components >= sweights_.size()) return;
+  
+  const Double_t* sweights_entry    = &sweights_[static_cast<size_t>(selected_entry_)*num_components];
+  for (unsigned int c=0; c<num_components; ++c) {
+    *sweight_leaves_[c] = sweights_entry[c];
   }
 }
 } // namespace reducer
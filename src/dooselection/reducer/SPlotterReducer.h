@@ -4,6 +4,7 @@
 // from STL
 #include <map>
 #include <string>
+#include <vector>
 
 // from ROOT
 
@@ -44,10 +45,22 @@ class RooDataSet;
  *  spr.set_output_file_path("test.root");
  *  spr.set_output_tree_path("Bd2JpsiKS");
  *  spr.set_cut_string("B0_BKGCAT==20");
+ *  spr.set_num_cpu(8);
+ *  spr.set_cache_directory("SPlotterReducerCache");
  *  spr.Initialize();
  *  spr.Run();
  *  spr.Finalize();
  *  @endcode
+ *
+ *  @section splotred_cache Fit result cache
+ *
+ *  If a cache directory is set, fitted parameters and the resulting sweights
+ *  are stored in a ROOT file in this directory. The file name is a hash of 
+ *  the input file (including its size and modification time), input tree, 
+ *  cut string, observables, the PDF definition with its start parameters 
+ *  and the external fit arguments (see set_fit_args()).
+ *  A subsequent run with identical data and model will read the sweights 
+ *  from this file and skip conversion, fit and plotting completely.
  **/
 namespace dooselection {
 namespace reducer {
@@ -84,12 +97,49 @@ class SPlotterReducer : virtual public Reducer {
    */
   void set_fit_args(RooLinkedList* ext_fit_args = NULL) {ext_fit_args_ = ext_fit_args;}
   
+  /**
+   *  @brief Set number of CPUs for parallel likelihood evaluation
+   *
+   *  @param num_cpu number of CPUs to use in the fit (default: -1, i.e. keep 
+   *                 the setting of the associated SPlotFit2 object)
+   */
+  void set_num_cpu(int num_cpu) {num_cpu_ = num_cpu;}
+  
+  /**
+   *  @brief Set directory for cached fit results and sweights
+   *
+   *  @param cache_directory cache directory (default: empty, i.e. no caching)
+   */
+  void set_cache_directory(const std::string& cache_directory) {cache_directory_ = cache_directory;}
+  
  protected:
   virtual void ProcessInputTree();
   virtual void UpdateSpecialLeaves();
   virtual void CreateSpecialBranches();
   
  private:
+  /**
+   *  @brief Compute hash of input data and model for the fit result cache
+   *
+   *  @return hash as hexadecimal string
+   */
+  std::string CacheKey() const;
+  
+  /**
+   *  @brief Read fit result and sweights from cache file
+   *
+   *  @param cache_file_path path of the cache file
+   *  @return whether a valid cache entry was read
+   */
+  bool ReadCache(const std::string& cache_file_path);
+  
+  /**
+   *  @brief Write fit result and sweights into cache file
+   *
+   *  @param cache_file_path path of the cache file
+   */
+  void WriteCache(const std::string& cache_file_path) const;
+  
   /**
    *  @brief Associated SPlotFit2 object
    */
@@ -101,14 +151,22 @@ class SPlotterReducer : virtual public Reducer {
   RooArgSet observables_;
   
   /**
-   *  @brief Map of sweighted datasets
+   *  @brief Names of sweighted components
+   */
+  std::vector<std::string> sweight_components_;
+  
+  /**
+   *  @brief Leaves for sweights (one per sweighted component)
    */
-  std::map<std::string,RooDataSet*> sweighted_datasets_;
+  std::vector<ReducerLeaf<Double_t>*> sweight_leaves_;
   
   /**
-   *  @brief Map of leaves for sweights
+   *  @brief Extracted sweights indexed by interim tree entry
+   *
+   *  The sweights of entry i are stored contiguously at 
+   *  sweights_[i*sweight_leaves_.size()+c] for component c.
    */
-  std::map<std::string,ReducerLeaf<Double_t>*> sweight_leaves_;
+  std::vector<Double_t> sweights_;
   
   /**
    *  @brief Components to plot for doofit::plotting::Plot
@@ -124,6 +182,16 @@ class SPlotterReducer : virtual public Reducer {
    *  @brief External fitting arguments
    */
   RooLinkedList* ext_fit_args_;
+  
+  /**
+   *  @brief Number of CPUs for parallel likelihood evaluation
+   */
+  int num_cpu_;
+  
+  /**
+   *  @brief Directory for cached fit results and sweights
+   */
+  std::string cache_directory_;
 };
 } // namespace reducer
 } // namespace dooselection
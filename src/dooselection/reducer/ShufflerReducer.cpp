@@ -1,6 +1,7 @@
 #include "ShufflerReducer.h"
 
 // from STL
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -20,6 +21,21 @@ int ShufflerReducer::RegisterShuffler() {
   return shufflers_.size()-1;
 }
 
+void ShufflerReducer::SetRandomKeyLeaves(std::uint64_t seed, const ReducerLeaf<Float_t>* run_leaf,
+                                         const ReducerLeaf<Float_t>* event_leaf,
+                                         const ReducerLeaf<Float_t>* candidate_leaf) {
+  counter_random_ = CounterRandom(seed);
+  random_key_leaves_.clear();
+  random_key_leaves_.push_back(run_leaf);
+  random_key_leaves_.push_back(event_leaf);
+  if (candidate_leaf != NULL) {
+    random_key_leaves_.push_back(candidate_leaf);
+    sinfo << "Shufflers draw random orders per (" << run_leaf->name() << ", " << event_leaf->name() << ", " << candidate_leaf->name() << ")" << endmsg;
+  } else {
+    sinfo << "Shufflers draw random orders per (" << run_leaf->name() << ", " << event_leaf->name() << ")" << endmsg;
+  }
+}
+
 void ShufflerReducer::SetShuffleLeaves(std::size_t shuffler_idx, ReducerLeaf<Float_t>* new_leaf1, ReducerLeaf<Float_t>* new_leaf2,
                       const ReducerLeaf<Float_t>* base_leaf1, const ReducerLeaf<Float_t>* base_leaf2) {
   if (shuffler_idx >= shufflers_.size()) {
@@ -76,9 +92,29 @@ void ShufflerReducer::SetShuffleLeaves(std::size_t shuffler_idx, ReducerLeaf<Flo
   }
 }
 
+void ShufflerReducer::PrepareSpecialBranches() {
+  // the key leaves are no dependencies of any new leaf, with branches to keep
+  // they would be deactivated and every entry would get the same order
+  for (ConstLeafPtrVec::const_iterator it = random_key_leaves_.begin(); it != random_key_leaves_.end(); ++it) {
+    if (input_tree_->GetLeaf((*it)->name()) != NULL) {
+      input_tree_->SetBranchStatus((*it)->name(), 1);
+    }
+  }
+}
+
 void ShufflerReducer::UpdateSpecialLeaves() {
 //  int i = 0;
   
+  const bool counter_based = !random_key_leaves_.empty();
+  std::uint64_t entry_key = 0;
+  if (counter_based) {
+    // read in the leaves' own types, GetValue() would round to Float_t
+    const std::int64_t candidate = random_key_leaves_.size() > 2 ? IntegerLeafValue(random_key_leaves_[2]->branch_address(), random_key_leaves_[2]->l_type()) : 0;
+    entry_key = CounterRandom::EntryKey(IntegerLeafValue(random_key_leaves_[0]->branch_address(), random_key_leaves_[0]->l_type()),
+                                        IntegerLeafValue(random_key_leaves_[1]->branch_address(), random_key_leaves_[1]->l_type()),
+                                        candidate);
+  }
+
   for (std::vector<std::pair<int, ShuffleLeafVec> >::iterator it_shuffler = shufflers_.begin();
        it_shuffler != shufflers_.end(); ++it_shuffler) {
     int num_shuffle_elements      = it_shuffler->first;
@@ -90,7 +126,11 @@ void ShufflerReducer::UpdateSpecialLeaves() {
       new_order[0] = 0;
       int j;
       for (int i=1; i<num_shuffle_elements; ++i) {
-        j = r_.Integer(i+1);
+        if (counter_based) {
+          j = counter_random_.Integer(i+1, entry_key, it_shuffler-shufflers_.begin(), i-1);
+        } else {
+          j = r_.Integer(i+1);
+        }
         new_order[i] = new_order[j];
         new_order[j] = i;
       }
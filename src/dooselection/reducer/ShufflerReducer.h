@@ -2,6 +2,7 @@
 #define DOOSELECTION_REDUCER_SHUFFLERREDUCER_H
 
 // from STL
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -10,6 +11,7 @@
 
 // from project
 #include "Reducer.h"
+#include "CounterRandom.h"
 
 /** @class dooselection::reducer::ShufflerReducer
  *  @brief Derived Reducer to shuffle given leaves into new leaves
@@ -33,6 +35,12 @@
  *  generate a new random order for both base variable sets so that the 
  *  shuffling of pi1 and pi2 will be the same for both sets. The second shuffler
  *  is independent and will generate an own sequence.
+ *
+ *  By default, the orders are drawn from a TRandom3 sequence and depend on the
+ *  order in which entries are processed. After SetRandomKeyLeaves() the 
+ *  orders are drawn from a counter-based generator keyed by run and event 
+ *  number (and candidate index) instead, so that each candidate is shuffled 
+ *  identically however the input is ordered or split.
  **/
 
 namespace dooselection {
@@ -49,6 +57,22 @@ public:
    *  @return index of this shuffler
    */
   int RegisterShuffler();
+
+  /**
+   *  @brief Draw orders reproducibly per candidate
+   *
+   *  The order of each shuffler is drawn from a counter-based random generator
+   *  keyed by the values of the given leaves of the current entry and the 
+   *  index of the shuffler.
+   *
+   *  @param seed seed of the counter-based generator
+   *  @param run_leaf leaf with the run number
+   *  @param event_leaf leaf with the event number
+   *  @param candidate_leaf leaf with the index of the candidate in the event (optional)
+   */
+  void SetRandomKeyLeaves(std::uint64_t seed, const ReducerLeaf<Float_t>* run_leaf,
+                          const ReducerLeaf<Float_t>* event_leaf,
+                          const ReducerLeaf<Float_t>* candidate_leaf=NULL);
   
   /**
    *  @brief Set leaves to shuffle two elements
@@ -90,6 +114,7 @@ public:
                         const ReducerLeaf<Float_t>* base_leaf3);
   
 protected:
+  virtual void PrepareSpecialBranches();
   virtual void UpdateSpecialLeaves();
   
 private:
@@ -101,6 +126,14 @@ private:
    * @brief Internal random number generator.
    */
   TRandom3 r_;
+  /**
+   * @brief Counter-based random generator (used if random_key_leaves_ is set).
+   */
+  CounterRandom counter_random_;
+  /**
+   * @brief Leaves with run number, event number and candidate index.
+   */
+  ConstLeafPtrVec random_key_leaves_;
 };
 
 } // namespace reducer
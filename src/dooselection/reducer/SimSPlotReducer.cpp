@@ -1,5 +1,8 @@
 #include "SimSPlotReducer.h"
 
+// from STL
+#include <utility>
+
 // from Boost
 //#include <boost/assign/std/vector.hpp>
 
@@ -15,13 +18,33 @@ using namespace doocore::io;
 namespace dooselection {
 namespace reducer {
 
-SimSPlotReducer::SimSPlotReducer(RooDataSet data_bkg_sw, RooDataSet data_sig_sw) :
-  data_bkg_sw_(data_bkg_sw),
-  data_sig_sw_(data_sig_sw)
+SimSPlotReducer::SimSPlotReducer(const RooDataSet& data_bkg_sw, const RooDataSet& data_sig_sw) :
+  sweights_bkg_(ExtractWeights(data_bkg_sw)),
+  sweights_sig_(ExtractWeights(data_sig_sw)),
+  sweight_leaf_bkg_(NULL),
+  sweight_leaf_sig_(NULL)
+{
+  set_old_style_interim_tree(true);
+}
+
+SimSPlotReducer::SimSPlotReducer(std::vector<Double_t> sweights_bkg, std::vector<Double_t> sweights_sig) :
+  sweights_bkg_(std::move(sweights_bkg)),
+  sweights_sig_(std::move(sweights_sig)),
+  sweight_leaf_bkg_(NULL),
+  sweight_leaf_sig_(NULL)
 {
   set_old_style_interim_tree(true);
 }
   
+std::vector<Double_t> SimSPlotReducer::ExtractWeights(const RooDataSet& data) {
+  std::vector<Double_t> sweights(data.numEntries());
+  for (int i=0; i<data.numEntries(); ++i) {
+    data.get(i);
+    sweights[i] = data.weight();
+  }
+  return sweights;
+}
+  
 void SimSPlotReducer::ProcessInputTree() {
 //  swarn << "SimSPlotReducer::ProcessInputTree(): cut string: " << cut_string() << endmsg;
 }
@@ -35,31 +58,31 @@ void SimSPlotReducer::CreateSpecialBranches() {
 
   interim_tree_->SetBranchStatus("*", 1);
     
-  if (data_bkg_sw_.numEntries() != interim_tree_->GetEntries()) {
+  if (sweights_bkg_.size() != static_cast<size_t>(interim_tree_->GetEntries())) {
     doocore::io::serr << "Number of entries in interim tree and sweighted background dataset mismatch!" << doocore::io::endmsg;
-    doocore::io::serr << "Background dataset contains:    " << data_bkg_sw_.numEntries() << " entries." << doocore::io::endmsg;;
+    doocore::io::serr << "Background dataset contains:    " << sweights_bkg_.size() << " entries." << doocore::io::endmsg;;
     doocore::io::serr << "Tree contains:              " << interim_tree_->GetEntries() << " entries." << doocore::io::endmsg;;
   }
   
-  if (data_sig_sw_.numEntries() != interim_tree_->GetEntries()) {
+  if (sweights_sig_.size() != static_cast<size_t>(interim_tree_->GetEntries())) {
     doocore::io::serr << "Number of entries in interim tree and sweighted signal dataset mismatch!" << doocore::io::endmsg;
-    doocore::io::serr << "Signal dataset contains:    " << data_sig_sw_.numEntries() << " entries." << doocore::io::endmsg;;
+    doocore::io::serr << "Signal dataset contains:    " << sweights_sig_.size() << " entries." << doocore::io::endmsg;;
     doocore::io::serr << "Tree contains:              " << interim_tree_->GetEntries() << " entries." << doocore::io::endmsg;;
   }
   
   doocore::io::sinfo << "SimSPlotReducer::CreateSpecialBranches(): Creating leaf for sweight " << "BkgYield_sw" << doocore::io::endmsg;
-  sweight_leaves_["Bkg"] = &CreateDoubleLeaf("BkgYield_sw", -1000);
+  sweight_leaf_bkg_ = &CreateDoubleLeaf("BkgYield_sw", -1000);
   doocore::io::sinfo << "SimSPlotReducer::CreateSpecialBranches(): Creating leaf for sweight " << "SigYield_sw" << doocore::io::endmsg;
-  sweight_leaves_["Sig"] = &CreateDoubleLeaf("SigYield_sw", -1000);
+  sweight_leaf_sig_ = &CreateDoubleLeaf("SigYield_sw", -1000);
 }
 
 void SimSPlotReducer::UpdateSpecialLeaves() {
-  //const RooArgSet* sweighted_values_bkg =
-  data_bkg_sw_.get(selected_entry_);
-  *sweight_leaves_["Bkg"] = data_bkg_sw_.weight();
-  //const RooArgSet* sweighted_values_sig =
-  data_sig_sw_.get(selected_entry_);
-  *sweight_leaves_["Sig"] = data_sig_sw_.weight();
+  if (selected_entry_ < sweights_bkg_.size()) {
+    *sweight_leaf_bkg_ = sweights_bkg_[selected_entry_];
+  }
+  if (selected_entry_ < sweights_sig_.size()) {
+    *sweight_leaf_sig_ = sweights_sig_[selected_entry_];
+  }
 }
 } // namespace reducer
 } // namespace dooselection
@@ -2,14 +2,11 @@
 #define DOOSELECTION_REDUCER_SIMSPLOTREDUCER_H
 
 // from STL
-#include <map>
 #include <string>
+#include <vector>
 
 // from ROOT
 
-// from RooFit
-#include "RooDataSet.h"
-
 // from DooCore
 #include "doocore/io/MsgStream.h"
 
@@ -23,7 +20,9 @@ class RooDataSet;
  *  @brief Derived Reducer to write sweights into the output tuple
  *
  *  This is a Reducer derived from Reducer. It can be used to write sweights 
- *  into the output tuple.
+ *  into the output tuple. The sweights are extracted from the supplied 
+ *  datasets once at construction and stored per interim tree entry, so the 
+ *  datasets themselves are neither copied nor needed afterwards.
  *
  *  @section splotred_usage Usage
  *
@@ -49,12 +48,24 @@ class SimSPlotReducer : virtual public Reducer {
   /**
    *  @brief Constructor
    *
-   *  Constructor based on datasets with sweights calculated before.
+   *  Constructor based on datasets with sweights calculated before. Only the
+   *  weights are read from the datasets, which are not copied.
    *
    *  @param data_bkg_sw RooDataSet with background weights
    *  @param data_sig_sw RooDataSet with signal weights
    */
-  SimSPlotReducer(RooDataSet data_bkg_sw, RooDataSet data_sig_sw);
+  SimSPlotReducer(const RooDataSet& data_bkg_sw, const RooDataSet& data_sig_sw);
+  
+  /**
+   *  @brief Constructor
+   *
+   *  Constructor based on sweights calculated before, indexed by interim tree
+   *  entry. Pass via std::move() to avoid copying.
+   *
+   *  @param sweights_bkg background weights
+   *  @param sweights_sig signal weights
+   */
+  SimSPlotReducer(std::vector<Double_t> sweights_bkg, std::vector<Double_t> sweights_sig);
 
  protected:
   virtual void ProcessInputTree();
@@ -63,20 +74,32 @@ class SimSPlotReducer : virtual public Reducer {
   
  private:
   /**
-   *  @brief RooDataSet with background weights
+   *  @brief Extract sweights of a dataset into a plain array
+   *
+   *  @param data RooDataSet with weights
+   *  @return weights indexed by dataset entry
+   */
+  static std::vector<Double_t> ExtractWeights(const RooDataSet& data);
+  
+  /**
+   *  @brief Background weights indexed by interim tree entry
    */
-  RooDataSet data_bkg_sw_;
+  std::vector<Double_t> sweights_bkg_;
   
   /**
-   *  @brief RooDataSet with signal weights
+   *  @brief Signal weights indexed by interim tree entry
    */
-  RooDataSet data_sig_sw_;
+  std::vector<Double_t> sweights_sig_;
   
   /**
-   *  @brief Map of leaves for sweights
+   *  @brief Leaf for background sweights
    */
-  std::map<std::string,ReducerLeaf<Double_t>*> sweight_leaves_;
+  ReducerLeaf<Double_t>* sweight_leaf_bkg_;
   
+  /**
+   *  @brief Leaf for signal sweights
+   */
+  ReducerLeaf<Double_t>* sweight_leaf_sig_;
 };
 } // namespace reducer
 } // namespace dooselection
@@ -1 +1,421 @@
 #include "TMVAClassificationReducer.h"
+
+// from STL
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+// from ROOT
+#include "TROOT.h"
+#include "RVersion.h"
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+#include <doocore/io/Progress.h>
+
+namespace dooselection {
+namespace reducer {
+
+using namespace doocore::io;
+
+TMVAClassificationReducer::TMVAClassificationReducer() :
+  fold_leaf_(NULL),
+  fold_leaf_interim_(false),
+  validation_reader_(NULL),
+  batched_(false),
+  num_threads_(1),
+  batch_size_(10000),
+  use_native_bdt_(false),
+  native_bdt_validation_(0)
+{}
+
+TMVAClassificationReducer::~TMVAClassificationReducer() {
+  for (std::vector<TMVA::Reader*>::const_iterator it = readers_.begin(); it != readers_.end(); ++it) {
+    delete *it;
+  }
+  delete validation_reader_;
+  for (std::vector<TMVAMethod>::const_iterator it = methods_.begin(); it != methods_.end(); ++it) {
+    for (std::vector<BDTForest*>::const_iterator it_forest = (*it).forests.begin(); it_forest != (*it).forests.end(); ++it_forest) {
+      delete *it_forest;
+    }
+  }
+  for (std::vector<TMVAVariable>::const_iterator it = variables_.begin(); it != variables_.end(); ++it) {
+    delete (*it).leaf;
+  }
+  delete fold_leaf_;
+}
+
+void TMVAClassificationReducer::AddTMVAMethod(const std::string& tmva_method, const std::string& tmva_xml_file) {
+  AddTMVAKFoldMethod(tmva_method, std::vector<std::string>(1, tmva_xml_file));
+}
+
+void TMVAClassificationReducer::AddTMVAKFoldMethod(const std::string& tmva_method, const std::vector<std::string>& tmva_xml_files) {
+  if (tmva_xml_files.empty()) {
+    serr << "TMVAClassificationReducer::AddTMVAKFoldMethod(...): No XML files given for method " << tmva_method << endmsg;
+    throw 1;
+  }
+
+  TMVAMethod method;
+  method.name            = tmva_method;
+  method.xml_files       = tmva_xml_files;
+  method.forests.assign(tmva_xml_files.size(), NULL);
+  method.classifier_leaf = NULL;
+
+  // each fold is booked under its own tag in the readers
+  if (tmva_xml_files.size() == 1) {
+    method.tags.push_back(tmva_method);
+  } else {
+    for (unsigned int f=0; f<tmva_xml_files.size(); ++f) {
+      std::stringstream tag;
+      tag << tmva_method << "_fold" << f;
+      method.tags.push_back(tag.str());
+    }
+  }
+  methods_.push_back(method);
+}
+
+void TMVAClassificationReducer::SetTMVAMethodsAndXMLFiles(const std::vector<std::string> & tmva_methods, const std::vector<std::string> & tmva_xml_files) {
+  if (tmva_methods.size() != tmva_xml_files.size()) {
+    serr << "TMVAClassificationReducer::SetTMVAMethodsAndXMLFiles(...): Number of methods and XML files differs." << endmsg;
+    throw 1;
+  }
+  for (unsigned int i=0; i<tmva_methods.size(); ++i) {
+    AddTMVAMethod(tmva_methods.at(i), tmva_xml_files.at(i));
+  }
+}
+
+bool TMVAClassificationReducer::IsInterimAddress(void* address) {
+  for (std::vector<ReducerLeaf<Float_t>* >::const_iterator it = GetInterimLeavesBegin(); it != GetInterimLeavesEnd(); ++it) {
+    if ((*it)->branch_address() == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TMVAClassificationReducer::AddVariable(const std::string& var_name, const TString& leaf_name, const TString& leaf_type, void* address, bool spectator) {
+  TMVAVariable variable;
+  variable.name      = var_name;
+  variable.spectator = spectator;
+
+  // generic leaf reading the value via the given address, casting from the
+  // leaf's type to Float_t as TMVA expects
+  variable.leaf = new ReducerLeaf<Float_t>(leaf_name, leaf_name, leaf_type, interim_tree_);
+  variable.leaf->set_branch_address(address);
+
+  // the value can only be read outside of the event loop if it is filled by
+  // the interim tree itself
+  variable.interim = IsInterimAddress(address);
+
+  variables_.push_back(variable);
+}
+
+void TMVAClassificationReducer::SetFoldLeaf(const TString& leaf_name, const TString& leaf_type, void* address) {
+  delete fold_leaf_;
+  fold_leaf_ = new ReducerLeaf<Long64_t>(leaf_name, leaf_name, leaf_type, interim_tree_);
+  fold_leaf_->set_branch_address(address);
+  fold_leaf_interim_ = IsInterimAddress(address);
+}
+
+Long64_t TMVAClassificationReducer::GetFoldKey() const {
+  return fold_leaf_ != NULL ? fold_leaf_->GetValue() : 0;
+}
+
+TMVA::Reader* TMVAClassificationReducer::CreateReader(std::vector<Float_t>& features, bool native) const {
+  TMVA::Reader* reader = new TMVA::Reader("!Color:Silent");
+
+  for (unsigned int v=0; v<variables_.size(); ++v) {
+    if (variables_[v].spectator) {
+      reader->AddSpectator(variables_[v].name, &features[v]);
+    } else {
+      reader->AddVariable(variables_[v].name, &features[v]);
+    }
+  }
+  for (std::vector<TMVAMethod>::const_iterator it = methods_.begin(); it != methods_.end(); ++it) {
+    for (unsigned int f=0; f<(*it).xml_files.size(); ++f) {
+      if (((*it).forests[f] != NULL) == native) {
+        reader->BookMVA((*it).tags[f], (*it).xml_files[f]);
+      }
+    }
+  }
+  return reader;
+}
+
+void TMVAClassificationReducer::CreateForests() {
+  // columns of the input variables in the feature buffers, TMVA::Reader
+  // expects them in the order of the weight file
+  std::vector<int> columns;
+  std::vector<std::string> names;
+  for (unsigned int v=0; v<variables_.size(); ++v) {
+    if (!variables_[v].spectator) {
+      columns.push_back(v);
+      names.push_back(variables_[v].name);
+    }
+  }
+
+  for (std::vector<TMVAMethod>::iterator it = methods_.begin(); it != methods_.end(); ++it) {
+    for (unsigned int f=0; f<(*it).xml_files.size(); ++f) {
+      BDTForest* forest = NULL;
+      try {
+        forest = new BDTForest((*it).xml_files[f]);
+      } catch (int) {
+        swarn << "TMVAClassificationReducer::CreateForests(): Cannot evaluate method " << (*it).tags[f] << " natively. Using TMVA::Reader." << endmsg;
+        continue;
+      }
+
+      if (forest->variables() != names) {
+        swarn << "TMVAClassificationReducer::CreateForests(): Variables of method " << (*it).tags[f] << " do not match the TMVA variables set. Using TMVA::Reader." << endmsg;
+        delete forest;
+        continue;
+      }
+      forest->SetFeatureColumns(columns);
+      (*it).forests[f] = forest;
+      sinfo << "TMVAClassificationReducer::CreateForests(): Evaluating method " << (*it).tags[f] << " natively (" << forest->num_trees() << " trees)." << endmsg;
+    }
+  }
+}
+
+void TMVAClassificationReducer::ValidateNative(const Double_t* values, Long64_t fold_key) const {
+  for (size_t m=0; m<methods_.size(); ++m) {
+    const unsigned int f = methods_[m].Fold(fold_key);
+    if (methods_[m].forests[f] == NULL) continue;
+
+    // results have to agree bit by bit
+    const Double_t value_tmva = validation_reader_->EvaluateMVA(methods_[m].tags[f]);
+    if (std::memcmp(&value_tmva, &values[m], sizeof(Double_t)) != 0) {
+      serr << "TMVAClassificationReducer::ValidateNative(...): Native evaluation of method " << methods_[m].tags[f] << " differs from TMVA::Reader: " << values[m] << " (native) vs. " << value_tmva << " (TMVA)." << endmsg;
+      serr << "TMVAClassificationReducer::ValidateNative(...): Features are:";
+      for (unsigned int v=0; v<variables_.size(); ++v) {
+        serr << " " << variables_[v].name << "=" << features_[0][v];
+      }
+      serr << endmsg;
+      throw 2;
+    }
+  }
+}
+
+void TMVAClassificationReducer::GatherFeatures(Float_t* features) const {
+  for (unsigned int v=0; v<variables_.size(); ++v) {
+    features[v] = variables_[v].leaf->GetValue();
+  }
+}
+
+void TMVAClassificationReducer::ActivateInputBranches() {
+  std::vector<TString> names;
+  for (std::vector<TMVAVariable>::const_iterator it = variables_.begin(); it != variables_.end(); ++it) {
+    names.push_back((*it).leaf->name());
+  }
+  if (fold_leaf_ != NULL) {
+    names.push_back(fold_leaf_->name());
+  }
+  for (std::vector<TString>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    if (input_tree_->GetLeaf(*it) != NULL) {
+      input_tree_->SetBranchStatus(*it, 1);
+    }
+  }
+}
+
+void TMVAClassificationReducer::CreateSpecialBranches() {
+  if (methods_.size() > 0) {
+    sinfo << "TMVA weights are set. Creating BDT classifier." << endmsg;
+  }
+  for (std::vector<TMVAMethod>::iterator it = methods_.begin(); it != methods_.end(); ++it) {
+    (*it).classifier_leaf = &(CreateDoubleLeaf((*it).name+"_classifier", (*it).name+"_classifier", "Double_t"));
+  }
+}
+
+void TMVAClassificationReducer::PrepareSpecialBranches() {
+  if (methods_.empty()) return;
+
+  ActivateInputBranches();
+
+  for (std::vector<TMVAMethod>::const_iterator it = methods_.begin(); it != methods_.end(); ++it) {
+    if ((*it).xml_files.size() > 1) {
+      if (fold_leaf_ == NULL) {
+        serr << "TMVAClassificationReducer::PrepareSpecialBranches(): Method " << (*it).name << " uses " << (*it).xml_files.size() << " folds, but no fold leaf is set." << endmsg;
+        throw 3;
+      }
+      sinfo << "TMVAClassificationReducer::PrepareSpecialBranches(): Applying method " << (*it).name << " in " << (*it).xml_files.size() << " folds based on " << fold_leaf_->name() << " % " << (*it).xml_files.size() << "." << endmsg;
+    }
+  }
+
+  bool all_interim = fold_leaf_ == NULL || fold_leaf_interim_;
+  if (!all_interim) {
+    swarn << "TMVAClassificationReducer::PrepareSpecialBranches(): Fold leaf " << fold_leaf_->name() << " is not an interim tree leaf. Classifiers will be evaluated per entry in the event loop." << endmsg;
+  }
+  for (std::vector<TMVAVariable>::const_iterator it = variables_.begin(); it != variables_.end() && all_interim; ++it) {
+    if (!(*it).interim) {
+      swarn << "TMVAClassificationReducer::PrepareSpecialBranches(): Variable " << (*it).name << " is not an interim tree leaf. Classifiers will be evaluated per entry in the event loop." << endmsg;
+      all_interim = false;
+    }
+  }
+
+  if (use_native_bdt_) {
+    CreateForests();
+  }
+
+  unsigned int num_readers = all_interim ? num_threads_ : 1;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+  if (num_readers > 1) {
+    ROOT::EnableThreadSafety();
+  }
+#endif
+
+  // booking is not thread-safe, all readers are created in this thread
+  features_.assign(num_readers, std::vector<Float_t>(variables_.size()));
+  for (unsigned int r=0; r<num_readers; ++r) {
+    readers_.push_back(CreateReader(features_[r]));
+  }
+  if (native_bdt_validation_ > 0) {
+    validation_reader_ = CreateReader(features_[0], true);
+  }
+
+  if (all_interim) {
+    EvaluateBatched();
+
+    if (native_bdt_validation_ > 0) {
+      const Long64_t num_validate = std::min(static_cast<Long64_t>(native_bdt_validation_), static_cast<Long64_t>(classifier_values_.size()/methods_.size()));
+      for (Long64_t i=0; i<num_validate; ++i) {
+        interim_tree_->GetEntry(i);
+        LoadTreeFriendsEntryHook(i);
+        GatherFeatures(features_[0].data());
+        ValidateNative(&classifier_values_[i*methods_.size()], GetFoldKey());
+      }
+      sinfo << "TMVAClassificationReducer::PrepareSpecialBranches(): Native BDT evaluation agrees with TMVA::Reader for " << num_validate << " entries." << endmsg;
+    }
+  }
+}
+
+void TMVAClassificationReducer::EvaluateBatched() {
+  Long64_t num_entries = interim_tree_->GetEntries();
+  if (num_events_process() != -1 && num_events_process() < num_entries) {
+    num_entries = num_events_process();
+  }
+
+  const size_t num_methods   = methods_.size();
+  const size_t num_variables = variables_.size();
+  const size_t num_readers   = readers_.size();
+
+  sinfo << "TMVAClassificationReducer::EvaluateBatched(): Evaluating " << num_methods << " classifiers for " << num_entries << " entries in blocks of " << batch_size_ << " entries using " << num_readers << " threads." << endmsg;
+
+  classifier_values_.assign(static_cast<size_t>(num_entries)*num_methods, 0.0);
+  std::vector<Float_t> block(static_cast<size_t>(batch_size_)*num_variables);
+  std::vector<Long64_t> block_fold_keys(batch_size_);
+  forest_buffers_.resize(num_readers);
+
+  Progress p("Evaluating TMVA classifiers", num_entries);
+  for (Long64_t block_start=0; block_start<num_entries; block_start+=batch_size_) {
+    const Long64_t block_entries = std::min(static_cast<Long64_t>(batch_size_), num_entries-block_start);
+
+    // reading the tree is sequential
+    for (Long64_t row=0; row<block_entries; ++row) {
+      interim_tree_->GetEntry(block_start+row);
+      LoadTreeFriendsEntryHook(block_start+row);
+      GatherFeatures(&block[row*num_variables]);
+      block_fold_keys[row] = GetFoldKey();
+    }
+
+    // evaluation is split over all readers
+    const Long64_t rows_per_reader = (block_entries+num_readers-1)/num_readers;
+    auto evaluate_rows = [&](unsigned int r) {
+      const Long64_t row_begin = r*rows_per_reader;
+      const Long64_t row_end   = std::min(row_begin+rows_per_reader, block_entries);
+      if (row_begin >= row_end) return;
+
+      for (Long64_t row=row_begin; row<row_end; ++row) {
+        std::copy(block.begin()+row*num_variables, block.begin()+(row+1)*num_variables, features_[r].begin());
+        Double_t* values = &classifier_values_[(block_start+row)*num_methods];
+        for (size_t m=0; m<num_methods; ++m) {
+          const unsigned int f = methods_[m].Fold(block_fold_keys[row]);
+          if (methods_[m].forests[f] == NULL) {
+            values[m] = readers_[r]->EvaluateMVA(methods_[m].tags[f]);
+          }
+        }
+      }
+
+      // native forests evaluate all rows of their fold at once
+      std::vector<Double_t> native_values;
+      std::vector<Float_t> fold_block;
+      std::vector<Long64_t> fold_rows;
+      for (size_t m=0; m<num_methods; ++m) {
+        const unsigned int num_folds = methods_[m].forests.size();
+        for (unsigned int f=0; f<num_folds; ++f) {
+          const BDTForest* forest = methods_[m].forests[f];
+          if (forest == NULL) continue;
+
+          fold_rows.clear();
+          if (num_folds == 1) {
+            native_values.resize(row_end-row_begin);
+            forest->Evaluate(&block[row_begin*num_variables], row_end-row_begin, num_variables, native_values.data(), forest_buffers_[r]);
+            for (Long64_t row=row_begin; row<row_end; ++row) {
+              fold_rows.push_back(row);
+            }
+          } else {
+            fold_block.clear();
+            for (Long64_t row=row_begin; row<row_end; ++row) {
+              if (methods_[m].Fold(block_fold_keys[row]) == f) {
+                fold_rows.push_back(row);
+                fold_block.insert(fold_block.end(), block.begin()+row*num_variables, block.begin()+(row+1)*num_variables);
+              }
+            }
+            native_values.resize(fold_rows.size());
+            forest->Evaluate(fold_block.data(), fold_rows.size(), num_variables, native_values.data(), forest_buffers_[r]);
+          }
+
+          for (size_t i=0; i<fold_rows.size(); ++i) {
+            classifier_values_[(block_start+fold_rows[i])*num_methods+m] = native_values[i];
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int r=1; r<num_readers; ++r) {
+      threads.push_back(std::thread(evaluate_rows, r));
+    }
+    evaluate_rows(0);
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it) {
+      (*it).join();
+    }
+
+    p += block_entries;
+  }
+  p.Finish();
+
+  batched_ = true;
+}
+
+void TMVAClassificationReducer::UpdateSpecialLeaves() {
+  const size_t num_methods = methods_.size();
+  if (num_methods == 0 || readers_.empty()) return;
+
+  if (batched_) {
+    // the event loop might load one entry past the end of the interim tree
+    if (static_cast<size_t>(selected_entry_)*num_methods >= classifier_values_.size()) return;
+
+    const Double_t* values = &classifier_values_[static_cast<size_t>(selected_entry_)*num_methods];
+    for (size_t m=0; m<num_methods; ++m) {
+      *methods_[m].classifier_leaf = values[m];
+    }
+  } else {
+    GatherFeatures(features_[0].data());
+    const Long64_t fold_key = GetFoldKey();
+    std::vector<Double_t> values(num_methods);
+    for (size_t m=0; m<num_methods; ++m) {
+      const unsigned int f = methods_[m].Fold(fold_key);
+      if (methods_[m].forests[f] == NULL) {
+        values[m] = readers_[0]->EvaluateMVA(methods_[m].tags[f]);
+      } else {
+        values[m] = methods_[m].forests[f]->Evaluate(features_[0].data());
+      }
+      *methods_[m].classifier_leaf = values[m];
+    }
+    if (validation_reader_ != NULL && selected_entry_ < native_bdt_validation_) {
+      ValidateNative(values.data(), fold_key);
+    }
+  }
+}
+
+} // namespace reducer
+} // namespace dooselection
@@ -2,6 +2,7 @@
 #define DOOSELECTION_REDUCER_TMVACLASSIFICATIONREDUCER_H
 
 // from STL
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -17,12 +18,15 @@
 
 // from project
 #include "Reducer.h"
+#include "BDTForest.h"
 
 /** @class dooselection::reducer::TMVAClassificationReducer
  *  @brief Derived Reducer to write TMVA classification into output tree
  *
  *  This is a Reducer derived from Reducer. It can be used to write TMVA based
- *  classification into the output tuple produced.
+ *  classification into the output tuple produced. An arbitrary number of
+ *  methods can be registered, each one will be written into a leaf
+ *  <method>_classifier.
  *
  *  @section tmvared_usage Usage
  *
@@ -31,185 +35,306 @@
  *  @code
  *  TMVAClassificationReducer AReducer;
  *  AReducer.SetTMVAMethodAndXMLFile("BDT", "myweightfile.xml");
- *  
- *  AReducer.SetTMVAVariable("muminus_PT", (Float_t*)AReducer.GetInterimLeafByName("muminus_PT").branch_address());
- *  AReducer.SetTMVAVariable("muplus_PT", (Float_t*)AReducer.GetInterimLeafByName("muplus_PT").branch_address());
+ *  AReducer.AddTMVAMethod("BDTG", "myotherweightfile.xml");
+ *  AReducer.set_num_threads(8);
+ *
+ *  AReducer.SetTMVAVariable("muminus_PT", AReducer.GetInterimLeafByName("muminus_PT"));
+ *  AReducer.SetTMVAVariable("muplus_PT", AReducer.GetInterimLeafByName("muplus_PT"));
+ *  @endcode
+ *
+ *  @section tmvared_batch Batched evaluation
+ *
+ *  If all TMVA variables are leaves of the interim tree, the classifiers are
+ *  evaluated before the event loop: Blocks of entries are read into a feature
+ *  matrix and each block is split over set_num_threads() threads, each thread
+ *  using its own TMVA::Reader instances. The event loop then only copies the
+ *  precomputed classifier values. If any variable depends on leaves computed
+ *  in the event loop, the classifiers are evaluated per entry instead.
+ *
+ *  @section tmvared_kfold k-fold application
+ *
+ *  Methods trained in k folds are registered with AddTMVAKFoldMethod() and
+ *  one weight file per fold. Each entry is classified with the weight file
+ *  of fold (key % k), where key is the value of the leaf set via
+ *  SetTMVAFoldLeaf() (e.g. eventNumber). All folds write into the same leaf
+ *  <method>_classifier in a single pass.
+ *
+ *  @code
+ *  std::vector<std::string> xml_files;
+ *  xml_files.push_back("fold0_BDTG.weights.xml");
+ *  xml_files.push_back("fold1_BDTG.weights.xml");
+ *  AReducer.AddTMVAKFoldMethod("BDTG", xml_files);
+ *  AReducer.SetTMVAFoldLeaf(AReducer.GetInterimLeafByName("eventNumber"));
  *  @endcode
  *
+ *  @section tmvared_native Native BDT evaluation
+ *
+ *  With set_use_native_bdt(true) BDT methods are evaluated by BDTForest
+ *  instead of TMVA::Reader. Weight files BDTForest cannot handle fall back to
+ *  TMVA::Reader. set_native_bdt_validation(n) additionally evaluates the first
+ *  n entries with TMVA::Reader and throws if any classifier value differs.
+ *
  *  @author Christophe Cauet
  **/
 namespace dooselection {
 namespace reducer {
 class TMVAClassificationReducer : virtual public Reducer {
  public:
+  TMVAClassificationReducer();
+  virtual ~TMVAClassificationReducer();
+
+  /**
+   *  @brief Register a TMVA method and its weight file
+   *
+   *  @param tmva_method name of the method (classifier leaf will be named <tmva_method>_classifier)
+   *  @param tmva_xml_file TMVA weight file
+   */
+  void AddTMVAMethod(const std::string& tmva_method, const std::string& tmva_xml_file);
+
+  /**
+   *  @brief Register a TMVA method trained in k folds
+   *
+   *  @param tmva_method name of the method (classifier leaf will be named <tmva_method>_classifier)
+   *  @param tmva_xml_files TMVA weight files, one per fold (entries with key % k == i use file i)
+   */
+  void AddTMVAKFoldMethod(const std::string& tmva_method, const std::vector<std::string>& tmva_xml_files);
+
   void SetTMVAMethodAndXMLFile(const TString & tmva_method, const TString & tmva_xml_file) {
- 		tmva_method_ 		= tmva_method;
-		tmva_xml_file_ 	= tmva_xml_file;
-	}
-  void SetTMVAMethodsAndXMLFiles(const std::vector<std::string> & tmva_methods, const std::vector<std::string> & tmva_xml_files) {
-    tmva_methods_   = tmva_methods;
-    tmva_xml_files_ = tmva_xml_files;
+    if (tmva_xml_file.Length() > 0) AddTMVAMethod(tmva_method.Data(), tmva_xml_file.Data());
   }
-  
+  void SetTMVAMethodsAndXMLFiles(const std::vector<std::string> & tmva_methods, const std::vector<std::string> & tmva_xml_files);
+
   template<class T>
   void SetTMVAVariable(const std::string& var_name, const ReducerLeaf<T>& leaf) {
-    if (tmva_xml_file_.Length() > 0 || tmva_xml_files_.size() > 0) {
-      if (leaf.type() == "Float_t") {
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-        else {
-                                        tmva_reader_1_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddVariable(var_name, (Float_t*)leaf.branch_address());
-        }
-      } else if (LeafExists(std::string(leaf.name()+"_tmvafloatcopy"))){
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-        else {
-                                        tmva_reader_1_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddVariable(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-        }
-      } else {
-        ReducerLeaf<Float_t>& tmva_float_copy_leaf = CreateFloatCopyLeaf(leaf.name()+"_tmvafloatcopy", leaf);
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-        else {
-                                        tmva_reader_1_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddVariable(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-        }
-      }
-    }
+    AddVariable(var_name, leaf.name(), leaf.type(), leaf.branch_address(), false);
   }
-  
+
   template<class T>
   void SetTMVASpectatorVariable(const std::string& var_name, const ReducerLeaf<T>& leaf) {
-    if (tmva_xml_file_.Length() > 0 || tmva_xml_files_.size() > 0) {
-      if (leaf.type() == "Float_t") {
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-        else {
-                                        tmva_reader_1_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddSpectator(var_name, (Float_t*)leaf.branch_address());
-        }
-      } else if (LeafExists(std::string(leaf.name()+"_tmvafloatcopy"))){
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-        else {
-                                        tmva_reader_1_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddSpectator(var_name, (Float_t*)(GetInterimLeafByName(leaf.name()+"_tmvafloatcopy").branch_address()));
-        }
-      } else {
-        ReducerLeaf<Float_t>& tmva_float_copy_leaf = CreateFloatCopyLeaf(leaf.name()+"_tmvafloatcopy", leaf);
-        if (tmva_xml_file_.Length() > 0) tmva_reader_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-        else {
-                                        tmva_reader_1_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 1) tmva_reader_2_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 2) tmva_reader_3_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 3) tmva_reader_4_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-          if (tmva_methods_.size() > 4) tmva_reader_5_->AddSpectator(var_name, (Float_t*)tmva_float_copy_leaf.branch_address());
-        }
-      }
-    }
+    AddVariable(var_name, leaf.name(), leaf.type(), leaf.branch_address(), true);
   }
 
   void SetTMVAVariable(const std::string& var_name, Float_t* addr) {
-    if (tmva_xml_file_.Length() > 0) tmva_reader_->AddVariable(var_name.c_str(), addr);
-    if (tmva_xml_files_.size() > 0) tmva_reader_1_->AddVariable(var_name.c_str(), addr);
-    if (tmva_xml_files_.size() > 1) tmva_reader_2_->AddVariable(var_name.c_str(), addr);
-    if (tmva_xml_files_.size() > 2) tmva_reader_3_->AddVariable(var_name.c_str(), addr);
-    if (tmva_xml_files_.size() > 3) tmva_reader_4_->AddVariable(var_name.c_str(), addr);
-    if (tmva_xml_files_.size() > 4) tmva_reader_5_->AddVariable(var_name.c_str(), addr);
-  }
-  
- protected:
-  virtual void PrepareSpecialBranches() {
-		if (tmva_xml_file_.Length() > 0) tmva_reader_->BookMVA( tmva_method_, tmva_xml_file_);
-    if (tmva_xml_files_.size() > 0) tmva_reader_1_->BookMVA( tmva_methods_.at(0), tmva_xml_files_.at(0));
-    if (tmva_xml_files_.size() > 1) tmva_reader_2_->BookMVA( tmva_methods_.at(1), tmva_xml_files_.at(1));
-    if (tmva_xml_files_.size() > 2) tmva_reader_3_->BookMVA( tmva_methods_.at(2), tmva_xml_files_.at(2));
-    if (tmva_xml_files_.size() > 3) tmva_reader_4_->BookMVA( tmva_methods_.at(3), tmva_xml_files_.at(3));
-    if (tmva_xml_files_.size() > 4) tmva_reader_5_->BookMVA( tmva_methods_.at(4), tmva_xml_files_.at(4));
+    AddVariable(var_name, var_name, "Float_t", addr, false);
   }
-  
-  virtual void UpdateSpecialLeaves() {
-    if (tmva_xml_file_.Length() > 0) *tmva_classifier_value_ = tmva_reader_->EvaluateMVA(tmva_method_);
-    if (tmva_xml_files_.size() > 0) *tmva_classifier_1_value_ = tmva_reader_1_->EvaluateMVA(tmva_methods_.at(0));
-    if (tmva_xml_files_.size() > 1) *tmva_classifier_2_value_ = tmva_reader_2_->EvaluateMVA(tmva_methods_.at(1));
-    if (tmva_xml_files_.size() > 2) *tmva_classifier_3_value_ = tmva_reader_3_->EvaluateMVA(tmva_methods_.at(2));
-    if (tmva_xml_files_.size() > 3) *tmva_classifier_4_value_ = tmva_reader_4_->EvaluateMVA(tmva_methods_.at(3));
-    if (tmva_xml_files_.size() > 4) *tmva_classifier_5_value_ = tmva_reader_5_->EvaluateMVA(tmva_methods_.at(4));
-  }
-  
-  virtual void CreateSpecialBranches() {
-    using namespace doocore::io;
-    if (tmva_xml_file_.Length() > 0) {
-      sinfo << "TMVA weights are set. Creating BDT classifier." << endmsg;
-      tmva_classifier_        = &(CreateDoubleLeaf(tmva_method_+"_classifier", tmva_method_+"_classifier", "Double_t"));
-      tmva_classifier_value_  = (Double_t*)tmva_classifier_->branch_address();
-      
-      tmva_reader_            = new TMVA::Reader("!Color");
-    }
-    else if (tmva_methods_.size() > 0) {
-      sinfo << "TMVA weights are set. Creating BDT classifier." << endmsg;
-      tmva_classifier_1_        = &(CreateDoubleLeaf(std::string(tmva_methods_.at(0)+"_classifier"), std::string(tmva_methods_.at(0)+"_classifier"), "Double_t"));
-      tmva_classifier_1_value_  = (Double_t*)tmva_classifier_1_->branch_address();
-      tmva_reader_1_            = new TMVA::Reader("!Color");
-      if (tmva_methods_.size() > 1) {
-        tmva_classifier_2_        = &(CreateDoubleLeaf(std::string(tmva_methods_.at(1)+"_classifier"), std::string(tmva_methods_.at(1)+"_classifier"), "Double_t"));
-        tmva_classifier_2_value_  = (Double_t*)tmva_classifier_2_->branch_address();
-        tmva_reader_2_            = new TMVA::Reader("!Color");
-      }
-      if (tmva_methods_.size() > 2) {
-        tmva_classifier_3_        = &(CreateDoubleLeaf(std::string(tmva_methods_.at(2)+"_classifier"), std::string(tmva_methods_.at(2)+"_classifier"), "Double_t"));
-        tmva_classifier_3_value_  = (Double_t*)tmva_classifier_3_->branch_address();
-        tmva_reader_3_            = new TMVA::Reader("!Color");
-      }
-      if (tmva_methods_.size() > 3) {
-        tmva_classifier_4_        = &(CreateDoubleLeaf(std::string(tmva_methods_.at(3)+"_classifier"), std::string(tmva_methods_.at(3)+"_classifier"), "Double_t"));
-        tmva_classifier_4_value_  = (Double_t*)tmva_classifier_4_->branch_address();
-        tmva_reader_4_            = new TMVA::Reader("!Color");
-      }
-      if (tmva_methods_.size() > 4) {
-        tmva_classifier_5_        = &(CreateDoubleLeaf(std::string(tmva_methods_.at(4)+"_classifier"), std::string(tmva_methods_.at(4)+"_classifier"), "Double_t"));
-        tmva_classifier_5_value_  = (Double_t*)tmva_classifier_5_->branch_address();
-        tmva_reader_5_            = new TMVA::Reader("!Color");
-      }
-    }
+
+  /**
+   *  @brief Set leaf determining the fold for k-fold methods
+   *
+   *  @param leaf integer leaf to take the fold key from (e.g. eventNumber)
+   */
+  template<class T>
+  void SetTMVAFoldLeaf(const ReducerLeaf<T>& leaf) {
+    SetFoldLeaf(leaf.name(), leaf.type(), leaf.branch_address());
   }
 
+  /**
+   *  @brief Set number of threads for batched evaluation
+   *
+   *  @param num_threads number of threads (default: 1)
+   */
+  void set_num_threads(unsigned int num_threads) { num_threads_ = num_threads > 0 ? num_threads : 1; }
+
+  /**
+   *  @brief Set number of entries per block in batched evaluation
+   *
+   *  @param batch_size number of entries per block (default: 10000)
+   */
+  void set_batch_size(unsigned int batch_size) { batch_size_ = batch_size > 0 ? batch_size : 1; }
+
+  /**
+   *  @brief Evaluate BDT methods natively instead of via TMVA::Reader
+   *
+   *  @param use_native_bdt whether to use BDTForest for BDT weight files (default: false)
+   */
+  void set_use_native_bdt(bool use_native_bdt) { use_native_bdt_ = use_native_bdt; }
+
+  /**
+   *  @brief Compare native BDT evaluation with TMVA::Reader
+   *
+   *  @param num_entries number of entries to compare (default: 0, i.e. no validation)
+   */
+  void set_native_bdt_validation(unsigned int num_entries) { native_bdt_validation_ = num_entries; }
+
+ protected:
+  virtual void PrepareSpecialBranches();
+  virtual void UpdateSpecialLeaves();
+  virtual void CreateSpecialBranches();
+
  private:
-  ReducerLeaf<Double_t>	* tmva_classifier_;
-  Double_t							* tmva_classifier_value_;
-	TString									tmva_method_;
-	TMVA::Reader					* tmva_reader_;
-	TString									tmva_xml_file_;
-
-  std::vector<std::string>  tmva_methods_;
-  std::vector<std::string>  tmva_xml_files_;
-  ReducerLeaf<Double_t>   * tmva_classifier_1_;
-  Double_t                * tmva_classifier_1_value_;
-  TMVA::Reader            * tmva_reader_1_;
-  ReducerLeaf<Double_t>   * tmva_classifier_2_;
-  Double_t                * tmva_classifier_2_value_;
-  TMVA::Reader            * tmva_reader_2_;
-  ReducerLeaf<Double_t>   * tmva_classifier_3_;
-  Double_t                * tmva_classifier_3_value_;
-  TMVA::Reader            * tmva_reader_3_;
-  ReducerLeaf<Double_t>   * tmva_classifier_4_;
-  Double_t                * tmva_classifier_4_value_;
-  TMVA::Reader            * tmva_reader_4_;
-  ReducerLeaf<Double_t>   * tmva_classifier_5_;
-  Double_t                * tmva_classifier_5_value_;
-  TMVA::Reader            * tmva_reader_5_;
+  /**
+   *  @brief A TMVA method to evaluate
+   */
+  struct TMVAMethod {
+    std::string name;                       ///< method name
+    std::vector<std::string> xml_files;     ///< TMVA weight file per fold
+    std::vector<std::string> tags;          ///< method name per fold as booked in TMVA::Reader
+    std::vector<BDTForest*> forests;        ///< native BDT per fold if used instead of TMVA::Reader
+    ReducerLeaf<Double_t>* classifier_leaf; ///< leaf for classifier output
+
+    /**
+     *  @brief Fold to use for a given fold key
+     */
+    unsigned int Fold(Long64_t key) const {
+      const Long64_t num_folds = xml_files.size();
+      return num_folds == 1 ? 0 : ((key % num_folds) + num_folds) % num_folds;
+    }
+  };
+
+  /**
+   *  @brief An input or spectator variable for TMVA
+   */
+  struct TMVAVariable {
+    std::string name;                       ///< variable name as in TMVA weight file
+    ReducerLeaf<Float_t>* leaf;             ///< leaf to read the value from (casting to Float_t)
+    bool spectator;                         ///< whether this is a spectator variable
+    bool interim;                           ///< whether the value is readable directly from the interim tree
+  };
+
+  /**
+   *  @brief Register a variable in the list of TMVA variables
+   *
+   *  @param var_name name of the variable in the weight file
+   *  @param leaf_name name of the leaf providing the value
+   *  @param leaf_type type of the leaf providing the value
+   *  @param address address of the leaf's value
+   *  @param spectator whether the variable is a spectator
+   */
+  void AddVariable(const std::string& var_name, const TString& leaf_name, const TString& leaf_type, void* address, bool spectator);
+
+  /**
+   *  @brief Set the leaf providing the fold key
+   *
+   *  @param leaf_name name of the leaf providing the value
+   *  @param leaf_type type of the leaf providing the value
+   *  @param address address of the leaf's value
+   */
+  void SetFoldLeaf(const TString& leaf_name, const TString& leaf_type, void* address);
+
+  /**
+   *  @brief Check if an address belongs to a leaf of the interim tree
+   */
+  bool IsInterimAddress(void* address);
+
+  /**
+   *  @brief Current value of the fold key (0 if no fold leaf is set)
+   */
+  Long64_t GetFoldKey() const;
+
+  /**
+   *  @brief Create a TMVA::Reader with all variables and methods
+   *
+   *  @param features buffer for the variables the reader is bound to
+   *  @param native whether to book the natively evaluated methods instead of the others
+   *  @return the new reader
+   */
+  TMVA::Reader* CreateReader(std::vector<Float_t>& features, bool native=false) const;
+
+  /**
+   *  @brief Create BDTForest instances for all BDT methods if possible
+   */
+  void CreateForests();
+
+  /**
+   *  @brief Compare native BDT values with TMVA::Reader for features_[0]
+   *
+   *  @param values classifier values of all methods for the current features
+   *  @param fold_key fold key of the current entry
+   */
+  void ValidateNative(const Double_t* values, Long64_t fold_key) const;
+
+  /**
+   *  @brief Copy the current values of all variables into a buffer
+   *
+   *  @param features buffer of size variables_.size()
+   */
+  void GatherFeatures(Float_t* features) const;
+
+  /**
+   *  @brief Reactivate the input tree branches of all variables and the fold leaf
+   *
+   *  With branches to keep, all other branches of the input tree are
+   *  deactivated and would be read with stale values.
+   */
+  void ActivateInputBranches();
+
+  /**
+   *  @brief Evaluate all methods for all entries before the event loop
+   */
+  void EvaluateBatched();
+
+  /**
+   *  @brief Registered methods
+   */
+  std::vector<TMVAMethod> methods_;
+
+  /**
+   *  @brief Registered input and spectator variables
+   */
+  std::vector<TMVAVariable> variables_;
+
+  /**
+   *  @brief Leaf providing the fold key for k-fold methods
+   */
+  ReducerLeaf<Long64_t>* fold_leaf_;
+
+  /**
+   *  @brief Whether the fold key is readable directly from the interim tree
+   */
+  bool fold_leaf_interim_;
+
+  /**
+   *  @brief Readers, one per thread
+   */
+  std::vector<TMVA::Reader*> readers_;
+
+  /**
+   *  @brief Reader for natively evaluated methods used for validation
+   */
+  TMVA::Reader* validation_reader_;
+
+  /**
+   *  @brief Feature buffers the readers are bound to, one per thread
+   */
+  std::vector<std::vector<Float_t> > features_;
+
+  /**
+   *  @brief Buffers for native BDT evaluation, one per thread
+   */
+  std::vector<BDTForest::Buffers> forest_buffers_;
+
+  /**
+   *  @brief Precomputed classifier values
+   *
+   *  The values of entry i are stored at classifier_values_[i*methods_.size()+m]
+   *  for method m.
+   */
+  std::vector<Double_t> classifier_values_;
+
+  /**
+   *  @brief Whether classifier values have been precomputed in batches
+   */
+  bool batched_;
+
+  /**
+   *  @brief Number of threads for batched evaluation
+   */
+  unsigned int num_threads_;
+
+  /**
+   *  @brief Number of entries per block in batched evaluation
+   */
+  unsigned int batch_size_;
+
+  /**
+   *  @brief Whether to evaluate BDT methods natively
+   */
+  bool use_native_bdt_;
+
+  /**
+   *  @brief Number of entries to validate native BDT evaluation on
+   */
+  unsigned int native_bdt_validation_;
 };
 } // namespace reducer
 } // namespace dooselection
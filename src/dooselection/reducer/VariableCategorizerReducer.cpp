@@ -1,38 +1,81 @@
 #include "VariableCategorizerReducer.h"
 
+// from STL
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+
 // from ROOT
 #include "TMath.h"
 
+// from DooCore
+#include "doocore/io/Progress.h"
+
 // from BOOST
 #include "boost/lexical_cast.hpp"
 
+// from project
+#include "QuantileSketch.h"
+
 namespace dooselection {
 namespace reducer {
 
 using namespace dooselection::reducer;
 
+namespace {
+/// Weighted mean of the sorted (value, weight) pairs between each two quantiles
+std::vector<double> WeightedBinCenters(const std::vector<std::pair<double,double> >& weighted_values, const std::vector<double>& quantiles){
+  std::vector<double> weighted_bin_centers;
+  std::vector<double>::const_iterator it_quantiles = quantiles.begin();
+  it_quantiles++; // jump over greatest lower bound
+  double count = 0;
+  double sum = 0;
+  for (auto weighted_value : weighted_values){
+    if (weighted_value.first < *it_quantiles){
+      count += weighted_value.second;
+      sum += weighted_value.second*weighted_value.first;
+    }
+    else{
+      weighted_bin_centers.push_back(sum/count);
+      count = weighted_value.second;
+      sum = weighted_value.second*weighted_value.first;
+      it_quantiles++;
+    }
+  }
+  weighted_bin_centers.push_back(sum/count);
+  return weighted_bin_centers;
+}
+} // namespace
+
+const Long64_t VariableCategorizerReducer::block_size_;
+
 VariableCategorizerReducer::VariableCategorizerReducer(const std::string& prefix_name):
   prefix_name_(prefix_name),
-  variables_()
+  variables_(),
+  exact_quantiles_(false),
+  sketch_size_(200),
+  num_threads_(1)
 {}
 
 void VariableCategorizerReducer::set_variable(std::string variable_name, int nbins, double range_min, double range_max){
 
   // else{
     std::vector<double> variable_quantiles;
-    std::vector<double> variable_data_points;
     /// vector containing a tuple with the following entries:
     /// 0 variable_name 
     /// 1 nbins 
     /// 2 range min 
     /// 3 range max 
     /// 4 vector of quantiles 
-    /// 5 vector of data points 
-    /// 6 int pointer to variable category 
-    /// 7 double pointer to variable value 
-    /// 8 reducer leaf pointer to variable category leaf
+    /// 5 int pointer to variable category 
+    /// 6 double pointer to variable value 
+    /// 7 reducer leaf pointer to variable category leaf
     int* int_ptr=NULL; Double_t* double_ptr=NULL; dooselection::reducer::ReducerLeaf<Int_t>* leaf_ptr=NULL;
-    auto t = std::make_tuple(variable_name, nbins, range_min, range_max, variable_quantiles, variable_data_points, int_ptr, double_ptr, leaf_ptr);
+    auto t = std::make_tuple(variable_name, nbins, range_min, range_max, variable_quantiles, int_ptr, double_ptr, leaf_ptr);
     variables_.push_back(t);
     doocore::io::sinfo << "-info-  \t" << "VariableCategorizerReducer \t" << "Added variable '" << variable_name << "' to list of variables to categorize" << " (" << nbins << " bins in range " << range_min << " - " << range_max << ")." << doocore::io::endmsg;
   // }
@@ -49,38 +92,129 @@ void VariableCategorizerReducer::CreateSpecialBranches(){
 
     dooselection::reducer::ReducerLeaf<Int_t>* variable_category_leaf = &(CreateIntLeaf(prefix_name_+std::to_string(variable_binning)+"_"+variable_name, prefix_name_+std::to_string(variable_binning)+"_"+variable_name, "Int_t", -1));
 
-    std::get<6>(variable) = (Int_t*)variable_category_leaf->branch_address();
-    std::get<7>(variable) = (Double_t*)GetInterimLeafByName(variable_name).branch_address();
-    std::get<8>(variable) = variable_category_leaf;
+    std::get<5>(variable) = (Int_t*)variable_category_leaf->branch_address();
+    std::get<6>(variable) = (Double_t*)GetInterimLeafByName(variable_name).branch_address();
+    std::get<7>(variable) = variable_category_leaf;
   }
 }
 
 void VariableCategorizerReducer::PrepareSpecialBranches(){
-  int nevents = interim_tree_->GetEntries();
+  const Long64_t nevents = interim_tree_->GetEntries();
+  const std::size_t nvariables = variables_.size();
+
+  doocore::io::sinfo << "-info-  \t" << "VariableCategorizerReducer \t" << "Reading " << nvariables << " variables in one pass to compute " << (exact_quantiles_ ? "exact p-quantiles." : "p-quantiles with streaming sketches.") << doocore::io::endmsg;
+  interim_tree_->SetBranchStatus("*", false);
   for (auto& variable: variables_){
+    if (std::get<6>(variable) != NULL) interim_tree_->SetBranchStatus(std::get<0>(variable).c_str(), true);
+  }
+
+  // exact mode: all values in range; sketch mode: one sketch per thread and variable, merged after the pass
+  std::vector<std::vector<double> > data_points(exact_quantiles_ ? nvariables : 0);
+  std::vector<std::vector<QuantileSketch> > sketches(exact_quantiles_ ? 0 : num_threads_);
+  for (unsigned int t=0; t<sketches.size(); ++t){
+    for (std::size_t v=0; v<nvariables; ++v){
+      sketches[t].push_back(QuantileSketch(sketch_size_, 0x9e3779b97f4a7c15ULL*(t*nvariables+v+1)));
+    }
+  }
+
+  // values of a block of entries, NaN for values out of range or of missing variables;
+  // two buffers, so that the next block is read while the last one is added
+  std::vector<double> blocks[2];
+  Long64_t block_entries[2] = {0, 0};
+  auto read_block = [&](Long64_t block_index) {
+    std::vector<double>& block = blocks[block_index%2];
+    block.resize(static_cast<std::size_t>(block_size_)*nvariables);
+    const Long64_t block_start = block_index*block_size_;
+    block_entries[block_index%2] = std::min(block_size_, nevents-block_start);
+    for (Long64_t row=0; row<block_entries[block_index%2]; ++row){
+      interim_tree_->GetEvent(block_start+row);
+      for (std::size_t v=0; v<nvariables; ++v){
+        const Double_t* value_ptr = std::get<6>(variables_[v]);
+        double value = std::numeric_limits<double>::quiet_NaN();
+        if (value_ptr != NULL && (*value_ptr > std::get<2>(variables_[v])) && (*value_ptr < std::get<3>(variables_[v]))) value = *value_ptr;
+        block[row*nvariables+v] = value;
+      }
+    }
+  };
+  auto add_rows = [&](Long64_t block_index, Long64_t row_begin, Long64_t row_end, unsigned int t) {
+    const std::vector<double>& block = blocks[block_index%2];
+    for (Long64_t row=row_begin; row<row_end; ++row){
+      for (std::size_t v=0; v<nvariables; ++v){
+        const double value = block[row*nvariables+v];
+        if (std::isnan(value)) continue;
+        if (exact_quantiles_) data_points[v].push_back(value);
+        else sketches[t][v].Add(value);
+      }
+    }
+  };
+
+  const Long64_t num_blocks = (nevents+block_size_-1)/block_size_;
+  doocore::io::Progress p("Computing p-quantiles", nevents);
+  if (exact_quantiles_ || num_threads_ == 1){
+    for (Long64_t block_index=0; block_index<num_blocks; ++block_index){
+      read_block(block_index);
+      add_rows(block_index, 0, block_entries[block_index%2], 0);
+      p += block_entries[block_index%2];
+    }
+  }
+  else{
+    // reading the tree is sequential and done here, while the workers (started
+    // once for the whole pass) each add their share of the rows of every block
+    // to their own sketches
+    std::mutex block_mutex;
+    std::condition_variable block_read, block_added;
+    Long64_t num_blocks_read = 0;
+    std::vector<Long64_t> num_blocks_added(num_threads_, 0);
+    auto fill_sketches = [&](unsigned int t) {
+      for (Long64_t block_index=0; block_index<num_blocks; ++block_index){
+        {
+          std::unique_lock<std::mutex> lock(block_mutex);
+          block_read.wait(lock, [&]{return num_blocks_read > block_index;});
+        }
+        const Long64_t rows_per_thread = (block_entries[block_index%2]+num_threads_-1)/num_threads_;
+        add_rows(block_index, std::min(t*rows_per_thread, block_entries[block_index%2]), std::min((t+1)*rows_per_thread, block_entries[block_index%2]), t);
+        {
+          std::lock_guard<std::mutex> lock(block_mutex);
+          ++num_blocks_added[t];
+        }
+        block_added.notify_one();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<num_threads_; ++t){
+      threads.push_back(std::thread(fill_sketches, t));
+    }
+    for (Long64_t block_index=0; block_index<num_blocks; ++block_index){
+      // the buffer of block_index-2 is overwritten, so all workers must be done with it
+      if (block_index >= 2){
+        std::unique_lock<std::mutex> lock(block_mutex);
+        block_added.wait(lock, [&]{return *std::min_element(num_blocks_added.begin(), num_blocks_added.end()) >= block_index-1;});
+      }
+      read_block(block_index);
+      {
+        std::lock_guard<std::mutex> lock(block_mutex);
+        num_blocks_read = block_index+1;
+      }
+      block_read.notify_all();
+      p += block_entries[block_index%2];
+    }
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it){
+      (*it).join();
+    }
+  }
+  p.Finish();
+  interim_tree_->SetBranchStatus("*", true);
+
+  for (std::size_t v=0; v<nvariables; ++v){
+    auto& variable = variables_[v];
     std::string variable_name = std::get<0>(variable);
     unsigned int variable_binning = std::get<1>(variable);
     double variable_range_min = std::get<2>(variable);
     double variable_range_max = std::get<3>(variable);
-    std::vector<double> data_points;
+    if (std::get<6>(variable) == NULL) continue;
 
     doocore::io::sinfo << "-info-  \t" << "VariableCategorizerReducer \t" << "Computing p-quantiles for " << variable_name  << " (" << variable_binning << " bins, from " << variable_range_min << " to " << variable_range_max << ")." << doocore::io::endmsg;
-    interim_tree_->SetBranchStatus("*", false);
-    interim_tree_->SetBranchStatus(variable_name.c_str(), true);
-    double value;
-    for (Int_t ev = 0; ev < nevents; ev++){
-      double frac = static_cast<double>(ev)/nevents;
-      if (isatty(fileno(stdout))){
-        if ( (ev%100) == 0 ) printf("Progress %.2f %% \xd", frac*100.0);
-      }
-      interim_tree_->GetEvent(ev);
-      value = *std::get<7>(variable);
-      if ((value > variable_range_min) && (value < variable_range_max)) data_points.push_back(value);
-      fflush(stdout);
-    }
-    std::cout << std::endl;
-    interim_tree_->SetBranchStatus("*", true);
-    sort(data_points.begin(), data_points.end());
 
     std::vector<double> probabilities;
     for (unsigned int i = 1; i < variable_binning; i++) {
@@ -91,7 +225,27 @@ void VariableCategorizerReducer::PrepareSpecialBranches(){
     quantiles.front() = variable_range_min;
     quantiles.back() = variable_range_max;
 
-    TMath::Quantiles(data_points.size(), variable_binning-1, &data_points[0], &quantiles[1], &probabilities[0]);
+    // sorted values with their weights for the weighted bin centers
+    std::vector<std::pair<double,double> > weighted_values;
+    if (exact_quantiles_){
+      std::vector<double>& variable_data_points = data_points[v];
+      sort(variable_data_points.begin(), variable_data_points.end());
+      TMath::Quantiles(variable_data_points.size(), variable_binning-1, &variable_data_points[0], &quantiles[1], &probabilities[0]);
+      weighted_values.reserve(variable_data_points.size());
+      for (auto data_point : variable_data_points){
+        weighted_values.push_back(std::make_pair(data_point, 1.0));
+      }
+      std::vector<double>().swap(variable_data_points);
+    }
+    else{
+      QuantileSketch& sketch = sketches[0][v];
+      for (unsigned int t=1; t<num_threads_; ++t){
+        sketch.Merge(sketches[t][v]);
+      }
+      std::vector<double> sketch_quantiles = sketch.Quantiles(probabilities);
+      std::copy(sketch_quantiles.begin(), sketch_quantiles.end(), quantiles.begin()+1);
+      weighted_values = sketch.WeightedValues();
+    }
 
     // print out all quantiles
     doocore::io::sinfo << "-info-  \t" << "VariableCategorizerReducer \t" << "The calculated quantiles are:" << doocore::io::endmsg;
@@ -100,24 +254,7 @@ void VariableCategorizerReducer::PrepareSpecialBranches(){
     }
 
     // now compute the weighted bin center for each quantile
-    std::vector<double> weighted_bin_centers;
-    std::vector<double>::const_iterator it_quantiles = quantiles.begin();
-    it_quantiles++; // jump over greatest lower bound
-    double count = 0;
-    double sum = 0;
-    for (auto data_point : data_points){
-      if (data_point < *it_quantiles){
-        count++;
-        sum += data_point;
-      }
-      else{
-        weighted_bin_centers.push_back(sum/count);
-        count = 1;
-        sum =  data_point;
-        it_quantiles++;
-      }
-    }
-    weighted_bin_centers.push_back(sum/count);
+    std::vector<double> weighted_bin_centers = WeightedBinCenters(weighted_values, quantiles);
 
     doocore::io::sinfo << "-info-  \t" << "VariableCategorizerReducer \t" << "The weighted bin centers are:" << doocore::io::endmsg;
     for(std::vector<double>::const_iterator it = weighted_bin_centers.begin(); it != weighted_bin_centers.end(); it++){
@@ -125,7 +262,6 @@ void VariableCategorizerReducer::PrepareSpecialBranches(){
     }
 
     std::get<4>(variable) = quantiles;
-    std::get<5>(variable) = data_points;
   }
 }
 
@@ -133,30 +269,18 @@ bool VariableCategorizerReducer::EntryPassesSpecialCuts(){return true;}
 
 void VariableCategorizerReducer::UpdateSpecialLeaves(){
   for (auto& variable: variables_){
-    std::string variable_name = std::get<0>(variable);
-//    unsigned int variable_binning = std::get<1>(variable);
-    double variable_range_min = std::get<2>(variable);
-    double variable_range_max = std::get<3>(variable);
-    std::vector<double> quantiles = std::get<4>(variable);
-    unsigned int nquantiles = quantiles.size();
+    if (std::get<6>(variable) == NULL) continue;
+    const std::vector<double>& quantiles = std::get<4>(variable);
+    double variable_value = *std::get<6>(variable);
 
+    // quantiles are sorted bin edges [q_i, q_i+1), so the number of edges not
+    // above the value is the category: 0 is the underflow bin (below range min)
+    // and quantiles.size() the overflow bin (from range max on)
     int category = -1;
-    for (unsigned int i=0; i<nquantiles; i++){
-      double variable_value = *std::get<7>(variable);
-      if (variable_value < variable_range_min){
-        category = 0; // underflow bin
-        break;
-      }
-      else if (variable_value > variable_range_max){
-        category = nquantiles; // overflow bin
-        break;
-      }
-      else if ( (variable_value >= quantiles[i]) && (variable_value < quantiles[i+1]) ){
-        category = i+1; // regular bins
-        break;
-      }
+    if (!std::isnan(variable_value)){
+      category = std::upper_bound(quantiles.begin(), quantiles.end(), variable_value) - quantiles.begin();
     }
-    *std::get<6>(variable)=category;
+    *std::get<5>(variable)=category;
   }
 }
 
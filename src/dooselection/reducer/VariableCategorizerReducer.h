@@ -2,6 +2,8 @@
 #define DOOSELECTION_REDUCER_VARIABLECATEGORIZERREDUCER_H
 
 // from STL
+#include <vector>
+#include <string>
 
 // from STL11
 #include <tuple>
@@ -33,8 +35,16 @@
  *  AReducer.set_variable("obsTime", 20, 0.3, 18.3);  // Define variable to be categorized
  *  AReducer.set_variable("obsTime", 10, 0.3, 18.3);  // Multiple entries are possible
  *  AReducer.set_variable("obsEtaAll", 8, 0.0, 0.5);  // Name will be prefix+nbins+"_"+variable_name
+ *  AReducer.set_num_threads(4);                      // Optional: fill quantile sketches on 4 threads
  *  ...
  *  @endcode
+ *
+ *  The values of all variables are read in a single pass over the tree. By
+ *  default, the quantiles are estimated with mergeable streaming sketches 
+ *  (see QuantileSketch) of bounded memory, filled on set_num_threads() threads.
+ *  With set_exact_quantiles(true) all values are kept in memory and the exact 
+ *  quantiles are computed with TMath::Quantiles() instead, e.g. to validate 
+ *  the sketches.
  **/
 namespace dooselection {
 namespace reducer {
@@ -46,6 +56,21 @@ class VariableCategorizerReducer : virtual public Reducer {
 
   void set_variable(std::string variable_name, int nbins, double range_min, double range_max);
 
+  /**
+   *  @brief Compute exact quantiles instead of streaming sketch estimates (needs all values in memory)
+   */
+  void set_exact_quantiles(bool exact_quantiles){exact_quantiles_ = exact_quantiles;}
+
+  /**
+   *  @brief Size parameter k of the quantile sketches (rank error about 1.7/k)
+   */
+  void set_sketch_size(unsigned int sketch_size){sketch_size_ = sketch_size;}
+
+  /**
+   *  @brief Number of threads filling the quantile sketches
+   */
+  void set_num_threads(unsigned int num_threads){num_threads_ = num_threads > 0 ? num_threads : 1;}
+
  protected:
   virtual void CreateSpecialBranches();
   virtual void PrepareSpecialBranches();
@@ -60,12 +85,23 @@ class VariableCategorizerReducer : virtual public Reducer {
   /// 1 nbins 
   /// 2 range min 
   /// 3 range max 
-  /// 4 vector of quantiles 
-  /// 5 vector of data points 
-  /// 6 int pointer to variable category 
-  /// 7 double pointer to variable value 
-  /// 8 reducer leaf pointer to variable category leaf
-  std::vector< std::tuple< std::string, int, double, double, std::vector<double>, std::vector<double>, int*, Double_t*, dooselection::reducer::ReducerLeaf<Int_t>* > > variables_;
+  /// 4 vector of quantiles (bin edges including range min and max)
+  /// 5 int pointer to variable category 
+  /// 6 double pointer to variable value 
+  /// 7 reducer leaf pointer to variable category leaf
+  std::vector< std::tuple< std::string, int, double, double, std::vector<double>, int*, Double_t*, dooselection::reducer::ReducerLeaf<Int_t>* > > variables_;
+
+  /// compute exact quantiles instead of sketch estimates
+  bool exact_quantiles_;
+
+  /// size parameter of the quantile sketches
+  unsigned int sketch_size_;
+
+  /// number of threads filling the quantile sketches
+  unsigned int num_threads_;
+
+  /// number of entries read before they are added to the sketches on all threads
+  static const Long64_t block_size_ = 4096;
 };
 
 } // namespace reducer
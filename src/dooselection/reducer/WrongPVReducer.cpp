@@ -1,5 +1,9 @@
 #include "WrongPVReducer.h"
 
+// from STL
+#include <algorithm>
+#include <vector>
+
 namespace dooselection {
 namespace reducer {
 
@@ -21,6 +25,13 @@ void WrongPVReducer::CreateSpecialBranches(){
   chi2_value_flat_ = (Float_t*)chi2_leaf_flat_->branch_address();
   idxPV_value_       = (Int_t*)idxPV_leaf_->branch_address();
 
+  // minimum positive IP chi2 of all PVs except the one of this (B, PV)-pair
+  ArrayReductionReducerLeaf<Double_t>& chi2_other_min_leaf = CreateDoubleArrayReductionLeaf(chi2_any_leaf_name_+"_other_min", *chi2_leaf_, kArrayMinimum, 1e+12);
+  chi2_other_min_leaf.SetMask(chi2_leaf_name_+">0");
+  chi2_other_min_leaf.SetExcludedIndex(*idxPV_leaf_);
+  chi2_other_min_leaf.set_transient(true);
+  chi2_other_min_leaf_ = &chi2_other_min_leaf;
+
   pv_x_leaf_ = &GetInterimLeafByName(pv_x_leaf_name_);
   pv_y_leaf_ = &GetInterimLeafByName(pv_y_leaf_name_);
   pv_z_leaf_ = &GetInterimLeafByName(pv_z_leaf_name_);
@@ -51,6 +62,23 @@ void WrongPVReducer::CreateSpecialBranches(){
   }
 }
 
+//------------------------------------------------------------------------------
+//                   WrongPVReducer::PrepareSpecialBranches()
+//------------------------------------------------------------------------------
+void WrongPVReducer::PrepareSpecialBranches(){
+  // these leaves are read directly and are no dependencies of any new leaf,
+  // with branches to keep they would be deactivated and read stale values
+  std::vector<const ReducerLeaf<Float_t>*> read_leaves = {chi2_leaf_, chi2_leaf_flat_, idxPV_leaf_,
+                                                          pv_x_leaf_, pv_y_leaf_, pv_z_leaf_,
+                                                          pv_x_var_leaf_, pv_y_var_leaf_, pv_z_var_leaf_,
+                                                          pv_x_true_leaf_, pv_y_true_leaf_, pv_z_true_leaf_};
+  for (auto leaf : read_leaves) {
+    if (leaf != nullptr && input_tree_->GetLeaf(leaf->name()) != NULL) {
+      input_tree_->SetBranchStatus(leaf->name(), 1);
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 //                   WrongPVReducer::EntryPassesSpecialCuts()
 //------------------------------------------------------------------------------
@@ -76,18 +104,8 @@ void WrongPVReducer::UpdateSpecialLeaves() {
     *chi2_any_value_ = 1e+12;
   }
   else {
-    // start with a reference IP of 1e+12, this also defines the larges possible value the variable can take!
-    double min_ip_chi2 = 1e+12;
-    if (debug_mode_) sinfo.increment_indent(5);
-    for (unsigned int pv = 0; pv < nPV; pv++){
-
-      if (pv != idxPV && debug_mode_) sinfo << "IP chi2 for PV No. " << pv << " is: " << chi2_leaf_->GetValue(pv) << endmsg; 
-      
-      if (pv != idxPV && chi2_leaf_->GetValue(pv) > 0 && (min_ip_chi2 <= 0 || chi2_leaf_->GetValue(pv) < min_ip_chi2) ){
-        min_ip_chi2 = chi2_leaf_->GetValue(pv);
-      }
-    }
-    if (debug_mode_) sinfo.increment_indent(-5);
+    // 1e+12 also defines the largest possible value the variable can take!
+    double min_ip_chi2 = std::min(chi2_other_min_leaf_->GetValue(), 1e+12);
     if (debug_mode_) sinfo << "Saved min IP chi2: " << min_ip_chi2 << endmsg;
     *chi2_any_value_ = min_ip_chi2;
   }
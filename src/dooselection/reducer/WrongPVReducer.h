@@ -16,6 +16,7 @@
 // from project
 #include "Reducer.h"
 #include "ReducerLeaf.h"
+#include "ArrayReductionReducerLeaf.h"
 
 /** @class dooselection::reducer::WrongPVReducer
  *  
@@ -49,6 +50,7 @@ class WrongPVReducer : virtual public Reducer {
     pv_z_true_value_(nullptr),
     chi2_any_leaf_(nullptr),
     chi2_any_value_(nullptr),
+    chi2_other_min_leaf_(nullptr),
     pv_x_res_leaf_(nullptr),
     pv_y_res_leaf_(nullptr),
     pv_z_res_leaf_(nullptr),
@@ -100,6 +102,7 @@ class WrongPVReducer : virtual public Reducer {
 
  protected:
   virtual void CreateSpecialBranches();
+  virtual void PrepareSpecialBranches();
   virtual bool EntryPassesSpecialCuts();
   virtual void UpdateSpecialLeaves();
 
@@ -135,6 +138,9 @@ class WrongPVReducer : virtual public Reducer {
   dooselection::reducer::ReducerLeaf<Double_t>* chi2_any_leaf_;
   Double_t*                                     chi2_any_value_;
 
+  // transient leaf with the minimum positive IP chi2 of all other PVs
+  const dooselection::reducer::ArrayReductionReducerLeaf<Double_t>* chi2_other_min_leaf_;
+
   dooselection::reducer::ReducerLeaf<Double_t>* pv_x_res_leaf_;
   dooselection::reducer::ReducerLeaf<Double_t>* pv_y_res_leaf_;
   dooselection::reducer::ReducerLeaf<Double_t>* pv_z_res_leaf_;
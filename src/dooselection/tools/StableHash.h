@@ -0,0 +1,42 @@
+#ifndef DOOSELECTION_TOOLS_STABLEHASH_H
+#define DOOSELECTION_TOOLS_STABLEHASH_H
+
+// from STL
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/** @file StableHash.h
+ *  @brief 64 bit FNV-1a hash for names of cache files
+ *
+ *  Unlike std::hash, the value does not depend on compiler, library version
+ *  or run, so it can name files that are read again by later runs.
+ **/
+namespace dooselection {
+namespace tools {
+
+/**
+ *  @brief 64 bit FNV-1a hash of a string
+ */
+inline std::uint64_t StableHash(const std::string& str) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+    hash = (hash ^ static_cast<unsigned char>(*it))*1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ *  @brief 64 bit FNV-1a hash of a string as 16 hex digits
+ */
+inline std::string StableHashString(const std::string& str) {
+  std::stringstream hash;
+  hash << std::hex << std::setw(16) << std::setfill('0') << StableHash(str);
+  return hash.str();
+}
+
+} // namespace tools
+} // namespace dooselection
+
+#endif // DOOSELECTION_TOOLS_STABLEHASH_H
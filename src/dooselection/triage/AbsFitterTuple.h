@@ -33,7 +33,10 @@ class AbsFitterTuple: public Tuple{
   AbsFitterTuple(const std::string& name, const std::string& path, const std::string& filename, const std::string& treename, const RooArgSet& argset, doofit::fitter::AbsFitter& fitter):
     Tuple(name, path, filename, treename, argset, "noObservable", 0, 1),
     fitter_(fitter),
-    nocut_startingvalues_file_("")
+    nocut_startingvalues_file_(""),
+    num_parallel_fits_(1),
+    fit_cache_directory_(""),
+    fit_cache_tag_("")
   {
     is_mc_ = false;
     is_sw_ = false;
@@ -43,15 +46,28 @@ class AbsFitterTuple: public Tuple{
 
   // setter
   void set_nocut_startingvalues_file(std::string nocut_startingvalues_file){nocut_startingvalues_file_=nocut_startingvalues_file;}
+  /// number of cut points fitted concurrently in separate processes (default: 1)
+  void set_num_parallel_fits(unsigned int num_parallel_fits){num_parallel_fits_ = num_parallel_fits > 0 ? num_parallel_fits : 1;}
+  /// directory to cache fit results in, cut points already fitted are skipped (default: "", no cache)
+  void set_fit_cache_directory(const std::string& fit_cache_directory){fit_cache_directory_ = fit_cache_directory;}
+  /// description of the model and fit options of the fitter, part of the fit cache key since the fitter itself cannot be inspected (default: "")
+  void set_fit_cache_tag(const std::string& fit_cache_tag){fit_cache_tag_ = fit_cache_tag;}
 
   // getter
   doofit::fitter::AbsFitter& fitter() {return fitter_;}
   std::string nocut_startingvalues_file() const{return nocut_startingvalues_file_;}
+  unsigned int num_parallel_fits() const{return num_parallel_fits_;}
+  const std::string& fit_cache_directory() const{return fit_cache_directory_;}
+  const std::string& fit_cache_tag() const{return fit_cache_tag_;}
 
  private:
   doofit::fitter::AbsFitter& fitter_;
 
   std::string nocut_startingvalues_file_;
+
+  unsigned int num_parallel_fits_;
+  std::string fit_cache_directory_;
+  std::string fit_cache_tag_;
 };
 
 } // namespace triage
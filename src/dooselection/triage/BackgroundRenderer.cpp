@@ -0,0 +1,68 @@
+#include "BackgroundRenderer.h"
+
+// from STL
+#include <cstdio>
+#include <iostream>
+
+// from POSIX
+#include <sys/wait.h>
+#include <unistd.h>
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+namespace dooselection{
+namespace triage{
+
+void BackgroundRenderer::Submit(const std::function<void()>& job){
+  if (max_jobs_ == 0){
+    job();
+    return;
+  }
+  while (running_.size() >= max_jobs_) WaitForOne();
+
+  // flush, so that buffered output is not written twice
+  std::cout.flush();
+  std::cerr.flush();
+  fflush(NULL);
+
+  pid_t pid = fork();
+  if (pid == 0){
+    int status = 0;
+    try{
+      job();
+    }
+    catch (...){
+      status = 1;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    _exit(status);
+  }
+  else if (pid < 0){
+    doocore::io::swarn << "-warning- \t" << "BackgroundRenderer::Submit(...): Cannot fork, rendering in this process" << doocore::io::endmsg;
+    job();
+  }
+  else{
+    running_.push_back(pid);
+  }
+}
+
+void BackgroundRenderer::Wait(){
+  while (!running_.empty()) WaitForOne();
+}
+
+void BackgroundRenderer::WaitForOne(){
+  if (running_.empty()) return;
+  // oldest job first, other child processes of the caller are left alone
+  const pid_t pid = running_.front();
+  running_.erase(running_.begin());
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+    doocore::io::serr << "-ERROR- \t" << "BackgroundRenderer::WaitForOne(): Rendering job " << pid << " failed" << doocore::io::endmsg;
+  }
+}
+
+} // namespace triage
+} // namespace dooselection
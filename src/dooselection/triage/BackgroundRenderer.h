@@ -0,0 +1,61 @@
+#ifndef TRIAGE_BACKGROUNDRENDERER_H
+#define TRIAGE_BACKGROUNDRENDERER_H
+
+// from STL
+#include <functional>
+#include <vector>
+
+// from POSIX
+#include <sys/types.h>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from DooCore
+
+// from here
+
+// forward declarations
+
+namespace dooselection{
+namespace triage{
+
+/// Renders plots in the background.
+/// Every submitted job (drawing canvases and printing them) runs in a forked process on a copy of the current
+/// state, so the caller can continue right away. ROOT graphics are not thread-safe, which is why processes and not
+/// threads are used. At most max_jobs run at the same time; even a single job overlaps with the caller. With
+/// max_jobs 0 or if forking fails, jobs run directly.
+class BackgroundRenderer{
+ public:
+  explicit BackgroundRenderer(unsigned int max_jobs=1):
+    max_jobs_(max_jobs){}
+
+  /// Waits for all jobs
+  ~BackgroundRenderer(){Wait();}
+
+  /// Queues a rendering job
+  void Submit(const std::function<void()>& job);
+
+  /// Waits for all submitted jobs to finish
+  void Wait();
+
+ private:
+  BackgroundRenderer(const BackgroundRenderer&);
+  BackgroundRenderer& operator=(const BackgroundRenderer&);
+
+  /// Waits for one job to finish
+  void WaitForOne();
+
+  unsigned int max_jobs_;
+  std::vector<pid_t> running_;
+};
+
+} // namespace triage
+} // namespace dooselection
+
+#endif // TRIAGE_BACKGROUNDRENDERER_H
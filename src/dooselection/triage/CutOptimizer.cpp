@@ -0,0 +1,169 @@
+#include "CutOptimizer.h"
+
+// from STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+namespace dooselection{
+namespace triage{
+
+CutOptimizer::CutOptimizer(const std::vector<Dimension>& dimensions, std::vector< std::vector<double> > columns, std::vector<double> signal_weights, std::vector<double> background_weights, double max_n_sig_events, double max_n_bkg_events):
+  dimensions_(dimensions),
+  max_n_sig_events_(max_n_sig_events),
+  max_n_bkg_events_(max_n_bkg_events)
+{
+  if (dimensions.size() != columns.size() || signal_weights.size() != background_weights.size()){
+    doocore::io::serr << "-ERROR- \t" << "CutOptimizer::CutOptimizer(...): Different numbers of dimensions and columns or of signal and background weights" << doocore::io::endmsg;
+    throw 1;
+  }
+  for (std::size_t d = 0; d < dimensions.size(); ++d){
+    const std::string& cut_operator = dimensions[d].cut_operator;
+    if (cut_operator != ">" && cut_operator != ">=" && cut_operator != "<" && cut_operator != "<="){
+      doocore::io::serr << "-ERROR- \t" << "CutOptimizer::CutOptimizer(...): Cut operator '" << cut_operator << "' of " << dimensions[d].name << " is not one of >, >=, <, <=" << doocore::io::endmsg;
+      throw 2;
+    }
+    if (columns[d].size() != signal_weights.size()){
+      doocore::io::serr << "-ERROR- \t" << "CutOptimizer::CutOptimizer(...): Column of " << dimensions[d].name << " has " << columns[d].size() << " instead of " << signal_weights.size() << " entries" << doocore::io::endmsg;
+      throw 3;
+    }
+  }
+  columns_.swap(columns);
+  signal_weights_.swap(signal_weights);
+  background_weights_.swap(background_weights);
+}
+
+CutOptimizer::Result CutOptimizer::Optimize(FoMType figure_of_merit, unsigned int num_grid_points, unsigned int num_refinements, unsigned int num_threads) const{
+  if (num_grid_points < 2) num_grid_points = 2;
+  if (num_threads == 0) num_threads = 1;
+
+  std::vector< std::pair<double, double> > ranges;
+  for (std::vector<Dimension>::const_iterator dimension = dimensions_.begin(); dimension != dimensions_.end(); ++dimension){
+    ranges.push_back(dimension->range);
+  }
+
+  Result best = OptimizeGrid(figure_of_merit, ranges, num_grid_points, num_threads);
+  unsigned int num_evaluations = best.num_evaluations;
+  doocore::io::sinfo << "CutOptimizer::Optimize(...): Grid: " << FoM::Name(figure_of_merit) << " = " << best.fom_value << doocore::io::endmsg;
+
+  for (unsigned int refinement = 0; refinement < num_refinements && !best.cut_values.empty(); ++refinement){
+    // next grid within one grid step around the best point, clipped to the
+    // original ranges; the best point so far is kept if no point is better
+    for (std::size_t d = 0; d < ranges.size(); ++d){
+      const double step = (ranges[d].second-ranges[d].first)/(num_grid_points-1);
+      ranges[d].first = std::max(dimensions_[d].range.first, best.cut_values[d]-step);
+      ranges[d].second = std::min(dimensions_[d].range.second, best.cut_values[d]+step);
+    }
+    Result refined = OptimizeGrid(figure_of_merit, ranges, num_grid_points, num_threads);
+    num_evaluations += refined.num_evaluations;
+    if (!refined.cut_values.empty() && refined.fom_value > best.fom_value) best = refined;
+    doocore::io::sinfo << "CutOptimizer::Optimize(...): Refinement " << refinement+1 << ": " << FoM::Name(figure_of_merit) << " = " << best.fom_value << doocore::io::endmsg;
+  }
+  best.num_evaluations = num_evaluations;
+  return best;
+}
+
+CutOptimizer::Result CutOptimizer::OptimizeGrid(FoMType figure_of_merit, const std::vector< std::pair<double, double> >& ranges, unsigned int num_grid_points, unsigned int num_threads) const{
+  const std::size_t num_dimensions = ranges.size();
+  std::size_t num_cut_vectors = 1;
+  for (std::size_t d = 0; d < num_dimensions; ++d){
+    if (num_cut_vectors > std::numeric_limits<std::size_t>::max()/num_grid_points){
+      doocore::io::serr << "-ERROR- \t" << "CutOptimizer::OptimizeGrid(...): Too many grid points (" << num_grid_points << "^" << num_dimensions << ")" << doocore::io::endmsg;
+      throw 4;
+    }
+    num_cut_vectors *= num_grid_points;
+  }
+
+  auto grid_cut_values = [&](std::size_t index){
+    std::vector<double> cut_values(num_dimensions);
+    for (std::size_t d = 0; d < num_dimensions; ++d){
+      const std::size_t k = index % num_grid_points;
+      index /= num_grid_points;
+      cut_values[d] = ranges[d].first + (ranges[d].second-ranges[d].first)*k/(num_grid_points-1);
+    }
+    return cut_values;
+  };
+
+  // every cut vector is written to its own slot, the figure of merit is
+  // evaluated afterwards for all of them at once
+  std::vector<double> n_sig_events(num_cut_vectors), n_bkg_events(num_cut_vectors);
+  std::atomic<std::size_t> next_cut_vector(0);
+  auto evaluate = [&](){
+    std::vector<unsigned char> pass;
+    for (std::size_t i = next_cut_vector++; i < num_cut_vectors; i = next_cut_vector++){
+      std::pair<double, double> number_of_events = NumberOfSigAndBkgEvents(grid_cut_values(i), pass);
+      n_sig_events[i] = number_of_events.first;
+      n_bkg_events[i] = number_of_events.second;
+    }
+  };
+
+  num_threads = std::min<std::size_t>(num_threads, num_cut_vectors);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < num_threads; ++i){
+    threads.push_back(std::thread(evaluate));
+  }
+  evaluate();
+  for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread){
+    (*thread).join();
+  }
+
+  std::vector<double> fom_values;
+  FoM::FigureOfMerit(figure_of_merit, n_sig_events, n_bkg_events, max_n_sig_events_, max_n_bkg_events_, fom_values);
+
+  Result result;
+  result.fom_value = std::numeric_limits<double>::quiet_NaN();
+  result.n_sig_events = 0.;
+  result.n_bkg_events = 0.;
+  result.num_evaluations = num_cut_vectors;
+  std::size_t best = num_cut_vectors;
+  for (std::size_t i = 0; i < num_cut_vectors; ++i){
+    if (std::isnan(fom_values[i])) continue;
+    if (best == num_cut_vectors || fom_values[i] > fom_values[best]) best = i;
+  }
+  if (best < num_cut_vectors){
+    result.cut_values = grid_cut_values(best);
+    result.fom_value = fom_values[best];
+    result.n_sig_events = n_sig_events[best];
+    result.n_bkg_events = n_bkg_events[best];
+  }
+  return result;
+}
+
+std::pair<double, double> CutOptimizer::NumberOfSigAndBkgEvents(const std::vector<double>& cut_values) const{
+  std::vector<unsigned char> pass;
+  return NumberOfSigAndBkgEvents(cut_values, pass);
+}
+
+std::pair<double, double> CutOptimizer::NumberOfSigAndBkgEvents(const std::vector<double>& cut_values, std::vector<unsigned char>& pass) const{
+  // one plain loop per column and cut operator, so that the compiler can
+  // vectorize them
+  const std::size_t num_candidates = signal_weights_.size();
+  pass.assign(num_candidates, 1);
+  unsigned char* p = pass.data();
+  for (std::size_t d = 0; d < columns_.size(); ++d){
+    const double* x = columns_[d].data();
+    const double c = cut_values[d];
+    const std::string& cut_operator = dimensions_[d].cut_operator;
+    if (cut_operator == ">")       for (std::size_t i = 0; i < num_candidates; ++i) p[i] &= (x[i] > c);
+    else if (cut_operator == ">=") for (std::size_t i = 0; i < num_candidates; ++i) p[i] &= (x[i] >= c);
+    else if (cut_operator == "<")  for (std::size_t i = 0; i < num_candidates; ++i) p[i] &= (x[i] < c);
+    else                           for (std::size_t i = 0; i < num_candidates; ++i) p[i] &= (x[i] <= c);
+  }
+
+  const double* s = signal_weights_.data();
+  const double* b = background_weights_.data();
+  double n_sig_events = 0., n_bkg_events = 0.;
+  for (std::size_t i = 0; i < num_candidates; ++i){
+    n_sig_events += p[i]*s[i];
+    n_bkg_events += p[i]*b[i];
+  }
+  return std::make_pair(n_sig_events, n_bkg_events);
+}
+
+} // namespace triage
+} // namespace dooselection
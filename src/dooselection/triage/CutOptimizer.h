@@ -0,0 +1,81 @@
+#ifndef TRIAGE_CUTOPTIMIZER_H
+#define TRIAGE_CUTOPTIMIZER_H
+
+// from STL
+#include <string>
+#include <utility>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from DooCore
+
+// from here
+#include "FoM.h"
+
+// forward declarations
+
+namespace dooselection{
+namespace triage{
+
+/// Joint optimization of cuts on several classifiers.
+/// The classifier values and signal/background weights of all candidates are held in memory as one column per classifier.
+/// The cut space is scanned on a grid, which is then refined around the best point; candidate cut vectors are evaluated
+/// against the columns in several threads.
+class CutOptimizer{
+ public:
+  /// A classifier to cut on
+  struct Dimension{
+    std::string name;
+    std::string cut_operator;                           ///< one of >, >=, <, <=
+    std::pair<double, double> range;                    ///< range of cut values to scan
+  };
+
+  /// Best cut vector
+  struct Result{
+    std::vector<double> cut_values;                     ///< per dimension
+    double fom_value;
+    double n_sig_events;
+    double n_bkg_events;
+    unsigned int num_evaluations;                       ///< number of evaluated cut vectors
+  };
+
+  /// columns holds the classifier values per dimension (NaN values never pass a cut), all columns and weights have one entry per candidate
+  CutOptimizer(const std::vector<Dimension>& dimensions, std::vector< std::vector<double> > columns, std::vector<double> signal_weights, std::vector<double> background_weights, double max_n_sig_events, double max_n_bkg_events);
+
+  /// Maximizes the figure of merit on a grid of num_grid_points per dimension, refined num_refinements times
+  /// around the best point (each time with num_grid_points per dimension within one grid step of it).
+  Result Optimize(FoMType figure_of_merit, unsigned int num_grid_points, unsigned int num_refinements, unsigned int num_threads) const;
+
+  /// Number of signal and background events passing all cuts
+  std::pair<double, double> NumberOfSigAndBkgEvents(const std::vector<double>& cut_values) const;
+
+  // getter
+  const std::vector<Dimension>& dimensions() const{return dimensions_;}
+  std::size_t num_candidates() const{return signal_weights_.size();}
+
+ private:
+  /// Number of signal and background events passing all cuts, using pass as buffer
+  std::pair<double, double> NumberOfSigAndBkgEvents(const std::vector<double>& cut_values, std::vector<unsigned char>& pass) const;
+
+  /// Evaluates all cut vectors of a grid (ranges per dimension) and returns the best one
+  Result OptimizeGrid(FoMType figure_of_merit, const std::vector< std::pair<double, double> >& ranges, unsigned int num_grid_points, unsigned int num_threads) const;
+
+  std::vector<Dimension> dimensions_;
+  std::vector< std::vector<double> > columns_;
+  std::vector<double> signal_weights_;
+  std::vector<double> background_weights_;
+  double max_n_sig_events_;
+  double max_n_bkg_events_;
+};
+
+} // namespace triage
+} // namespace dooselection
+
+#endif // TRIAGE_CUTOPTIMIZER_H
@@ -38,7 +38,10 @@ class FTTuple: public Tuple{
     signal_yield_(&signal_yield),
     background_yield_(&background_yield),
     plot_components_(plot_components),
-    nocut_startingvalues_file_("")
+    nocut_startingvalues_file_(""),
+    num_cpu_(16),
+    num_parallel_fits_(1),
+    fit_cache_directory_("")
   {
     is_mc_ = false;
     is_sw_ = false;
@@ -54,7 +57,10 @@ class FTTuple: public Tuple{
     signal_yield_(&signal_yield),
     background_yield_(&background_yield),
     plot_components_(plot_components),
-    nocut_startingvalues_file_("")
+    nocut_startingvalues_file_(""),
+    num_cpu_(16),
+    num_parallel_fits_(1),
+    fit_cache_directory_("")
   {
     is_mc_ = false;
     is_sw_ = false;
@@ -63,6 +69,12 @@ class FTTuple: public Tuple{
 
   // setter
   void set_nocut_startingvalues_file(std::string nocut_startingvalues_file){nocut_startingvalues_file_=nocut_startingvalues_file;}
+  /// number of CPUs per fit (RooFit::NumCPU, default: 16)
+  void set_num_cpu(int num_cpu){num_cpu_ = num_cpu > 0 ? num_cpu : 1;}
+  /// number of cut points fitted concurrently in separate processes (default: 1)
+  void set_num_parallel_fits(unsigned int num_parallel_fits){num_parallel_fits_ = num_parallel_fits > 0 ? num_parallel_fits : 1;}
+  /// directory to cache fit results in, cut points already fitted are skipped (default: "", no cache)
+  void set_fit_cache_directory(const std::string& fit_cache_directory){fit_cache_directory_ = fit_cache_directory;}
 
   // getter
   bool sim_pdf() {return sim_pdf_;}
@@ -73,6 +85,9 @@ class FTTuple: public Tuple{
   const RooRealVar* background_yield() const{return background_yield_;}
   std::vector<std::string> plot_components() const{return plot_components_;}
   std::string nocut_startingvalues_file() const{return nocut_startingvalues_file_;}  
+  int num_cpu() const{return num_cpu_;}
+  unsigned int num_parallel_fits() const{return num_parallel_fits_;}
+  const std::string& fit_cache_directory() const{return fit_cache_directory_;}
 
  private:
   bool sim_pdf_;
@@ -85,6 +100,10 @@ class FTTuple: public Tuple{
   std::vector<std::string> plot_components_;
 
   std::string nocut_startingvalues_file_;
+
+  int num_cpu_;
+  unsigned int num_parallel_fits_;
+  std::string fit_cache_directory_;
 };
 
 } // namespace triage
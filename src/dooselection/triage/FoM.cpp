@@ -11,38 +11,125 @@ namespace dooselection{
 namespace triage{
 
 double FoM::FigureOfMerit(const std::string& figure_of_merit, double n_sig_events, double n_bkg_events, double max_n_sig_events, double max_n_bkg_events){
-  if (figure_of_merit == "SignalYield"){
-    return SignalYield(n_sig_events);
-  }
-  else if(figure_of_merit == "SignalEfficiency"){
-    return SignalEfficiency(n_sig_events, max_n_sig_events);
-  }
-  else if(figure_of_merit == "BackgroundEfficiency"){
-    return SignalEfficiency(n_bkg_events, max_n_bkg_events);
-  }
-  else if(figure_of_merit == "BackgroundRejection"){
-    return BackgroundRejection(n_bkg_events, max_n_bkg_events);
-  }
-  else if(figure_of_merit == "Significance"){
-    return Significance(n_sig_events, n_bkg_events);
-  }
-  else if(figure_of_merit == "WeightedSignificance"){
-    return WeightedSignificance(n_sig_events, n_bkg_events);
+  return FigureOfMerit(Type(figure_of_merit), n_sig_events, n_bkg_events, max_n_sig_events, max_n_bkg_events);
+}
+
+double FoM::FigureOfMerit(FoMType figure_of_merit, double n_sig_events, double n_bkg_events, double max_n_sig_events, double max_n_bkg_events){
+  switch (figure_of_merit){
+    case FoMType::SignalEfficiency:
+      return SignalEfficiency(n_sig_events, max_n_sig_events);
+    case FoMType::BackgroundEfficiency:
+      return BackgroundEfficiency(n_bkg_events, max_n_bkg_events);
+    case FoMType::BackgroundRejection:
+      return BackgroundRejection(n_bkg_events, max_n_bkg_events);
+    case FoMType::Significance:
+      return Significance(n_sig_events, n_bkg_events);
+    case FoMType::WeightedSignificance:
+      return WeightedSignificance(n_sig_events, n_bkg_events);
+    case FoMType::Purity:
+      return Purity(n_sig_events, n_bkg_events);
+    case FoMType::Punzi:
+      return Punzi(n_sig_events, n_bkg_events, max_n_sig_events);
+    case FoMType::Sin2Beta:
+      return Sin2Beta(n_sig_events, n_bkg_events);
+    case FoMType::SignalYield:
+    default:
+      return SignalYield(n_sig_events);
   }
-  else if(figure_of_merit == "Purity"){
-    return Purity(n_sig_events, n_bkg_events);
+}
+
+void FoM::FigureOfMerit(FoMType figure_of_merit, const std::vector<double>& n_sig_events, const std::vector<double>& n_bkg_events, double max_n_sig_events, double max_n_bkg_events, std::vector<double>& fom_values, bool print_warnings){
+  // one plain loop per figure of merit with the same formulas as the scalar
+  // methods, so that the compiler can vectorize them
+  const std::size_t n = n_sig_events.size();
+  fom_values.resize(n);
+  const double* s = n_sig_events.data();
+  const double* b = n_bkg_events.data();
+  double* fom = fom_values.data();
+  switch (figure_of_merit){
+    case FoMType::SignalEfficiency:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = s[i]/max_n_sig_events;
+      break;
+    case FoMType::BackgroundEfficiency:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = b[i]/max_n_bkg_events;
+      break;
+    case FoMType::BackgroundRejection:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = 1.-b[i]/max_n_bkg_events;
+      break;
+    case FoMType::Significance:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = s[i]/sqrt(s[i]+b[i]);
+      break;
+    case FoMType::WeightedSignificance:{
+      const double alpha = 100.;
+      for (std::size_t i = 0; i < n; ++i) fom[i] = (s[i]/alpha)/sqrt(s[i]/alpha+b[i]);
+      break;
+    }
+    case FoMType::Purity:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = s[i]/(s[i]+b[i]);
+      break;
+    case FoMType::Punzi:{
+      const double alpha = 2.;
+      for (std::size_t i = 0; i < n; ++i) fom[i] = (s[i]/max_n_sig_events)/((alpha/2)+sqrt(b[i]));
+      break;
+    }
+    case FoMType::Sin2Beta:{
+      if (print_warnings) doocore::io::swarn << "-warning- \t" << "Your are using the sin2beta FoM. The numbers are only correct if the mass range is 5200-5500 MeV!" << doocore::io::endmsg;
+      const double epsilon_eff = 0.0238;
+      for (std::size_t i = 0; i < n; ++i) fom[i] = 1/(1.818/sqrt(epsilon_eff*s[i]) + 0.00057*(b[i]/s[i]));
+      break;
+    }
+    case FoMType::SignalYield:
+    default:
+      for (std::size_t i = 0; i < n; ++i) fom[i] = s[i];
+      break;
   }
-  else if(figure_of_merit == "Punzi"){
-    return Punzi(n_sig_events, n_bkg_events, max_n_sig_events);
+}
+
+bool FoM::IsKnown(const std::string& figure_of_merit){
+  std::vector<FoMType> types = Types();
+  for (std::vector<FoMType>::const_iterator type = types.begin(); type != types.end(); ++type){
+    if (Name(*type) == figure_of_merit) return true;
   }
-  else if(figure_of_merit == "Sin2Beta"){
-    return Sin2Beta(n_sig_events, n_bkg_events);
+  return false;
+}
+
+FoMType FoM::Type(const std::string& figure_of_merit){
+  std::vector<FoMType> types = Types();
+  for (std::vector<FoMType>::const_iterator type = types.begin(); type != types.end(); ++type){
+    if (Name(*type) == figure_of_merit) return *type;
   }
-  else{
-    return SignalYield(n_sig_events);
+  return FoMType::SignalYield;
+}
+
+std::string FoM::Name(FoMType figure_of_merit){
+  switch (figure_of_merit){
+    case FoMType::SignalEfficiency: return "SignalEfficiency";
+    case FoMType::BackgroundEfficiency: return "BackgroundEfficiency";
+    case FoMType::BackgroundRejection: return "BackgroundRejection";
+    case FoMType::Significance: return "Significance";
+    case FoMType::WeightedSignificance: return "WeightedSignificance";
+    case FoMType::Purity: return "Purity";
+    case FoMType::Punzi: return "Punzi";
+    case FoMType::Sin2Beta: return "Sin2Beta";
+    case FoMType::SignalYield:
+    default: return "SignalYield";
   }
 }
 
+std::vector<FoMType> FoM::Types(){
+  std::vector<FoMType> types;
+  types.push_back(FoMType::SignalYield);
+  types.push_back(FoMType::SignalEfficiency);
+  types.push_back(FoMType::BackgroundEfficiency);
+  types.push_back(FoMType::BackgroundRejection);
+  types.push_back(FoMType::Significance);
+  types.push_back(FoMType::WeightedSignificance);
+  types.push_back(FoMType::Purity);
+  types.push_back(FoMType::Punzi);
+  types.push_back(FoMType::Sin2Beta);
+  return types;
+}
+
 double FoM::SignalYield(double n_sig_events){
   double fom_value = n_sig_events;
   return fom_value;
@@ -3,6 +3,7 @@
 
 // from STL
 #include <string>
+#include <vector>
 // from ROOT
 
 // from RooFit
@@ -20,9 +21,33 @@
 namespace dooselection{
 namespace triage{
 
+/// Available figures of merit
+enum class FoMType{
+  SignalYield,
+  SignalEfficiency,
+  BackgroundEfficiency,
+  BackgroundRejection,
+  Significance,
+  WeightedSignificance,
+  Purity,
+  Punzi,
+  Sin2Beta
+};
+
 class FoM{
  public: 
   static double FigureOfMerit(const std::string& figure_of_merit, double n_sig_events, double n_bkg_events, double max_n_sig_events, double max_n_bkg_events);
+  static double FigureOfMerit(FoMType figure_of_merit, double n_sig_events, double n_bkg_events, double max_n_sig_events, double max_n_bkg_events);
+  /// Computes a figure of merit for all given numbers of events at once (dispatching once, not per value).
+  /// print_warnings=false suppresses warnings, e.g. when called from several threads.
+  static void FigureOfMerit(FoMType figure_of_merit, const std::vector<double>& n_sig_events, const std::vector<double>& n_bkg_events, double max_n_sig_events, double max_n_bkg_events, std::vector<double>& fom_values, bool print_warnings=true);
+  /// Figure of merit for a name, SignalYield for unknown names
+  static FoMType Type(const std::string& figure_of_merit);
+  /// Whether a name is one of the figures of merit
+  static bool IsKnown(const std::string& figure_of_merit);
+  static std::string Name(FoMType figure_of_merit);
+  /// All figures of merit
+  static std::vector<FoMType> Types();
   static double SignalYield(double n_sig_events);
   static double SignalEfficiency(double n_sig_events, double max_n_sig_events);
   static double BackgroundEfficiency(double n_bkg_events, double max_n_bkg_events);
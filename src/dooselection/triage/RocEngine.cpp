@@ -0,0 +1,224 @@
+#include "RocEngine.h"
+
+// from STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+namespace dooselection{
+namespace triage{
+
+namespace {
+/// Standard deviation of the finite values
+double StandardDeviation(const std::vector<double>& values){
+  double sum = 0., sum_sq = 0.;
+  std::size_t n = 0;
+  for (std::vector<double>::const_iterator value = values.begin(); value != values.end(); ++value){
+    if (!std::isfinite(*value)) continue;
+    sum += *value;
+    sum_sq += (*value)*(*value);
+    ++n;
+  }
+  if (n < 2) return 0.;
+  const double mean = sum/n;
+  return std::sqrt(std::max(0., (sum_sq/n - mean*mean)*n/(n-1)));
+}
+} // namespace
+
+RocEngine::RocEngine(const std::vector<double>& values, const std::vector<double>& signal_weights, const std::vector<double>& background_weights, const std::string& cut_operator, double max_n_sig_events, double max_n_bkg_events):
+  max_n_sig_events_(max_n_sig_events),
+  max_n_bkg_events_(max_n_bkg_events),
+  auc_(0.),
+  auc_error_(0.),
+  num_bootstrap_samples_(0)
+{
+  if (cut_operator != ">" && cut_operator != ">=" && cut_operator != "<" && cut_operator != "<="){
+    doocore::io::serr << "-ERROR- \t" << "RocEngine::RocEngine(...): Cut operator '" << cut_operator << "' is not one of >, >=, <, <=" << doocore::io::endmsg;
+    throw 1;
+  }
+  if (values.size() != signal_weights.size() || values.size() != background_weights.size()){
+    doocore::io::serr << "-ERROR- \t" << "RocEngine::RocEngine(...): Different numbers of classifier values and weights" << doocore::io::endmsg;
+    throw 2;
+  }
+
+  // sort once, so that the candidates passing a cut are a prefix
+  const bool upper = (cut_operator == ">" || cut_operator == ">=");
+  std::vector<std::size_t> order;
+  order.reserve(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i){
+    if (!std::isnan(values[i])) order.push_back(i);
+  }
+  if (upper){
+    std::sort(order.begin(), order.end(), [&values](std::size_t lhs, std::size_t rhs){ return values[lhs] > values[rhs]; });
+  }
+  else{
+    std::sort(order.begin(), order.end(), [&values](std::size_t lhs, std::size_t rhs){ return values[lhs] < values[rhs]; });
+  }
+
+  signal_weights_.resize(order.size());
+  background_weights_.resize(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i){
+    signal_weights_[i] = signal_weights[order[i]];
+    background_weights_[i] = background_weights[order[i]];
+
+    // a cut value per distinct classifier value: 'x>c' with c just below
+    // the value is identical to 'x>=value' (and correspondingly for '<')
+    const double value = values[order[i]];
+    if (i+1 == order.size() || values[order[i+1]] != value){
+      group_ends_.push_back(i+1);
+      if (cut_operator == ">") cut_values_.push_back(std::nextafter(value, -std::numeric_limits<double>::infinity()));
+      else if (cut_operator == "<") cut_values_.push_back(std::nextafter(value, std::numeric_limits<double>::infinity()));
+      else cut_values_.push_back(value);
+    }
+  }
+
+  CumulativeSums(signal_weights_, background_weights_, n_sig_events_, n_bkg_events_);
+  auc_ = Auc(n_sig_events_, n_bkg_events_, max_n_sig_events_, max_n_bkg_events_);
+
+  std::vector<FoMType> types = FoM::Types();
+  std::vector<double> fom_values;
+  for (std::vector<FoMType>::const_iterator type = types.begin(); type != types.end(); ++type){
+    FoM::FigureOfMerit(*type, n_sig_events_, n_bkg_events_, max_n_sig_events_, max_n_bkg_events_, fom_values);
+    Optimum optimum = {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), 0., 0.};
+    std::size_t maximum = Maximum(fom_values);
+    if (maximum < fom_values.size()){
+      optimum.fom_value = fom_values[maximum];
+      optimum.cut_value = cut_values_[maximum];
+    }
+    optima_[*type] = optimum;
+  }
+}
+
+void RocEngine::Bootstrap(unsigned int num_samples, unsigned int num_threads, unsigned int seed){
+  if (num_samples == 0 || group_ends_.empty()) return;
+  if (num_threads == 0) num_threads = 1;
+  num_threads = std::min(num_threads, num_samples);
+
+  const std::vector<FoMType> types = FoM::Types();
+  std::vector< std::vector<double> > sample_fom_values(types.size(), std::vector<double>(num_samples));
+  std::vector< std::vector<double> > sample_cut_values(types.size(), std::vector<double>(num_samples));
+  std::vector<double> sample_aucs(num_samples);
+
+  // the totals are scaled like the sums of weights, which might differ from
+  // the maximal numbers of events (e.g. candidates with NaN values)
+  const double sum_of_sig_weights = n_sig_events_.back();
+  const double sum_of_bkg_weights = n_bkg_events_.back();
+
+  // every sample is drawn from its own generator and written to its own
+  // slot, so samples can be computed in any order by any thread
+  std::atomic<unsigned int> next_sample(0);
+  auto bootstrap = [&](){
+    std::vector<double> signal_weights(signal_weights_.size());
+    std::vector<double> background_weights(background_weights_.size());
+    std::vector<double> n_sig_events, n_bkg_events, fom_values;
+    for (unsigned int s = next_sample++; s < num_samples; s = next_sample++){
+      std::seed_seq seed_sequence = {seed, s};
+      std::mt19937_64 generator(seed_sequence);
+      std::poisson_distribution<int> poisson(1.);
+      for (std::size_t i = 0; i < signal_weights.size(); ++i){
+        const int multiplicity = poisson(generator);
+        signal_weights[i] = multiplicity*signal_weights_[i];
+        background_weights[i] = multiplicity*background_weights_[i];
+      }
+      CumulativeSums(signal_weights, background_weights, n_sig_events, n_bkg_events);
+      const double max_n_sig_events = (sum_of_sig_weights != 0.) ? max_n_sig_events_*n_sig_events.back()/sum_of_sig_weights : max_n_sig_events_;
+      const double max_n_bkg_events = (sum_of_bkg_weights != 0.) ? max_n_bkg_events_*n_bkg_events.back()/sum_of_bkg_weights : max_n_bkg_events_;
+
+      sample_aucs[s] = Auc(n_sig_events, n_bkg_events, max_n_sig_events, max_n_bkg_events);
+      for (std::size_t t = 0; t < types.size(); ++t){
+        FoM::FigureOfMerit(types[t], n_sig_events, n_bkg_events, max_n_sig_events, max_n_bkg_events, fom_values, false);
+        std::size_t maximum = Maximum(fom_values);
+        sample_fom_values[t][s] = (maximum < fom_values.size()) ? fom_values[maximum] : std::numeric_limits<double>::quiet_NaN();
+        sample_cut_values[t][s] = (maximum < fom_values.size()) ? cut_values_[maximum] : std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  };
+
+  doocore::io::sinfo << "RocEngine::Bootstrap(...): Computing " << num_samples << " bootstrap samples in " << num_threads << " threads" << doocore::io::endmsg;
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < num_threads; ++i){
+    threads.push_back(std::thread(bootstrap));
+  }
+  bootstrap();
+  for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread){
+    (*thread).join();
+  }
+
+  auc_error_ = StandardDeviation(sample_aucs);
+  for (std::size_t t = 0; t < types.size(); ++t){
+    optima_[types[t]].fom_value_error = StandardDeviation(sample_fom_values[t]);
+    optima_[types[t]].cut_value_error = StandardDeviation(sample_cut_values[t]);
+  }
+  num_bootstrap_samples_ = num_samples;
+}
+
+std::vector<double> RocEngine::signal_efficiency() const{
+  std::vector<double> signal_efficiency;
+  FoM::FigureOfMerit(FoMType::SignalEfficiency, n_sig_events_, n_bkg_events_, max_n_sig_events_, max_n_bkg_events_, signal_efficiency);
+  return signal_efficiency;
+}
+
+std::vector<double> RocEngine::background_rejection() const{
+  std::vector<double> background_rejection;
+  FoM::FigureOfMerit(FoMType::BackgroundRejection, n_sig_events_, n_bkg_events_, max_n_sig_events_, max_n_bkg_events_, background_rejection);
+  return background_rejection;
+}
+
+std::vector<double> RocEngine::fom_values(FoMType figure_of_merit) const{
+  std::vector<double> fom_values;
+  FoM::FigureOfMerit(figure_of_merit, n_sig_events_, n_bkg_events_, max_n_sig_events_, max_n_bkg_events_, fom_values);
+  return fom_values;
+}
+
+RocEngine::Optimum RocEngine::optimum(FoMType figure_of_merit) const{
+  return optima_.at(figure_of_merit);
+}
+
+void RocEngine::CumulativeSums(const std::vector<double>& signal_weights, const std::vector<double>& background_weights, std::vector<double>& n_sig_events, std::vector<double>& n_bkg_events) const{
+  n_sig_events.resize(group_ends_.size());
+  n_bkg_events.resize(group_ends_.size());
+  double sum_sig = 0., sum_bkg = 0.;
+  std::size_t i = 0;
+  for (std::size_t k = 0; k < group_ends_.size(); ++k){
+    for (; i < group_ends_[k]; ++i){
+      sum_sig += signal_weights[i];
+      sum_bkg += background_weights[i];
+    }
+    n_sig_events[k] = sum_sig;
+    n_bkg_events[k] = sum_bkg;
+  }
+}
+
+std::size_t RocEngine::Maximum(const std::vector<double>& fom_values){
+  std::size_t maximum = fom_values.size();
+  for (std::size_t k = 0; k < fom_values.size(); ++k){
+    if (std::isnan(fom_values[k])) continue;
+    if (maximum == fom_values.size() || fom_values[k] > fom_values[maximum]) maximum = k;
+  }
+  return maximum;
+}
+
+double RocEngine::Auc(const std::vector<double>& n_sig_events, const std::vector<double>& n_bkg_events, double max_n_sig_events, double max_n_bkg_events){
+  // trapezoids between consecutive cut values, starting with no candidate
+  // passing (signal efficiency 0, background rejection 1); ties are exact,
+  // as candidates with the same value always pass together
+  double auc = 0.;
+  double previous_efficiency = 0., previous_rejection = 1.;
+  for (std::size_t k = 0; k < n_sig_events.size(); ++k){
+    const double efficiency = FoM::SignalEfficiency(n_sig_events[k], max_n_sig_events);
+    const double rejection = FoM::BackgroundRejection(n_bkg_events[k], max_n_bkg_events);
+    auc += (efficiency-previous_efficiency)*(rejection+previous_rejection)/2.;
+    previous_efficiency = efficiency;
+    previous_rejection = rejection;
+  }
+  return auc;
+}
+
+} // namespace triage
+} // namespace dooselection
@@ -0,0 +1,94 @@
+#ifndef TRIAGE_ROCENGINE_H
+#define TRIAGE_ROCENGINE_H
+
+// from STL
+#include <map>
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from DooCore
+
+// from here
+#include "FoM.h"
+
+// forward declarations
+
+namespace dooselection{
+namespace triage{
+
+/// Exact, unbinned ROC curve and figures of merit of a classifier.
+/// The candidates are sorted once in the direction of the cut; the number of signal and background
+/// events passing the cut, the ROC curve, its area and the maxima of all figures of merit are then
+/// computed at every distinct classifier value. Uncertainties of the maxima are obtained by bootstrapping.
+class RocEngine{
+ public:
+  /// Maximum of a figure of merit and the corresponding cut value
+  struct Optimum{
+    double fom_value;
+    double cut_value;
+    double fom_value_error;                             ///< standard deviation over bootstrap samples (0 without bootstrap)
+    double cut_value_error;                             ///< standard deviation over bootstrap samples (0 without bootstrap)
+  };
+
+  /// Candidates are given by their classifier values and signal/background weights (MC truth as 0 or 1, or sWeights).
+  /// The cut operator has to be one of >, >=, <, <=, candidates with NaN classifier values never pass the cut.
+  RocEngine(const std::vector<double>& values, const std::vector<double>& signal_weights, const std::vector<double>& background_weights, const std::string& cut_operator, double max_n_sig_events, double max_n_bkg_events);
+
+  /// Estimates the uncertainties of the optima and the ROC area from num_samples Poisson bootstrap samples, computed in num_threads threads.
+  /// The results only depend on the seed, not on the number of threads.
+  void Bootstrap(unsigned int num_samples, unsigned int num_threads, unsigned int seed=0);
+
+  // getter
+  /// Cut values, one per distinct classifier value. Applying a cut value with the cut operator selects exactly the candidates
+  /// with this or a tighter classifier value.
+  const std::vector<double>& cut_values() const{return cut_values_;}
+  const std::vector<double>& n_sig_events() const{return n_sig_events_;}
+  const std::vector<double>& n_bkg_events() const{return n_bkg_events_;}
+  double max_n_sig_events() const{return max_n_sig_events_;}
+  double max_n_bkg_events() const{return max_n_bkg_events_;}
+  std::vector<double> signal_efficiency() const;
+  std::vector<double> background_rejection() const;
+  std::vector<double> fom_values(FoMType figure_of_merit) const;
+  /// Area under the ROC curve (background rejection vs. signal efficiency)
+  double auc() const{return auc_;}
+  double auc_error() const{return auc_error_;}
+  Optimum optimum(FoMType figure_of_merit) const;
+  unsigned int num_bootstrap_samples() const{return num_bootstrap_samples_;}
+
+ private:
+  /// Number of events passing each cut value for given weights (in the sorted order)
+  void CumulativeSums(const std::vector<double>& signal_weights, const std::vector<double>& background_weights, std::vector<double>& n_sig_events, std::vector<double>& n_bkg_events) const;
+
+  /// Index of the maximum of the figure of merit values (NaN values are ignored, size() if there is none)
+  static std::size_t Maximum(const std::vector<double>& fom_values);
+
+  static double Auc(const std::vector<double>& n_sig_events, const std::vector<double>& n_bkg_events, double max_n_sig_events, double max_n_bkg_events);
+
+  std::vector<double> signal_weights_;                  ///< in the order of passing the cut
+  std::vector<double> background_weights_;              ///< in the order of passing the cut
+  std::vector<std::size_t> group_ends_;                 ///< per cut value, number of candidates passing it
+
+  std::vector<double> cut_values_;
+  std::vector<double> n_sig_events_;
+  std::vector<double> n_bkg_events_;
+  double max_n_sig_events_;
+  double max_n_bkg_events_;
+
+  double auc_;
+  double auc_error_;
+  std::map<FoMType, Optimum> optima_;
+  unsigned int num_bootstrap_samples_;
+};
+
+} // namespace triage
+} // namespace dooselection
+
+#endif // TRIAGE_ROCENGINE_H
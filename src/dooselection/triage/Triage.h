@@ -2,6 +2,10 @@
 #define TRIAGE_TRIAGE_H
 
 // from STL
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 // from ROOT
 
@@ -17,9 +21,17 @@
 #include "TupleList.h"
 #include "ClassifierList.h"
 #include "TriageHistContainer.h"
+#include "RocEngine.h"
 
 // forward declarations
 class TH1D;
+class RooArgSet;
+
+namespace dooselection{
+namespace triage{
+class BackgroundRenderer;
+} // namespace triage
+} // namespace dooselection
 
 namespace dooselection{
 namespace triage{
@@ -37,7 +49,11 @@ class Triage{
     classifier_list_(),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(debug_mode)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(debug_mode),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     tuple_list_.Add(tuple);
     classifier_list_.Add(classifier);
@@ -48,7 +64,11 @@ class Triage{
     classifier_list_(),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(false)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(false),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     tuple_list_.Add(tuple);
     classifier_list_.Add(classifier);
@@ -59,7 +79,11 @@ class Triage{
     classifier_list_(classifier_list),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(debug_mode)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(debug_mode),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     tuple_list_.Add(tuple);
   }
@@ -69,7 +93,11 @@ class Triage{
     classifier_list_(classifier_list),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(false)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(false),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     tuple_list_.Add(tuple);
   }
@@ -79,7 +107,11 @@ class Triage{
     classifier_list_(),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(debug_mode)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(debug_mode),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     classifier_list_.Add(classifier);
   }
@@ -89,7 +121,11 @@ class Triage{
     classifier_list_(),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(false)
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(false),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_("")
   {
     classifier_list_.Add(classifier);
   }
@@ -99,14 +135,22 @@ class Triage{
     classifier_list_(classifier_list),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(debug_mode){}
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(debug_mode),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_(""){}
 
   Triage(TupleList& tuple_list, ClassifierList& classifier_list):
     tuple_list_(tuple_list),
     classifier_list_(classifier_list),
     nbins_(0),
     hist_container_list_filled_(false),
-    debug_mode_(false){}
+    num_threads_(1),
+    num_bootstrap_samples_(100),
+    debug_mode_(false),
+    fit_handover_filename_("TriageHandoverFitParameter.txt"),
+    fit_output_prefix_(""){}
 
   ~Triage(){}
 
@@ -120,8 +164,12 @@ class Triage{
 
   /// Plots mass distribution for all tuples using the best cut for each classifier.
   /// The plots show the mass distribution before and after the cut. The efficiencies 
-  /// for the best cut are calculated.
+  /// for the best cut are calculated. The histograms of all classifiers of a tuple are filled
+  /// in one pass and the plots are rendered in up to num_threads_ background processes.
   void BestCutPerformances(PlotStyle plot_style=PlotStyle::All);
+
+  /// Optimizes the cuts on all classifiers jointly for every tuple, see OptimizeCuts(Tuple*, ...).
+  void CutOptimizations(const std::string& figure_of_merit, int num_grid_points=10, int num_refinements=5);
   /// }
 
 
@@ -134,6 +182,12 @@ class Triage{
   /// for the best cut are calculated.
   void BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle plot_style=PlotStyle::All);
 
+  /// Optimizes the cuts on all classifiers jointly for a MC or sWeighted tuple, maximizing a figure of merit from FoM.
+  /// The classifier values are read once into memory. The cut space (classifier ranges, cut operators >, >=, <, <=) is
+  /// scanned on a grid of num_grid_points per classifier, which is refined num_refinements times around the best point.
+  /// Cut vectors are evaluated in num_threads_ threads. The best cut values are set in the classifiers and returned.
+  std::vector<double> OptimizeCuts(Tuple* tuple, const std::string& figure_of_merit, int num_grid_points=10, int num_refinements=5);
+
   /// Calculates and plots the efficiencies, ROC curve, etc. for all tuples and classifiers
   void PerformanceScans();
 
@@ -145,6 +199,10 @@ class Triage{
   void PlotBackgroundRejection(std::string name, std::pair<TH1D, TH1D> hist_number_sig_bkg_events, std::vector<double> cut_steps, double max_n_bkg_events);
   /// Plots all efficiency distributions
   void PlotEfficiencies(std::string name, std::pair<TH1D, TH1D> hist_number_sig_bkg_events, std::vector<double> cut_steps, double max_n_sig_events, double max_n_bkg_events);
+  /// Plots the exact ROC curve
+  void PlotROC(std::string name, const RocEngine& roc_engine);
+  /// Plots all efficiency distributions at every distinct classifier value, with bootstrap uncertainties of the optimal cuts
+  void PlotEfficiencies(std::string name, const RocEngine& roc_engine);
   /// }
 
   /// { getter
@@ -155,6 +213,13 @@ class Triage{
   /// { setter
   void set_debug_mode(bool debug_mode) {debug_mode_ = debug_mode;}
   void set_nbins(const int nbins) {nbins_ = nbins;}
+  /// Number of threads to read tuples with. With more than one thread, all classifiers of a
+  /// tuple are read in a single pass and independent tuples are read in parallel, only the
+  /// histogramming and plotting is done serially afterwards (default: 1).
+  void set_num_threads(unsigned int num_threads) {num_threads_ = num_threads > 0 ? num_threads : 1;}
+  /// Number of bootstrap samples for the uncertainties of the optimal cuts, 0 to disable (default: 100).
+  /// The samples are computed in num_threads_ threads.
+  void set_num_bootstrap_samples(unsigned int num_bootstrap_samples) {num_bootstrap_samples_ = num_bootstrap_samples;}
   /// }
 
  private:
@@ -170,12 +235,100 @@ class Triage{
 
   /// MOST BASIC METHOD
   /// Given a specific cut this method computes the number of events in the tuple
-  /// WARNING: at the moment this only works with sWeighted data!
+  /// (number of MC events, sum of sWeights or fitted yields)
   std::pair<double, double> NumberOfSigAndBkgEvents(Tuple* tuple, const std::string& cut_string);
   
+  /// Classifier value and signal/background weight (MC truth as 0 or 1, or sWeights) of one event
+  struct ScanEvent{
+    double value;
+    double signal_weight;
+    double background_weight;
+  };
+
+  /// Events of a tuple in the observable range for several classifiers, read in a single pass
+  struct TupleScan{
+    double sum_of_sig_weights;                          ///< number of signal events without classifier cut
+    double sum_of_bkg_weights;                          ///< number of background events without classifier cut
+    std::vector< std::vector<ScanEvent> > events;       ///< events per classifier, sorted by classifier value (NaN values excluded)
+    std::vector<char> valid;                            ///< per classifier, whether it could be read (scalar expression)
+  };
+
   /// This method fills two histograms with the number of signal and background events, depending on a given cut on the classifier
-  /// It uses NumberOfSigAndBkgEvents to perform this task.
-  std::pair<TH1D, TH1D> SigAndBkgEventNumbersHistogram(Tuple* tuple, Classifier* classifier, const int nbins);
+  /// It uses NumberOfSigAndBkgEvents to perform this task, or the already read events of the classifier if given.
+  /// If roc_engine is given, it is set to the exact ROC/FoM engine of the read events (NULL if no events could be read).
+  std::pair<TH1D, TH1D> SigAndBkgEventNumbersHistogram(Tuple* tuple, Classifier* classifier, const int nbins, const std::vector<ScanEvent>* events=NULL, std::shared_ptr<RocEngine>* roc_engine=NULL);
+
+  /// This method reads the events of a MC or sWeighted tuple for all given classifiers in one pass over the tuple.
+  /// Returns false for other tuples or if the observable range or weights cannot be read this way.
+  /// This method can be called for different tuples in parallel.
+  bool ReadTupleScan(Tuple* tuple, const std::vector<Classifier*>& classifiers, TupleScan& scan);
+
+  /// This method reads the values of all given classifiers and the signal/background weights of all events of a MC or sWeighted
+  /// tuple in the observable range in one pass, as one column per classifier. Returns false for other tuples or array-valued expressions.
+  bool ReadTupleColumns(Tuple* tuple, const std::vector<Classifier*>& classifiers, std::vector< std::vector<double> >& columns, std::vector<double>& signal_weights, std::vector<double>& background_weights);
+
+  /// This method reads all tuples for all classifiers using ReadTupleScan in num_threads_ threads.
+  /// scanned is set per tuple to whether ReadTupleScan succeeded.
+  std::vector<TupleScan> ReadTupleScans(std::vector<char>& scanned);
+
+  /// This method computes the number of signal and background events and the sums of squared weights for all cut values from
+  /// sorted events. Returns false if the cut operator is not one of >, >=, <, <=.
+  static bool CumulativeSums(const std::vector<ScanEvent>& events, const std::string& cut_operator, const std::vector<double>& cut_values, std::vector< std::pair<double, double> >& number_of_events, std::vector< std::pair<double, double> >& sum_of_squared_weights);
+
+  /// Classifier distribution from already read events (histogram limits are computed from the whole tuple as for the serial path)
+  void ClassifierDistribution(Tuple* tuple, Classifier* classifier, const int nbins, const std::vector<ScanEvent>& events);
+
+  /// Draws and prints the signal and background classifier distributions
+  void PlotClassifierDistribution(Tuple* tuple, Classifier* classifier, TH1D* sig_hist, TH1D* bkg_hist);
+
+  /// Start parameters for the next fit of a fit-based tuple, i.e. the result of the previous fit
+  struct FitHandover{
+    std::shared_ptr<RooArgSet> parameters;              ///< fitted parameters (FTTuple, kept in memory)
+    std::string parameters_file;                        ///< file with fitted parameters (AbsFitterTuple, the fitter only reads files)
+  };
+
+  /// This method fits a FTTuple or AbsFitterTuple with a given cut and returns the signal and background yields.
+  /// The fit starts from the parameters of the previous fit of this tuple (or the 'no cut' starting values) and
+  /// stores its result as start parameters for the next one. Results are read from/written to the fit cache if set.
+  std::pair<double, double> FitSigAndBkgEvents(Tuple* tuple, const std::string& cut_string);
+
+  /// This method fits all given cuts in up to num_processes concurrent processes. Each fit starts from the result
+  /// of the nearest already finished cut point (or the fit without cut).
+  std::vector< std::pair<double, double> > ParallelFitSigAndBkgEvents(Tuple* tuple, const std::vector<std::string>& cut_strings, unsigned int num_processes);
+
+  /// File name prefix of the fit cache entry for a tuple and cut ("" if no cache is used). The prefix contains a
+  /// hash of the input file (path, size and modification time), tree name, global cut and cut, the pdf (FTTuple) or
+  /// cache tag (AbsFitterTuple), the fit options and the starting values file.
+  std::string FitCachePrefix(Tuple* tuple, const std::string& cut_string) const;
+
+  /// Reads yields and parameters of a fit result written by WriteFitResult. Returns false if there is none.
+  bool ReadFitResult(Tuple* tuple, const std::string& prefix, std::pair<double, double>& number_of_events, FitHandover& handover);
+
+  /// Writes yields and parameters of the last fit of a tuple
+  void WriteFitResult(Tuple* tuple, const std::string& prefix, const std::pair<double, double>& number_of_events);
+
+  /// Best cut performance with already computed number of signal and background events (NULL to compute them).
+  /// The observable histograms are taken from BestCutHistContainer (filled if needed), plots are rendered by renderer.
+  void BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle plot_style, const std::pair<double, double>* precomputed_number_sig_bkg_events, BackgroundRenderer& renderer);
+
+  /// Container of the observable histograms for a tuple and classifier (created if needed)
+  TriageHistContainer& BestCutHistContainer(Tuple* tuple, Classifier* classifier);
+
+  /// Fills the observable histograms with and without best cut for all given classifiers of a tuple in a single pass
+  /// over the tuple, unless the containers already hold them for the current best cuts.
+  void FillBestCutHists(Tuple* tuple, const std::vector<Classifier*>& classifiers);
+
+  /// This method fills one histogram of the observable (in its range plus a margin) per selection in a single pass
+  /// over the tuple. An empty selection selects all entries.
+  std::vector< std::shared_ptr<TH1D> > ObservableHistograms(Tuple* tuple, const std::vector<std::string>& selections, int nbins);
+
+  /// This method computes the number of signal and background events for all cut values of a classifier in a single pass over the tuple.
+  /// The classifier values and weights (MC truth or sWeights) are read once and sorted, the number of events passing each cut and the
+  /// sum of squared weights (for uncertainties) is then obtained by cumulative sums. The results are identical to calling
+  /// NumberOfSigAndBkgEvents for every cut.
+  /// Returns false if this is not possible (fit tuple, array-valued expressions or cut operator other than >, >=, <, <=).
+  /// The read events are returned in events if given.
+  bool CumulativeSigAndBkgEventNumbers(Tuple* tuple, Classifier* classifier, const std::vector<double>& cut_values, std::vector< std::pair<double, double> >& number_of_events, std::vector< std::pair<double, double> >& sum_of_squared_weights, std::vector<ScanEvent>* events=NULL);
 
   TupleList tuple_list_;
   ClassifierList classifier_list_;
@@ -183,9 +336,20 @@ class Triage{
   int nbins_;
 
   bool hist_container_list_filled_;
+  unsigned int num_threads_;
+  unsigned int num_bootstrap_samples_;
   bool debug_mode_;
 
   std::vector<TriageHistContainer> hist_container_list_;
+  /// Observable histograms for the best cut plots
+  std::vector<TriageHistContainer> best_cut_hist_container_list_;
+
+  /// Start parameters for the next fit per fit-based tuple
+  std::map<const Tuple*, FitHandover> fit_handovers_;
+  /// File AbsFitterTuple fits write their parameters to
+  std::string fit_handover_filename_;
+  /// Prefix of the starting values and fit result files of FTTuple fits ("" for the working directory)
+  std::string fit_output_prefix_;
 };
 
 } // namespace triage
@@ -1,9 +1,13 @@
 #include "Triage.h"
 
 // from STL
+#include <iterator>
+#include <memory>
 
 // from ROOT
 #include "TCanvas.h"
+#include "TH1D.h"
+#include "TLatex.h"
 #include "TTree.h"
 #include "TStyle.h"
 
@@ -23,53 +27,130 @@
 #include "SWTuple.h"
 #include "FTTuple.h"
 #include "FoM.h"
+#include "BackgroundRenderer.h"
 
 // forward declarations
 
 namespace dooselection{
 namespace triage{
 
+namespace {
+/// Cut string of the best cut of a classifier
+std::string BestCutString(const Classifier* classifier){
+  if (((classifier->cut_operator())=="") && ((classifier->best_cut_value())<=-99998.)){
+    return classifier->expression();
+  }
+  else{
+    return classifier->expression()+classifier->cut_operator()+std::to_string(classifier->best_cut_value());
+  }
+}
+
+/// Selection of the observable range
+std::string ObservableRange(const Tuple* tuple){
+  return "((" + tuple->observable_name() + ">" + std::to_string(tuple->observable_range().first) + ")&&(" + tuple->observable_name() + "<" + std::to_string(tuple->observable_range().second) + "))";
+}
+} // namespace
+
 void Triage::BestCutPerformances(PlotStyle plot_style){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::BestCutPerformances() \t" << doocore::io::endmsg;
-  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++){
-    MaximalNumberOfEvents(*tuple);
-    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
-      BestCutPerformance(*tuple, &(*classifier), plot_style);
+  std::vector<char> scanned(std::distance(tuple_list_.begin(), tuple_list_.end()), 0);
+  std::vector<TupleScan> scans;
+  if (num_threads_ > 1) scans = ReadTupleScans(scanned);
+
+  std::vector<Classifier*> classifiers;
+  for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
+    classifiers.push_back(&(*classifier));
+  }
+
+  // plots are rendered while the next classifiers and tuples are processed
+  BackgroundRenderer renderer(num_threads_);
+  std::size_t t = 0;
+  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++, t++){
+    if (scanned[t]){
+      (*tuple)->set_max_n_sig_events(scans[t].sum_of_sig_weights);
+      (*tuple)->set_max_n_bkg_events(scans[t].sum_of_bkg_weights);
+    }
+    else{
+      MaximalNumberOfEvents(*tuple);
+    }
+    FillBestCutHists(*tuple, classifiers);
+
+    std::size_t c = 0;
+    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++, c++){
+      std::vector< std::pair<double, double> > number_sig_bkg_events;
+      std::vector< std::pair<double, double> > sum_of_squared_weights;
+      if (scanned[t] && scans[t].valid[c] && CumulativeSums(scans[t].events[c], (*classifier).cut_operator(), std::vector<double>(1, (*classifier).best_cut_value()), number_sig_bkg_events, sum_of_squared_weights)){
+        BestCutPerformance(*tuple, &(*classifier), plot_style, &(number_sig_bkg_events[0]), renderer);
+      }
+      else{
+        BestCutPerformance(*tuple, &(*classifier), plot_style, NULL, renderer);
+      }
     }
   }
+  renderer.Wait();
 }
 
 void Triage::BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle plot_style){
+  BackgroundRenderer renderer(0);
+  FillBestCutHists(tuple, std::vector<Classifier*>(1, classifier));
+  BestCutPerformance(tuple, classifier, plot_style, NULL, renderer);
+}
+
+TriageHistContainer& Triage::BestCutHistContainer(Tuple* tuple, Classifier* classifier){
+  for (std::vector<TriageHistContainer>::iterator container = best_cut_hist_container_list_.begin(); container != best_cut_hist_container_list_.end(); ++container){
+    if ((*container).tuple() == tuple && (*container).classifier() == classifier) return *container;
+  }
+  best_cut_hist_container_list_.push_back(TriageHistContainer(tuple->name()+"_"+classifier->name()+"_BestCut", tuple, classifier));
+  return best_cut_hist_container_list_.back();
+}
+
+void Triage::FillBestCutHists(Tuple* tuple, const std::vector<Classifier*>& classifiers){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::FillBestCutHists(Tuple* tuple, const std::vector<Classifier*>& classifiers) \t" << doocore::io::endmsg;
+  // the histogram without classifier cut is the same for all classifiers
+  std::string observable_range = ObservableRange(tuple);
+  std::vector<std::string> selections(1, observable_range);
+  std::vector<Classifier*> fill_classifiers;
+  for (std::vector<Classifier*>::const_iterator classifier = classifiers.begin(); classifier != classifiers.end(); ++classifier){
+    const TriageHistContainer& container = BestCutHistContainer(tuple, *classifier);
+    std::string cut_string = BestCutString(*classifier);
+    if (container.hist_observable_with_cuts() && container.observable_cut_string() == cut_string) continue;
+
+    std::string selection = observable_range;
+    if (cut_string != "") selection += "&&(" + cut_string + ")";
+    selections.push_back(selection);
+    fill_classifiers.push_back(*classifier);
+  }
+  if (fill_classifiers.empty()) return;
+
+  doocore::io::sinfo << "Triage::FillBestCutHists(...): Filling observable histograms of " << fill_classifiers.size() << " classifiers for tuple '" << tuple->name() << "'" << doocore::io::endmsg;
+  std::vector< std::shared_ptr<TH1D> > hists = ObservableHistograms(tuple, selections, 100);
+  for (std::size_t c = 0; c < fill_classifiers.size(); ++c){
+    BestCutHistContainer(tuple, fill_classifiers[c]).set_observable_hists(BestCutString(fill_classifiers[c]), hists[0], hists[c+1]);
+  }
+}
+
+void Triage::BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle plot_style, const std::pair<double, double>* precomputed_number_sig_bkg_events, BackgroundRenderer& renderer){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::BestCutPerformance(Tuple* tuple, Classifier* classifier) \t" << doocore::io::endmsg;
   doocore::lutils::setStyle("LHCb");
 
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "classifier "<< classifier->name() << doocore::io::endmsg;
 
-  std::string cut_string("");
-
-  if (((classifier->cut_operator())=="") && ((classifier->best_cut_value())<=-99998.)){
-    cut_string = classifier->expression();
-  }
-  else{
-    cut_string = classifier->expression()+classifier->cut_operator()+std::to_string(classifier->best_cut_value());
-  } 
-  std::string interim_cutstring = cut_string;
+  std::string cut_string = BestCutString(classifier);
 
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "cut string "<< cut_string << doocore::io::endmsg;
-  
-  double margin = (tuple->observable_range().second-tuple->observable_range().first)*0.1;
-
-  std::string observable_range = "((" + tuple->observable_name() + ">" + std::to_string(tuple->observable_range().first) + ")&&(" + tuple->observable_name() + "<" + std::to_string(tuple->observable_range().second) + "))";
-  interim_cutstring = observable_range;
-  if (cut_string != "") interim_cutstring += "&&(" + cut_string + ")";
 
   doocore::io::sdebug << "-debug- \t" << "Check correct mass variable! (" << tuple->observable_name() << ")" << doocore::io::endmsg;
   doocore::io::sdebug << "-debug- \t" << "Check correct mass range! (min: " << tuple->observable_range().first << ", max: " << tuple->observable_range().second << ")" << doocore::io::endmsg;
 
-  TH1D* hist_without_cuts = new TH1D("hist_without_cuts", "hist_without_cuts", 100, tuple->observable_range().first-margin, tuple->observable_range().second+margin);
-  TH1D* hist_with_cuts = new TH1D("hist_with_cuts", "hist_with_cuts", 100, tuple->observable_range().first-margin, tuple->observable_range().second+margin);
+  // histograms filled once per best cut, see FillBestCutHists
+  const TriageHistContainer& container = BestCutHistContainer(tuple, classifier);
+  if (!container.hist_observable_with_cuts() || container.observable_cut_string() != cut_string){
+    FillBestCutHists(tuple, std::vector<Classifier*>(1, classifier));
+  }
+  std::shared_ptr<TH1D> hist_without_cuts = container.hist_observable_without_cuts();
+  std::shared_ptr<TH1D> hist_with_cuts = container.hist_observable_with_cuts();
 
-  std::pair<double, double> number_sig_bkg_events = NumberOfSigAndBkgEvents(tuple, cut_string);
+  std::pair<double, double> number_sig_bkg_events = (precomputed_number_sig_bkg_events != NULL) ? *precomputed_number_sig_bkg_events : NumberOfSigAndBkgEvents(tuple, cut_string);
 
   double n_signal_events = number_sig_bkg_events.first;
   double n_background_events = number_sig_bkg_events.second;
@@ -79,27 +160,6 @@ void Triage::BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle
   double significance = FoM::Significance(n_signal_events, n_background_events);
   double sin2beta = FoM::Sin2Beta(n_signal_events, n_background_events);
 
-  // plot
-  TCanvas* canvas= new TCanvas("canvas", "canvas", 800, 600);
-
-  tuple->tree().Draw(TString(tuple->observable_name())+">>hist_without_cuts", TString(observable_range));
-  
-  hist_without_cuts->SetLineColor(kBlack);
-  hist_without_cuts->SetMinimum(0);
-  hist_without_cuts->SetXTitle(TString(tuple->observable_label())+" ("+TString(tuple->observable_unit())+")");
-  hist_without_cuts->SetYTitle(TString::Format("Candidates / ( %4.2f %s )", hist_without_cuts->GetBinWidth(1), tuple->observable_unit().c_str()));
-  hist_without_cuts->GetXaxis()->SetTitleSize(0.055);
-  hist_without_cuts->GetXaxis()->SetTitleOffset(1.25);
-  hist_without_cuts->GetYaxis()->SetTitleSize(0.05);
-  hist_without_cuts->GetYaxis()->SetTitleOffset(1.5);
-
-  tuple->tree().Draw(TString(tuple->observable_name())+">>hist_with_cuts", TString(interim_cutstring), "same");
-  
-  hist_with_cuts->SetLineColor(kBlue);
-  hist_with_cuts->SetLineStyle(3);
-  hist_with_cuts->SetFillColor(kBlue);
-  hist_with_cuts->SetFillStyle(3003);
-
   TString label;
   if (plot_style==PlotStyle::All){
     label = Form(TString("#splitline{#splitline{#splitline{#splitline{#splitline{#splitline{#bf{")+ classifier->name() +"}}{Cut: "+cut_string+"}}{Signal events: %.0f}}{Background events: %.0f}}{Signal efficiency: %.2f %}}{Background Rejection: %.2f %}}{#splitline{Significance: %.3f}{sin2#beta FoM: %.3f}}", n_signal_events, n_background_events, signal_efficiency*100, background_rejection*100, significance, sin2beta);
@@ -107,35 +167,57 @@ void Triage::BestCutPerformance(Tuple* tuple, Classifier* classifier, PlotStyle
   else if (plot_style==PlotStyle::NameOnly){
     label = Form(TString("#bf{")+classifier->name()+"}");
   }
-  TLatex latex_label(0.2, 0.74, label);
-  latex_label.SetNDC();
-  latex_label.SetTextSize(0.02);
-  latex_label.SetTextColor(1);
-  latex_label.SetTextAlign(11);
-  if (!(plot_style==PlotStyle::Nothing)) latex_label.Draw();
-
-  doocore::lutils::printPlot(canvas, "BestCut_"+tuple->name()+"_"+classifier->name(), "BestCut/");
-
-  // plot logarithmic
-  TCanvas* canvas_log = new TCanvas("canvas_log", "canvas_log", 800, 600);
-  if (true){
-    canvas_log->SetLogy();
 
-    tuple->tree().Draw(TString(tuple->observable_name())+">>hist_without_cuts", TString(observable_range));
-    
-    hist_without_cuts->SetMinimum(10);
+  // plot (in the background, on copies of the histograms)
+  std::string plot_name = "BestCut_"+tuple->name()+"_"+classifier->name();
+  std::string observable_title = tuple->observable_label()+" ("+tuple->observable_unit()+")";
+  std::string observable_unit = tuple->observable_unit();
+  renderer.Submit([=](){
+    TH1D hist_without(*hist_without_cuts);
+    TH1D hist_with(*hist_with_cuts);
+
+    TCanvas* canvas= new TCanvas("canvas", "canvas", 800, 600);
+
+    hist_without.SetLineColor(kBlack);
+    hist_without.SetMinimum(0);
+    hist_without.SetXTitle(observable_title.c_str());
+    hist_without.SetYTitle(TString::Format("Candidates / ( %4.2f %s )", hist_without.GetBinWidth(1), observable_unit.c_str()));
+    hist_without.GetXaxis()->SetTitleSize(0.055);
+    hist_without.GetXaxis()->SetTitleOffset(1.25);
+    hist_without.GetYaxis()->SetTitleSize(0.05);
+    hist_without.GetYaxis()->SetTitleOffset(1.5);
+    hist_without.SetStats(false);
+    hist_without.SetTitle("hist_without_cuts");
+    hist_without.Draw();
+
+    hist_with.SetLineColor(kBlue);
+    hist_with.SetLineStyle(3);
+    hist_with.SetFillColor(kBlue);
+    hist_with.SetFillStyle(3003);
+    hist_with.Draw("same");
+
+    TLatex latex_label(0.2, 0.74, label);
+    latex_label.SetNDC();
+    latex_label.SetTextSize(0.02);
+    latex_label.SetTextColor(1);
+    latex_label.SetTextAlign(11);
+    if (!(plot_style==PlotStyle::Nothing)) latex_label.Draw();
 
-    tuple->tree().Draw(TString(tuple->observable_name())+">>hist_with_cuts", TString(interim_cutstring), "same");
+    doocore::lutils::printPlot(canvas, plot_name, "BestCut/");
 
+    // plot logarithmic
+    TCanvas* canvas_log = new TCanvas("canvas_log", "canvas_log", 800, 600);
+    canvas_log->SetLogy();
+    hist_without.SetMinimum(10);
+    hist_without.Draw();
+    hist_with.Draw("same");
     if (!(plot_style==PlotStyle::Nothing)) latex_label.Draw();
 
-    doocore::lutils::printPlot(canvas_log, "BestCut_"+tuple->name()+"_"+classifier->name()+"_log", "BestCut/");
-  }
+    doocore::lutils::printPlot(canvas_log, plot_name+"_log", "BestCut/");
 
-  delete hist_without_cuts;
-  delete hist_with_cuts;
-  delete canvas;
-  delete canvas_log;
+    delete canvas;
+    delete canvas_log;
+  });
 }
 
 } // namespace triage
@@ -1,6 +1,7 @@
 #include "Triage.h"
 
 // from STL
+#include <iterator>
 
 // from ROOT
 #include "TCanvas.h"
@@ -30,13 +31,75 @@ namespace triage{
 
 void Triage::ClassifierDistributions(const int nbins){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void ClassifierDistributions(const int nbins) \t" << doocore::io::endmsg;
-  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++){
-    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
-      ClassifierDistribution(*tuple, &(*classifier), nbins);
+  std::vector<char> scanned(std::distance(tuple_list_.begin(), tuple_list_.end()), 0);
+  std::vector<TupleScan> scans;
+  if (num_threads_ > 1) scans = ReadTupleScans(scanned);
+
+  std::size_t t = 0;
+  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++, t++){
+    std::size_t c = 0;
+    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++, c++){
+      if (scanned[t] && scans[t].valid[c]){
+        ClassifierDistribution(*tuple, &(*classifier), nbins, scans[t].events[c]);
+      }
+      else{
+        ClassifierDistribution(*tuple, &(*classifier), nbins);
+      }
     }
   }
 }
 
+void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const int nbins, const std::vector<ScanEvent>& events){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const int nbins, const std::vector<ScanEvent>& events) \t" << doocore::io::endmsg;
+  doocore::lutils::setStyle("LHCb");
+
+  std::pair<double,double> minmax = classifier->range();
+  // limits from all entries of the tuple, as in the serial path (the events
+  // are only those in the observable range)
+  if (tuple->is_sw() || (minmax.first == 0. && minmax.second == 0.)){
+    minmax = doocore::lutils::MedianLimitsForTuple(tuple->tree(), classifier->expression());
+  }
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "min " << minmax.first << " max " << minmax.second << doocore::io::endmsg;
+
+  TH1D* sig_hist = new TH1D("sig_hist", "sig_hist", nbins, minmax.first , minmax.second);
+  TH1D* bkg_hist = new TH1D("bkg_hist", "bkg_hist", nbins, minmax.first , minmax.second);
+
+  for (std::vector<ScanEvent>::const_iterator event = events.begin(); event != events.end(); ++event){
+    // MC events are either signal or background (or both), sWeighted events
+    // enter both distributions
+    if (tuple->is_sw() || event->signal_weight != 0) sig_hist->Fill(event->value, event->signal_weight);
+    if (tuple->is_sw() || event->background_weight != 0) bkg_hist->Fill(event->value, event->background_weight);
+  }
+
+  PlotClassifierDistribution(tuple, classifier, sig_hist, bkg_hist);
+
+  delete sig_hist;
+  delete bkg_hist;
+}
+
+void Triage::PlotClassifierDistribution(Tuple* tuple, Classifier* classifier, TH1D* sig_hist, TH1D* bkg_hist){
+  sig_hist->SetLineColor(kBlue);
+  sig_hist->SetMarkerColor(kBlue);
+  sig_hist->SetFillColor(kBlue-9);
+  sig_hist->SetFillStyle(3005);
+  sig_hist->SetMinimum(0);
+  sig_hist->SetXTitle(TString(classifier->expression()));
+
+  bkg_hist->SetLineColor(kRed);
+  bkg_hist->SetMarkerColor(kRed);
+  bkg_hist->SetFillColor(kRed-9);
+  bkg_hist->SetFillStyle(3004);
+  bkg_hist->SetMinimum(0);
+  bkg_hist->SetXTitle(TString(classifier->expression()));
+
+  TCanvas* canvas = new TCanvas("canvas", "canvas", 800, 600);
+
+  doocore::lutils::drawNormalizedOrdered(sig_hist, bkg_hist);
+  doocore::lutils::printPlot (canvas, "ClassifierDistribution_"+tuple->name()+"_"+classifier->name(), "ClassifierDistributions/");
+
+  delete canvas;
+}
+
 void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const int nbins){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const int nbins) \t" << doocore::io::endmsg;
   doocore::lutils::setStyle("LHCb");
@@ -52,7 +115,6 @@ void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const
     
     if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "min " << minmax.first << " max " << minmax.second << doocore::io::endmsg;
 
-    TCanvas* canvas = new TCanvas("canvas", "canvas", 800, 600);
     TH1D* sig_hist = new TH1D("sig_hist", "sig_hist", nbins, minmax.first , minmax.second);
     TH1D* bkg_hist = new TH1D("bkg_hist", "bkg_hist", nbins, minmax.first , minmax.second);
 
@@ -70,26 +132,10 @@ void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const
     sig_hist->Print();
     bkg_hist->Print();
 
-    sig_hist->SetLineColor(kBlue);
-    sig_hist->SetMarkerColor(kBlue);
-    sig_hist->SetFillColor(kBlue-9);
-    sig_hist->SetFillStyle(3005);
-    sig_hist->SetMinimum(0);
-    sig_hist->SetXTitle(TString(classifier->expression()));
-
-    bkg_hist->SetLineColor(kRed);
-    bkg_hist->SetMarkerColor(kRed);
-    bkg_hist->SetFillColor(kRed-9);
-    bkg_hist->SetFillStyle(3004);
-    bkg_hist->SetMinimum(0);
-    bkg_hist->SetXTitle(TString(classifier->expression()));
-
-    doocore::lutils::drawNormalizedOrdered(sig_hist, bkg_hist);
-    doocore::lutils::printPlot (canvas, "ClassifierDistribution_"+mctuple->name()+"_"+classifier->name(), "ClassifierDistributions/");
+    PlotClassifierDistribution(mctuple, classifier, sig_hist, bkg_hist);
 
     delete sig_hist;
     delete bkg_hist;
-    delete canvas;
   }
   else if (tuple->is_sw()){
     SWTuple* swtuple = dynamic_cast<SWTuple*>(tuple);
@@ -131,28 +177,10 @@ void Triage::ClassifierDistribution(Tuple* tuple, Classifier* classifier, const
     swtuple->tree().ResetBranchAddress(swtuple->tree().GetBranch(TString(swtuple->observable_name())));
     swtuple->tree().ResetBranchAddress(swtuple->tree().GetBranch(TString(classifier->expression())));
 
-    sig_hist->SetLineColor(kBlue);
-    sig_hist->SetMarkerColor(kBlue);
-    sig_hist->SetFillColor(kBlue-9);
-    sig_hist->SetFillStyle(3005);
-    sig_hist->SetMinimum(0);
-    sig_hist->SetXTitle(TString(classifier->expression()));
-
-    bkg_hist->SetLineColor(kRed);
-    bkg_hist->SetMarkerColor(kRed);
-    bkg_hist->SetFillColor(kRed-9);
-    bkg_hist->SetFillStyle(3004);
-    bkg_hist->SetMinimum(0);
-    bkg_hist->SetXTitle(TString(classifier->expression()));
-
-    TCanvas* canvas = new TCanvas("canvas", "canvas", 800, 600);
-    
-    doocore::lutils::drawNormalizedOrdered(sig_hist, bkg_hist);
-    doocore::lutils::printPlot (canvas, "ClassifierDistribution_"+swtuple->name()+"_"+classifier->name(), "ClassifierDistributions/");
+    PlotClassifierDistribution(swtuple, classifier, sig_hist, bkg_hist);
 
     delete sig_hist;
     delete bkg_hist;
-    delete canvas;
   }
   else if (tuple->is_ft()){
     // TO-DO
@@ -0,0 +1,83 @@
+#include "Triage.h"
+
+// from STL
+#include <numeric>
+#include <utility>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from here
+#include "Tuple.h"
+#include "FoM.h"
+#include "CutOptimizer.h"
+
+// forward declarations
+
+namespace dooselection{
+namespace triage{
+
+void Triage::CutOptimizations(const std::string& figure_of_merit, int num_grid_points, int num_refinements){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::CutOptimizations(const std::string& figure_of_merit, int num_grid_points, int num_refinements) \t" << doocore::io::endmsg;
+  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++){
+    OptimizeCuts(*tuple, figure_of_merit, num_grid_points, num_refinements);
+  }
+}
+
+std::vector<double> Triage::OptimizeCuts(Tuple* tuple, const std::string& figure_of_merit, int num_grid_points, int num_refinements){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::vector<double> Triage::OptimizeCuts(Tuple* tuple, const std::string& figure_of_merit, int num_grid_points, int num_refinements) \t" << doocore::io::endmsg;
+  if (!FoM::IsKnown(figure_of_merit)){
+    doocore::io::serr << "-ERROR- \t" << "Triage::OptimizeCuts(...): Unknown figure of merit '" << figure_of_merit << "'" << doocore::io::endmsg;
+    return std::vector<double>();
+  }
+  const FoMType fom_type = FoM::Type(figure_of_merit);
+  std::vector<Classifier*> classifiers;
+  std::vector<CutOptimizer::Dimension> dimensions;
+  for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
+    CutOptimizer::Dimension dimension;
+    dimension.name = (*classifier).name();
+    dimension.cut_operator = (*classifier).cut_operator();
+    dimension.range = (*classifier).range();
+    classifiers.push_back(&(*classifier));
+    dimensions.push_back(dimension);
+  }
+
+  doocore::io::sinfo << "Triage::OptimizeCuts(...): Reading " << classifiers.size() << " classifiers of tuple '" << tuple->name() << "'" << doocore::io::endmsg;
+  std::vector< std::vector<double> > columns;
+  std::vector<double> signal_weights, background_weights;
+  if (!ReadTupleColumns(tuple, classifiers, columns, signal_weights, background_weights)){
+    doocore::io::serr << "-ERROR- \t" << "Triage::OptimizeCuts(...): Cannot read tuple '" << tuple->name() << "' into memory (only MC and sWeighted tuples with scalar expressions are supported)" << doocore::io::endmsg;
+    return std::vector<double>();
+  }
+  const double max_n_sig_events = std::accumulate(signal_weights.begin(), signal_weights.end(), 0.);
+  const double max_n_bkg_events = std::accumulate(background_weights.begin(), background_weights.end(), 0.);
+
+  CutOptimizer optimizer(dimensions, std::move(columns), std::move(signal_weights), std::move(background_weights), max_n_sig_events, max_n_bkg_events);
+  CutOptimizer::Result result = optimizer.Optimize(fom_type, num_grid_points, num_refinements, num_threads_);
+  if (result.cut_values.empty()){
+    doocore::io::serr << "-ERROR- \t" << "Triage::OptimizeCuts(...): No valid " << figure_of_merit << " value for tuple '" << tuple->name() << "'" << doocore::io::endmsg;
+    return result.cut_values;
+  }
+
+  doocore::io::sinfo << "Best cuts for tuple '" << tuple->name() << "' (" << figure_of_merit << " = " << result.fom_value << ", " << result.num_evaluations << " cut vectors evaluated)" << doocore::io::endmsg;
+  doocore::io::sinfo.increment_indent(2);
+  for (std::size_t c = 0; c < classifiers.size(); ++c){
+    classifiers[c]->set_best_cut_value(result.cut_values[c]);
+    doocore::io::sinfo << classifiers[c]->best_cut_string() << doocore::io::endmsg;
+  }
+  doocore::io::sinfo << "Signal events: " << result.n_sig_events << " / " << max_n_sig_events << doocore::io::endmsg;
+  doocore::io::sinfo << "Background events: " << result.n_bkg_events << " / " << max_n_bkg_events << doocore::io::endmsg;
+  doocore::io::sinfo.increment_indent(-2);
+  return result.cut_values;
+}
+
+} // namespace triage
+} // namespace dooselection
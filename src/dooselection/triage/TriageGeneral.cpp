@@ -1,19 +1,41 @@
 #include "Triage.h"
 
 // from STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// from POSIX
+#include <sys/wait.h>
+#include <unistd.h>
 
 // from ROOT
 #include "TString.h"
 #include "TTree.h"
+#include "TTreeFormula.h"
+#include "TROOT.h"
+#include "RVersion.h"
 #include "TCanvas.h"
 #include "TH1D.h"
 
 // from RooFit
+#include "RooArgSet.h"
+#include "RooAbsPdf.h"
+#include "RooRealVar.h"
 
 // from TMVA
 
 // from BOOST
 #include "boost/lexical_cast.hpp"
+#include "boost/filesystem.hpp"
 
 // from DooCore
 #include "doocore/io/MsgStream.h"
@@ -31,18 +53,137 @@
 #include "SWTuple.h"
 #include "FTTuple.h"
 #include "AbsFitterTuple.h"
+#include "dooselection/tools/StableHash.h"
 
 // forward declarations
 
 namespace dooselection{
 namespace triage{
 
+namespace {
+/// Loops over all entries of a tree and calls process for every entry after
+/// loading the given (scalar) formulas
+template<class Process>
+void LoopFormulas(TTree& tree, const std::vector<TTreeFormula*>& formulas, Process process){
+  int tree_number = -1;
+  const Long64_t num_entries = tree.GetEntries();
+  for (Long64_t entry = 0; entry < num_entries; ++entry){
+    if (tree.LoadTree(entry) < 0) break;
+    if (tree.GetTreeNumber() != tree_number){
+      tree_number = tree.GetTreeNumber();
+      for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula) (*formula)->UpdateFormulaLeaves();
+    }
+    for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula) (*formula)->GetNdata();
+    process();
+  }
+}
+
+/// Compiling and deleting TTreeFormulas is not thread-safe
+std::mutex formula_mutex;
+
+/// Options of the FTTuple fit in Triage::FitSigAndBkgEvents, part of the fit cache key
+const char* const kFTFitOptions = "Minimizer(Minuit2,minimize) Strategy(2) Extended()";
+
+/// Contents of a file ("" if it cannot be read)
+std::string FileContents(const std::string& file_name){
+  std::ifstream file(file_name.c_str());
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+/// Contents of a starting values file as the fit reads it, i.e. after
+/// ReplaceScientificNotationInFile, which is run on a temporary copy to leave
+/// the file itself untouched ("" if it does not exist)
+std::string StartingValuesContents(const std::string& file_name, bool debug_mode){
+  if (!boost::filesystem::exists(file_name)) return "";
+  boost::filesystem::path copy = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("triage_startingvalues_%%%%-%%%%-%%%%-%%%%.txt");
+  boost::filesystem::copy_file(file_name, copy);
+  doocore::io::tools::ReplaceScientificNotationInFile(copy.string(), debug_mode);
+  std::string contents = FileContents(copy.string());
+  boost::filesystem::remove(copy);
+  return contents;
+}
+
+/// Class and name of all components and name, range and constness of all parameters of a pdf
+std::string PdfDescription(const RooAbsPdf& pdf, const RooArgSet& observables){
+  std::stringstream description;
+  description << std::setprecision(17);
+  RooArgSet* components = pdf.getComponents();
+  TIterator* it_components = components->createIterator();
+  RooAbsArg* component = NULL;
+  while ((component = dynamic_cast<RooAbsArg*>(it_components->Next()))){
+    description << component->ClassName() << "::" << component->GetName() << ";";
+  }
+  delete it_components;
+  delete components;
+
+  RooArgSet* parameters = pdf.getParameters(observables);
+  TIterator* it_parameters = parameters->createIterator();
+  RooAbsArg* parameter = NULL;
+  while ((parameter = dynamic_cast<RooAbsArg*>(it_parameters->Next()))){
+    description << parameter->GetName();
+    RooRealVar* var = dynamic_cast<RooRealVar*>(parameter);
+    if (var != NULL) description << "[" << var->getMin() << "," << var->getMax() << "]" << (var->isConstant() ? "C" : "");
+    description << ";";
+  }
+  delete it_parameters;
+  delete parameters;
+  return description.str();
+}
+
+/// Expressions for the observable range and the signal and background weights of a MC or sWeighted tuple,
+/// the same as in NumberOfSigAndBkgEvents; for MC tuples the weights are the truth conditions (0 or 1)
+void ScanExpressions(Tuple* tuple, std::string& observable_range, std::string& signal_weight, std::string& background_weight){
+  observable_range = "((" + tuple->observable_name() + ">" + std::to_string(tuple->observable_range().first) + ")&&(" + tuple->observable_name() + "<" + std::to_string(tuple->observable_range().second) + "))";
+  if (tuple->is_mc()){
+    MCTuple* mctuple = dynamic_cast<MCTuple*>(tuple);
+    signal_weight = mctuple->signal_cut();
+    background_weight = mctuple->background_cut();
+  }
+  else{
+    SWTuple* swtuple = dynamic_cast<SWTuple*>(tuple);
+    signal_weight = swtuple->signal_sweight();
+    background_weight = swtuple->background_sweight();
+  }
+}
+
+/// Array-valued expressions select an entry if any instance passes, which
+/// cannot be decomposed into independent conditions
+bool IsScalar(const TTreeFormula* formula){
+  return formula->GetNdim() != 0 && formula->GetMultiplicity() == 0;
+}
+
+bool IsCumulativeOperator(const std::string& cut_operator){
+  return (cut_operator == ">" || cut_operator == ">=" || cut_operator == "<" || cut_operator == "<=");
+}
+} // namespace
+
 void Triage::FillTriageHistContainerList(const int nbins){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::ComputeSigAndBkgEventNumbersHistogram() \t" << doocore::io::endmsg;
-  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++){
-    MaximalNumberOfEvents(*tuple);
-    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
-      hist_container_list_.push_back(TriageHistContainer((*tuple)->name()+"_"+(*classifier).name()+"_"+std::to_string(nbins) ,*tuple, &(*classifier), (*tuple)->max_n_sig_events(), (*tuple)->max_n_bkg_events(), (*classifier).cut_values(), SigAndBkgEventNumbersHistogram(*tuple, &(*classifier), nbins)));
+  std::vector<char> scanned(std::distance(tuple_list_.begin(), tuple_list_.end()), 0);
+  std::vector<TupleScan> scans;
+  if (num_threads_ > 1) scans = ReadTupleScans(scanned);
+
+  std::size_t t = 0;
+  for(TupleList::iterator tuple = tuple_list_.begin(); tuple != tuple_list_.end(); tuple++, t++){
+    if (scanned[t]){
+      (*tuple)->set_max_n_sig_events(scans[t].sum_of_sig_weights);
+      (*tuple)->set_max_n_bkg_events(scans[t].sum_of_bkg_weights);
+    }
+    else{
+      MaximalNumberOfEvents(*tuple);
+    }
+    std::size_t c = 0;
+    for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++, c++){
+      const std::vector<ScanEvent>* events = (scanned[t] && scans[t].valid[c]) ? &(scans[t].events[c]) : NULL;
+      std::shared_ptr<RocEngine> roc_engine;
+      std::pair<TH1D, TH1D> hist_number_sig_bkg_events = SigAndBkgEventNumbersHistogram(*tuple, &(*classifier), nbins, events, &roc_engine);
+      hist_container_list_.push_back(TriageHistContainer((*tuple)->name()+"_"+(*classifier).name()+"_"+std::to_string(nbins) ,*tuple, &(*classifier), (*tuple)->max_n_sig_events(), (*tuple)->max_n_bkg_events(), (*classifier).cut_values(), hist_number_sig_bkg_events));
+      if (roc_engine){
+        roc_engine->Bootstrap(num_bootstrap_samples_, num_threads_);
+        hist_container_list_.back().set_roc_engine(roc_engine);
+      }
     }
   }
   hist_container_list_filled_ = true;
@@ -81,97 +222,85 @@ std::pair<double, double> Triage::NumberOfSigAndBkgEvents(Tuple* tuple, const st
   else if (tuple->is_sw()){
     SWTuple* swtuple = dynamic_cast<SWTuple*>(tuple);
     if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "using sweights…" << doocore::io::endmsg;
-    int nbins = swtuple->tree().GetEntries();
-    TCanvas canvas("canvas", "canvas", 800, 600);
-    TH1D sig_hist("sig_hist", "sig_hist", nbins, swtuple->sweights_range().first, swtuple->sweights_range().second);
-    TH1D bkg_hist("bkg_hist", "bkg_hist", nbins, swtuple->sweights_range().first, swtuple->sweights_range().second);
 
     std::string observable_range = "((" + tuple->observable_name() + ">" + std::to_string(tuple->observable_range().first) + ")&&(" + tuple->observable_name() + "<" + std::to_string(tuple->observable_range().second) + "))";
     std::string interim_cut_string = observable_range;
     if (cut_string != "") interim_cut_string += "&&(" + cut_string + ")";
 
-    swtuple->tree().Draw(TString(swtuple->signal_sweight())+">>sig_hist", TString(interim_cut_string));
-    swtuple->tree().Draw(TString(swtuple->background_sweight())+">>bkg_hist", TString(interim_cut_string));
+    TTreeFormula cut_formula("triage_cut", TString(interim_cut_string), &swtuple->tree());
+    TTreeFormula signal_formula("triage_signal", TString(swtuple->signal_sweight()), &swtuple->tree());
+    TTreeFormula background_formula("triage_background", TString(swtuple->background_sweight()), &swtuple->tree());
+    std::vector<TTreeFormula*> formulas = {&cut_formula, &signal_formula, &background_formula};
 
     double sum_of_sig_sweights = 0.;
     double sum_of_bkg_sweights = 0.;
-    double bin_content_sig = 0.;
-    double bin_content_bkg = 0.;
-    double bin_center_sig = 0.;
-    double bin_center_bkg = 0.;
-
-    for (int i = 1;i < nbins; ++i){
-      bin_content_sig = sig_hist.GetBinContent(i);
-      bin_content_bkg = bkg_hist.GetBinContent(i);
-      bin_center_sig = sig_hist.GetBinCenter(i);
-      bin_center_bkg = bkg_hist.GetBinCenter(i);
-      sum_of_sig_sweights += bin_center_sig*bin_content_sig;
-      sum_of_bkg_sweights += bin_center_bkg*bin_content_bkg;
-    }
+    LoopFormulas(swtuple->tree(), formulas, [&](){
+      if (cut_formula.EvalInstance() == 0) return;
+      sum_of_sig_sweights += signal_formula.EvalInstance();
+      sum_of_bkg_sweights += background_formula.EvalInstance();
+    });
     number_of_events.first = sum_of_sig_sweights;
     number_of_events.second = sum_of_bkg_sweights;
   }
-  else if (tuple->is_ft()){
-    FTTuple* fttuple = dynamic_cast<FTTuple*>(tuple);
-    std::string local_cut_string = cut_string;
-    if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "using a fit…" << doocore::io::endmsg;
+  else if (tuple->is_ft() || tuple->is_absfitter()){
+    number_of_events = FitSigAndBkgEvents(tuple, cut_string);
+  }
+  else{
+    doocore::io::serr << "-ERROR- \t" << "std::pair<double, double> Triage::NumberOfSigAndBkgEvents(Tuple* tuple, const std::string& cut_string)" << doocore::io::endmsg;
+  }
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "Sum of signal events: " << number_of_events.first << " @cut: " << cut_string << doocore::io::endmsg;
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "Sum of background events: " << number_of_events.second << " @cut: " << cut_string << doocore::io::endmsg;
+  return number_of_events;
+}
 
-    RooAbsData* data;
-    bool owned_data = false;
-    if (local_cut_string==""){
-      data = &(fttuple->dataset());
-    }
-    else{
-      data = fttuple->dataset().reduce(TString(local_cut_string));
-      owned_data = true;
+std::pair<double, double> Triage::FitSigAndBkgEvents(Tuple* tuple, const std::string& cut_string){
+  std::pair<double, double> number_of_events;
+  std::string local_cut_string = cut_string;
+  FitHandover& handover = fit_handovers_[tuple];
+
+  std::string cache_prefix = FitCachePrefix(tuple, cut_string);
+  if (cache_prefix != ""){
+    FitHandover cached;
+    if (ReadFitResult(tuple, cache_prefix, number_of_events, cached)){
+      doocore::io::sinfo << "Triage::FitSigAndBkgEvents(...): Using cached fit result " << cache_prefix << " for cut '" << cut_string << "'" << doocore::io::endmsg;
+      handover = cached;
+      return number_of_events;
     }
+  }
 
-    /// fit
-    std::string handover_filename = "TriageHandoverFitParameter.txt";
-    if (fttuple->nocut_startingvalues_file()==""){
-      doocore::io::swarn << "-warning- \t" << "No 'no cut' starting values file name set. Using 'StartingValues_NoCut.txt' instead. Make sure this file exists!" << doocore::io::endmsg;
-      fttuple->set_nocut_startingvalues_file("StartingValues_NoCut.txt");  
-    }
+  if (tuple->is_ft()){
+    FTTuple* fttuple = dynamic_cast<FTTuple*>(tuple);
+    if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "using a fit…" << doocore::io::endmsg;
+    RooAbsPdf* pdf = fttuple->sim_pdf() ? fttuple->spdf() : fttuple->pdf();
 
-    if (local_cut_string==""){
-      doocore::io::tools::ReplaceScientificNotationInFile(fttuple->nocut_startingvalues_file(), debug_mode_);
-      if (fttuple->sim_pdf()){
-        fttuple->spdf()->getParameters(data)->readFromFile(TString(fttuple->nocut_startingvalues_file())); 
-      }
-      else{
-       fttuple->pdf()->getParameters(data)->readFromFile(TString(fttuple->nocut_startingvalues_file())); 
+    // only the entries passing the cut are materialized
+    RooAbsData* data = fttuple->ReducedDataSet(local_cut_string);
+
+    /// fit, starting from the result of the previous fit
+    RooArgSet* parameters = pdf->getParameters(data);
+    if (local_cut_string=="" || !handover.parameters){
+      if (fttuple->nocut_startingvalues_file()==""){
+        doocore::io::swarn << "-warning- \t" << "No 'no cut' starting values file name set. Using 'StartingValues_NoCut.txt' instead. Make sure this file exists!" << doocore::io::endmsg;
+        fttuple->set_nocut_startingvalues_file("StartingValues_NoCut.txt");
       }
+      doocore::io::tools::ReplaceScientificNotationInFile(fttuple->nocut_startingvalues_file(), debug_mode_);
+      parameters->readFromFile(TString(fttuple->nocut_startingvalues_file()));
     }
     else{
-      doocore::io::tools::ReplaceScientificNotationInFile(handover_filename, debug_mode_);
-      if (fttuple->sim_pdf()){
-        fttuple->spdf()->getParameters(data)->readFromFile(TString(handover_filename)); 
-      }
-      else{
-        fttuple->pdf()->getParameters(data)->readFromFile(TString(handover_filename)); 
-      }
+      *parameters = *handover.parameters;
     }
 
     // handles too long cut strings, maybe, there is a nicer method
     if (local_cut_string.size() > 50){
       local_cut_string.erase(15,local_cut_string.size());
       local_cut_string.append("…");
-    }  
-
-    if (fttuple->sim_pdf()){
-      fttuple->spdf()->getParameters(data)->writeToFile("StartingValues.out");
-      fttuple->spdf()->fitTo(*data, RooFit::Minimizer("Minuit2", "minimize"), RooFit::NumCPU(16), RooFit::Strategy(2), RooFit::Extended());
-      fttuple->spdf()->getParameters(data)->writeToFile(TString(handover_filename));
-      fttuple->spdf()->getParameters(data)->writeToFile(TString("FitResults_")+local_cut_string+".out");
-    }
-    else{
-      fttuple->pdf()->getParameters(data)->writeToFile("StartingValues.out");
-      fttuple->pdf()->fitTo(*data, RooFit::Minimizer("Minuit2", "minimize"), RooFit::NumCPU(16), RooFit::Strategy(2), RooFit::Extended());
-      fttuple->pdf()->getParameters(data)->writeToFile(TString(handover_filename));
-      fttuple->pdf()->getParameters(data)->writeToFile(TString("FitResults_")+local_cut_string+".out");
     }
 
-    doocore::io::tools::ReplaceScientificNotationInFile(handover_filename, debug_mode_);
+    parameters->writeToFile(TString(fit_output_prefix_+"StartingValues.out"));
+    // kFTFitOptions describes these options for the fit cache key
+    pdf->fitTo(*data, RooFit::Minimizer("Minuit2", "minimize"), RooFit::NumCPU(fttuple->num_cpu()), RooFit::Strategy(2), RooFit::Extended());
+    handover.parameters.reset(dynamic_cast<RooArgSet*>(parameters->snapshot()));
+    parameters->writeToFile(TString(fit_output_prefix_+"FitResults_")+local_cut_string+".out");
 
     // Plotting
     doofit::plotting::PlotConfig plot_cfg("plot_cfg");
@@ -187,72 +316,220 @@ std::pair<double, double> Triage::NumberOfSigAndBkgEvents(Tuple* tuple, const st
     number_of_events.first = fttuple->signal_yield()->getVal();
     number_of_events.second = fttuple->background_yield()->getVal();
 
-    if (owned_data) delete data;
+    delete parameters;
+    delete data;
   }
-  else if (tuple->is_absfitter()){
+  else{
     AbsFitterTuple* afttuple = dynamic_cast<AbsFitterTuple*>(tuple);
     doofit::fitter::AbsFitter& fitter = afttuple->fitter();
-
-    std::string local_cut_string = cut_string;
     if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "using a AbsFitter fit…" << doocore::io::endmsg;
 
     fitter.set_identifier(std::string("triage_") + afttuple->name() + "_" + cut_string);
     fitter.PrepareFit();
 
-    
-    RooAbsData* data;
-    bool owned_data = false;
-    if (local_cut_string==""){
-      data = &(afttuple->dataset());
-    }
-    else{
-      data = afttuple->dataset().reduce(TString(local_cut_string));
-      owned_data = true;
-    }
-    
-    /// fit
-    std::string handover_filename = "TriageHandoverFitParameter.txt";
-    if (afttuple->nocut_startingvalues_file()==""){
-      doocore::io::swarn << "-warning- \t" << "No 'no cut' starting values file name set. Using 'StartingValues_NoCut.txt' instead. Make sure this file exists!" << doocore::io::endmsg;
-      afttuple->set_nocut_startingvalues_file("StartingValues_NoCut.txt");
-    }
-    
-    if (local_cut_string==""){
+    // only the entries passing the cut are materialized
+    RooAbsData* data = afttuple->ReducedDataSet(local_cut_string);
+
+    /// fit, starting from the result of the previous fit
+    if (local_cut_string=="" || handover.parameters_file==""){
+      if (afttuple->nocut_startingvalues_file()==""){
+        doocore::io::swarn << "-warning- \t" << "No 'no cut' starting values file name set. Using 'StartingValues_NoCut.txt' instead. Make sure this file exists!" << doocore::io::endmsg;
+        afttuple->set_nocut_startingvalues_file("StartingValues_NoCut.txt");
+      }
       doocore::io::tools::ReplaceScientificNotationInFile(afttuple->nocut_startingvalues_file(), debug_mode_);
       fitter.ReadParametersFile(afttuple->nocut_startingvalues_file());
     }
     else{
-      doocore::io::tools::ReplaceScientificNotationInFile(handover_filename, debug_mode_);
-      fitter.ReadParametersFile(handover_filename);
-    }
-    
-    // handles too long cut strings, maybe, there is a nicer method
-    if (local_cut_string.size() > 50){
-      local_cut_string.erase(15,local_cut_string.size());
-      local_cut_string.append("…");
+      fitter.ReadParametersFile(handover.parameters_file);
     }
-    
+
     fitter.set_dataset(data);
     fitter.Fit();
-    fitter.WriteParametersFile(handover_filename);
+    fitter.WriteParametersFile(fit_handover_filename_);
     fitter.Plot();
-    
-    doocore::io::tools::ReplaceScientificNotationInFile(handover_filename, debug_mode_);
-    
+
+    doocore::io::tools::ReplaceScientificNotationInFile(fit_handover_filename_, debug_mode_);
+    handover.parameters_file = fit_handover_filename_;
+
     number_of_events.first = fitter.SignalYield();
     number_of_events.second = fitter.BackgroundYield();
-    
-    if (owned_data) delete data;
+
+    delete data;
   }
-  else{
-    doocore::io::serr << "-ERROR- \t" << "std::pair<double, double> Triage::NumberOfSigAndBkgEvents(Tuple* tuple, const std::string& cut_string)" << doocore::io::endmsg;
+
+  if (cache_prefix != "") WriteFitResult(tuple, cache_prefix, number_of_events);
+  return number_of_events;
+}
+
+std::vector< std::pair<double, double> > Triage::ParallelFitSigAndBkgEvents(Tuple* tuple, const std::vector<std::string>& cut_strings, unsigned int num_processes){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::vector< std::pair<double, double> > Triage::ParallelFitSigAndBkgEvents(...) \t" << doocore::io::endmsg;
+  const std::size_t num_cuts = cut_strings.size();
+  std::vector< std::pair<double, double> > number_of_events(num_cuts, std::make_pair(0., 0.));
+  std::vector<FitHandover> results(num_cuts);
+  std::vector<char> finished(num_cuts, 0);
+
+  // result of the fit without cut
+  const FitHandover nocut_handover = fit_handovers_[tuple];
+
+  boost::filesystem::path work_directory = boost::filesystem::path("TriageParallelFits") / boost::filesystem::path(tuple->name());
+  boost::filesystem::create_directories(work_directory);
+
+  doocore::io::sinfo << "Triage::ParallelFitSigAndBkgEvents(...): Fitting " << num_cuts << " cut points of tuple '" << tuple->name() << "' in up to " << num_processes << " processes" << doocore::io::endmsg;
+  std::map<pid_t, std::size_t> running;
+  std::size_t next_cut = 0;
+  while (next_cut < num_cuts || !running.empty()){
+    while (next_cut < num_cuts && running.size() < num_processes){
+      const std::size_t i = next_cut++;
+
+      std::string cache_prefix = FitCachePrefix(tuple, cut_strings[i]);
+      if (cache_prefix != "" && ReadFitResult(tuple, cache_prefix, number_of_events[i], results[i])){
+        doocore::io::sinfo << "Triage::ParallelFitSigAndBkgEvents(...): Using cached fit result " << cache_prefix << " for cut '" << cut_strings[i] << "'" << doocore::io::endmsg;
+        finished[i] = 1;
+        continue;
+      }
+
+      // warm start from the nearest finished cut point
+      FitHandover warm_start = nocut_handover;
+      for (std::size_t distance = 1; distance < num_cuts; ++distance){
+        if (i >= distance && finished[i-distance]){
+          warm_start = results[i-distance];
+          break;
+        }
+        if (i+distance < num_cuts && finished[i+distance]){
+          warm_start = results[i+distance];
+          break;
+        }
+      }
+
+      std::string result_prefix = (work_directory / boost::filesystem::path("cut_"+std::to_string(i))).string();
+      pid_t pid = fork();
+      if (pid == 0){
+        int status = 0;
+        try{
+          fit_handovers_[tuple] = warm_start;
+          fit_handover_filename_ = result_prefix+"_parameters.txt";
+          // each child writes its output files next to its result, not into the shared working directory
+          fit_output_prefix_ = result_prefix+"_";
+          std::pair<double, double> result = FitSigAndBkgEvents(tuple, cut_strings[i]);
+          WriteFitResult(tuple, result_prefix, result);
+        }
+        catch (...){
+          status = 1;
+        }
+        _exit(status);
+      }
+      else if (pid < 0){
+        doocore::io::serr << "-ERROR- \t" << "Triage::ParallelFitSigAndBkgEvents(...): Cannot fork, fitting cut '" << cut_strings[i] << "' in this process" << doocore::io::endmsg;
+        fit_handovers_[tuple] = warm_start;
+        number_of_events[i] = FitSigAndBkgEvents(tuple, cut_strings[i]);
+        results[i] = fit_handovers_[tuple];
+        finished[i] = 1;
+      }
+      else{
+        running[pid] = i;
+      }
+    }
+    if (running.empty()) continue;
+
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) break;
+    std::map<pid_t, std::size_t>::iterator job = running.find(pid);
+    if (job == running.end()) continue;
+    const std::size_t i = job->second;
+    running.erase(job);
+
+    std::string result_prefix = (work_directory / boost::filesystem::path("cut_"+std::to_string(i))).string();
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && ReadFitResult(tuple, result_prefix, number_of_events[i], results[i])){
+      finished[i] = 1;
+      doocore::io::sinfo << "Triage::ParallelFitSigAndBkgEvents(...): Finished cut '" << cut_strings[i] << "'" << doocore::io::endmsg;
+    }
+    else{
+      doocore::io::serr << "-ERROR- \t" << "Triage::ParallelFitSigAndBkgEvents(...): Fit for cut '" << cut_strings[i] << "' failed" << doocore::io::endmsg;
+    }
+  }
+
+  // continue as after a serial scan
+  fit_handovers_[tuple] = nocut_handover;
+  for (std::size_t i = num_cuts; i > 0; --i){
+    if (finished[i-1]){
+      fit_handovers_[tuple] = results[i-1];
+      break;
+    }
   }
-  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "Sum of signal events: " << number_of_events.first << " @cut: " << cut_string << doocore::io::endmsg;
-  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "Sum of background events: " << number_of_events.second << " @cut: " << cut_string << doocore::io::endmsg;
   return number_of_events;
 }
 
-std::pair<TH1D, TH1D> Triage::SigAndBkgEventNumbersHistogram(Tuple* tuple, Classifier* classifier, const int nbins){
+std::string Triage::FitCachePrefix(Tuple* tuple, const std::string& cut_string) const{
+  std::string cache_directory;
+  if (tuple->is_ft()) cache_directory = dynamic_cast<FTTuple*>(tuple)->fit_cache_directory();
+  else if (tuple->is_absfitter()) cache_directory = dynamic_cast<AbsFitterTuple*>(tuple)->fit_cache_directory();
+  if (cache_directory == "") return "";
+
+  // everything the fit result depends on: data, model, start values and options
+  std::stringstream key;
+  key << tuple->name() << "\n" << cut_string << "\n";
+  boost::filesystem::path input_path = boost::filesystem::path(tuple->path()) / boost::filesystem::path(tuple->filename());
+  key << input_path.string() << ";" << tuple->treename() << ";" << tuple->global_cut() << ";";
+  if (boost::filesystem::exists(input_path)) key << boost::filesystem::file_size(input_path) << ";" << boost::filesystem::last_write_time(input_path) << ";";
+  key << "\n";
+  std::string startingvalues_file;
+  if (tuple->is_ft()){
+    FTTuple* fttuple = dynamic_cast<FTTuple*>(tuple);
+    const RooAbsPdf* pdf = fttuple->sim_pdf() ? fttuple->spdf() : fttuple->pdf();
+    key << PdfDescription(*pdf, fttuple->columns().variables()) << "\n" << kFTFitOptions << "\n";
+    startingvalues_file = fttuple->nocut_startingvalues_file();
+  }
+  else{
+    AbsFitterTuple* afttuple = dynamic_cast<AbsFitterTuple*>(tuple);
+    key << afttuple->fit_cache_tag() << "\n";
+    startingvalues_file = afttuple->nocut_startingvalues_file();
+  }
+  if (startingvalues_file == "") startingvalues_file = "StartingValues_NoCut.txt";
+  key << StartingValuesContents(startingvalues_file, debug_mode_);
+
+  std::stringstream prefix;
+  prefix << tuple->name() << "_" << dooselection::tools::StableHashString(key.str());
+  return (boost::filesystem::path(cache_directory) / boost::filesystem::path(prefix.str())).string();
+}
+
+bool Triage::ReadFitResult(Tuple* tuple, const std::string& prefix, std::pair<double, double>& number_of_events, FitHandover& handover){
+  std::ifstream yields_file((prefix+"_yields.txt").c_str());
+  if (!(yields_file >> number_of_events.first >> number_of_events.second)) return false;
+
+  std::string parameters_file = prefix+"_parameters.txt";
+  if (tuple->is_ft()){
+    FTTuple* fttuple = dynamic_cast<FTTuple*>(tuple);
+    RooAbsPdf* pdf = fttuple->sim_pdf() ? fttuple->spdf() : fttuple->pdf();
+    RooArgSet* parameters = pdf->getParameters(fttuple->columns().variables());
+    handover.parameters.reset(dynamic_cast<RooArgSet*>(parameters->snapshot()));
+    handover.parameters->readFromFile(TString(parameters_file));
+    delete parameters;
+  }
+  else{
+    handover.parameters_file = parameters_file;
+  }
+  return true;
+}
+
+void Triage::WriteFitResult(Tuple* tuple, const std::string& prefix, const std::pair<double, double>& number_of_events){
+  boost::filesystem::path parameters_file(prefix+"_parameters.txt");
+  if (parameters_file.has_parent_path()) boost::filesystem::create_directories(parameters_file.parent_path());
+
+  // parameters first, the yields file marks a complete entry
+  const FitHandover& handover = fit_handovers_[tuple];
+  if (tuple->is_ft()){
+    if (handover.parameters) handover.parameters->writeToFile(TString(parameters_file.string()));
+  }
+  else if (handover.parameters_file != parameters_file.string()){
+    boost::filesystem::copy_file(handover.parameters_file, parameters_file, boost::filesystem::copy_option::overwrite_if_exists);
+  }
+
+  std::ofstream yields_file((prefix+"_yields.txt").c_str());
+  yields_file << std::setprecision(17) << number_of_events.first << " " << number_of_events.second << std::endl;
+}
+
+std::pair<TH1D, TH1D> Triage::SigAndBkgEventNumbersHistogram(Tuple* tuple, Classifier* classifier, const int nbins, const std::vector<ScanEvent>* events, std::shared_ptr<RocEngine>* roc_engine){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::pair<TH1D, TH1D> Triage::SigAndBkgEventNumbersHistogram(Tuple* tuple, Classifier* classifier) \t" << doocore::io::endmsg;
   std::pair<TH1D, TH1D> hist_number_sig_bkg_events;
   std::vector<double> cut_values;
@@ -270,24 +547,70 @@ std::pair<TH1D, TH1D> Triage::SigAndBkgEventNumbersHistogram(Tuple* tuple, Class
   hist_number_bkg_events.GetYaxis()->SetTitle("# Background Events");
   hist_number_bkg_events.SetStats(false);
 
-  double cut_value = classifier->range().first;
-  cut_values.push_back(cut_value);
+  cut_values.push_back(classifier->range().first);
+  for (int i = 1; i<= nbins; ++i){
+    // better and more robust:
+    cut_values.push_back((static_cast<double>(nbins-i)/static_cast<double>(nbins))*classifier->range().first + (static_cast<double>(i)/static_cast<double>(nbins))*classifier->range().second);
+  }
 
   doocore::io::sinfo << "Signal and background event numbers for tuple '" << tuple->name() << "' and classifier '" << classifier->name().c_str() << "'" << doocore::io::endmsg;
-  for (int i = 1; i<= nbins; ++i){
-    doocore::io::sinfo << "Triage::SigAndBkgEventNumbersHistogram(...): Analysing classifier cut " << cut_value << doocore::io::endmsg;
-    if ((i%1) == 0){
-      double frac = static_cast<double> (i)/nbins*100.0;
-      printf("Progress %.2f %%         \n", frac);
-      fflush(stdout);
+  std::vector< std::pair<double, double> > number_sig_bkg_events;
+  std::vector< std::pair<double, double> > sum_of_squared_weights;
+  bool cumulative = false;
+  std::vector<ScanEvent> read_events;
+  if (events != NULL){
+    cumulative = CumulativeSums(*events, classifier->cut_operator(), cut_values, number_sig_bkg_events, sum_of_squared_weights);
+  }
+  else{
+    cumulative = CumulativeSigAndBkgEventNumbers(tuple, classifier, cut_values, number_sig_bkg_events, sum_of_squared_weights, roc_engine != NULL ? &read_events : NULL);
+    events = &read_events;
+  }
+  if (roc_engine != NULL){
+    roc_engine->reset();
+    if (cumulative){
+      std::vector<double> values(events->size()), signal_weights(events->size()), background_weights(events->size());
+      for (std::size_t i = 0; i < events->size(); ++i){
+        values[i] = (*events)[i].value;
+        signal_weights[i] = (*events)[i].signal_weight;
+        background_weights[i] = (*events)[i].background_weight;
+      }
+      roc_engine->reset(new RocEngine(values, signal_weights, background_weights, classifier->cut_operator(), tuple->max_n_sig_events(), tuple->max_n_bkg_events()));
+    }
+  }
+  if (cumulative){
+    for (int i = 1; i<= nbins; ++i){
+      hist_number_sig_events.SetBinContent(i, number_sig_bkg_events[i-1].first);
+      hist_number_bkg_events.SetBinContent(i, number_sig_bkg_events[i-1].second);
+      hist_number_sig_events.SetBinError(i, std::sqrt(sum_of_squared_weights[i-1].first));
+      hist_number_bkg_events.SetBinError(i, std::sqrt(sum_of_squared_weights[i-1].second));
+    }
+  }
+  else if ((tuple->is_ft() && dynamic_cast<FTTuple*>(tuple)->num_parallel_fits() > 1) || (tuple->is_absfitter() && dynamic_cast<AbsFitterTuple*>(tuple)->num_parallel_fits() > 1)){
+    unsigned int num_parallel_fits = tuple->is_ft() ? dynamic_cast<FTTuple*>(tuple)->num_parallel_fits() : dynamic_cast<AbsFitterTuple*>(tuple)->num_parallel_fits();
+    std::vector<std::string> cut_strings;
+    for (int i = 1; i<= nbins; ++i){
+      cut_strings.push_back(classifier->expression()+classifier->cut_operator()+std::to_string(cut_values[i-1]));
+    }
+    std::vector< std::pair<double, double> > number_of_events = ParallelFitSigAndBkgEvents(tuple, cut_strings, num_parallel_fits);
+    for (int i = 1; i<= nbins; ++i){
+      hist_number_sig_events.SetBinContent(i, number_of_events[i-1].first);
+      hist_number_bkg_events.SetBinContent(i, number_of_events[i-1].second);
+    }
+  }
+  else{
+    for (int i = 1; i<= nbins; ++i){
+      double cut_value = cut_values[i-1];
+      doocore::io::sinfo << "Triage::SigAndBkgEventNumbersHistogram(...): Analysing classifier cut " << cut_value << doocore::io::endmsg;
+      if ((i%1) == 0){
+        double frac = static_cast<double> (i)/nbins*100.0;
+        printf("Progress %.2f %%         \n", frac);
+        fflush(stdout);
+      }
+      std::string cut_string = classifier->expression()+classifier->cut_operator()+std::to_string(cut_value);
+      std::pair<double, double> number_of_events = NumberOfSigAndBkgEvents(tuple, cut_string);
+      hist_number_sig_events.SetBinContent(i, number_of_events.first);
+      hist_number_bkg_events.SetBinContent(i, number_of_events.second);
     }
-    std::string cut_string = classifier->expression()+classifier->cut_operator()+std::to_string(cut_value);
-    std::pair<double, double> number_sig_bkg_events = NumberOfSigAndBkgEvents(tuple, cut_string);
-    hist_number_sig_events.SetBinContent(i, number_sig_bkg_events.first);
-    hist_number_bkg_events.SetBinContent(i, number_sig_bkg_events.second);
-    // better and more robust:
-    cut_value = (static_cast<double>(nbins-i)/static_cast<double>(nbins))*classifier->range().first + (static_cast<double>(i)/static_cast<double>(nbins))*classifier->range().second;
-    cut_values.push_back(cut_value);
   }
 
   classifier->set_cut_values(cut_values);
@@ -307,6 +630,276 @@ std::pair<TH1D, TH1D> Triage::SigAndBkgEventNumbersHistogram(Tuple* tuple, Class
 }
 
 
+bool Triage::CumulativeSigAndBkgEventNumbers(Tuple* tuple, Classifier* classifier, const std::vector<double>& cut_values, std::vector< std::pair<double, double> >& number_of_events, std::vector< std::pair<double, double> >& sum_of_squared_weights, std::vector<ScanEvent>* events){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling bool Triage::CumulativeSigAndBkgEventNumbers(Tuple* tuple, Classifier* classifier, ...) \t" << doocore::io::endmsg;
+  if (!IsCumulativeOperator(classifier->cut_operator())) return false;
+
+  doocore::io::sinfo << "Triage::CumulativeSigAndBkgEventNumbers(...): Reading classifier values and weights in a single pass" << doocore::io::endmsg;
+  TupleScan scan;
+  if (!ReadTupleScan(tuple, std::vector<Classifier*>(1, classifier), scan) || !scan.valid[0]){
+    if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "cannot use single pass, scanning cut by cut" << doocore::io::endmsg;
+    return false;
+  }
+  bool cumulative = CumulativeSums(scan.events[0], classifier->cut_operator(), cut_values, number_of_events, sum_of_squared_weights);
+  if (events != NULL) events->swap(scan.events[0]);
+  return cumulative;
+}
+
+bool Triage::ReadTupleScan(Tuple* tuple, const std::vector<Classifier*>& classifiers, TupleScan& scan){
+  if (!tuple->is_mc() && !tuple->is_sw()) return false;
+  TTree& tree = tuple->tree();
+
+  std::string observable_range, signal_weight, background_weight;
+  ScanExpressions(tuple, observable_range, signal_weight, background_weight);
+
+  std::vector<TTreeFormula*> formulas;
+  std::vector<TTreeFormula*> classifier_formulas;
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    formulas.push_back(new TTreeFormula("triage_range", TString(observable_range), &tree));
+    formulas.push_back(new TTreeFormula("triage_signal", TString(signal_weight), &tree));
+    formulas.push_back(new TTreeFormula("triage_background", TString(background_weight), &tree));
+    for (std::vector<Classifier*>::const_iterator classifier = classifiers.begin(); classifier != classifiers.end(); ++classifier){
+      classifier_formulas.push_back(new TTreeFormula("triage_classifier", TString((*classifier)->expression()), &tree));
+    }
+  }
+  TTreeFormula* range_formula = formulas[0];
+  TTreeFormula* signal_formula = formulas[1];
+  TTreeFormula* background_formula = formulas[2];
+
+  bool readable_tuple = IsScalar(range_formula) && IsScalar(signal_formula) && IsScalar(background_formula);
+  scan.sum_of_sig_weights = 0.;
+  scan.sum_of_bkg_weights = 0.;
+  scan.events.assign(classifiers.size(), std::vector<ScanEvent>());
+  scan.valid.assign(classifiers.size(), 0);
+  std::vector<std::size_t> valid_classifiers;
+  for (std::size_t c = 0; c < classifiers.size(); ++c){
+    scan.valid[c] = IsScalar(classifier_formulas[c]);
+    if (scan.valid[c]){
+      valid_classifiers.push_back(c);
+      formulas.push_back(classifier_formulas[c]);
+    }
+  }
+
+  if (readable_tuple){
+    const bool is_mc = tuple->is_mc();
+    LoopFormulas(tree, formulas, [&](){
+      if (range_formula->EvalInstance() == 0) return;
+      ScanEvent event;
+      event.signal_weight = signal_formula->EvalInstance();
+      event.background_weight = background_formula->EvalInstance();
+      if (is_mc){
+        event.signal_weight = (event.signal_weight != 0) ? 1. : 0.;
+        event.background_weight = (event.background_weight != 0) ? 1. : 0.;
+        if (event.signal_weight == 0 && event.background_weight == 0) return;
+      }
+      scan.sum_of_sig_weights += event.signal_weight;
+      scan.sum_of_bkg_weights += event.background_weight;
+
+      for (std::vector<std::size_t>::const_iterator c = valid_classifiers.begin(); c != valid_classifiers.end(); ++c){
+        event.value = classifier_formulas[*c]->EvalInstance();
+        // NaN never passes a cut
+        if (std::isnan(event.value)) continue;
+        scan.events[*c].push_back(event);
+      }
+    });
+    for (std::vector<std::size_t>::const_iterator c = valid_classifiers.begin(); c != valid_classifiers.end(); ++c){
+      std::sort(scan.events[*c].begin(), scan.events[*c].end(), [](const ScanEvent& lhs, const ScanEvent& rhs){ return lhs.value < rhs.value; });
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.begin()+3; ++formula) delete *formula;
+    for (std::vector<TTreeFormula*>::const_iterator formula = classifier_formulas.begin(); formula != classifier_formulas.end(); ++formula) delete *formula;
+  }
+  return readable_tuple;
+}
+
+bool Triage::ReadTupleColumns(Tuple* tuple, const std::vector<Classifier*>& classifiers, std::vector< std::vector<double> >& columns, std::vector<double>& signal_weights, std::vector<double>& background_weights){
+  if (!tuple->is_mc() && !tuple->is_sw()) return false;
+  TTree& tree = tuple->tree();
+
+  std::string observable_range, signal_weight, background_weight;
+  ScanExpressions(tuple, observable_range, signal_weight, background_weight);
+
+  std::vector<TTreeFormula*> formulas;
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    formulas.push_back(new TTreeFormula("triage_range", TString(observable_range), &tree));
+    formulas.push_back(new TTreeFormula("triage_signal", TString(signal_weight), &tree));
+    formulas.push_back(new TTreeFormula("triage_background", TString(background_weight), &tree));
+    for (std::vector<Classifier*>::const_iterator classifier = classifiers.begin(); classifier != classifiers.end(); ++classifier){
+      formulas.push_back(new TTreeFormula("triage_classifier", TString((*classifier)->expression()), &tree));
+    }
+  }
+
+  bool readable = true;
+  for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula){
+    readable = readable && IsScalar(*formula);
+  }
+
+  columns.assign(classifiers.size(), std::vector<double>());
+  signal_weights.clear();
+  background_weights.clear();
+  if (readable){
+    const bool is_mc = tuple->is_mc();
+    TTreeFormula* range_formula = formulas[0];
+    TTreeFormula* signal_formula = formulas[1];
+    TTreeFormula* background_formula = formulas[2];
+    LoopFormulas(tree, formulas, [&](){
+      if (range_formula->EvalInstance() == 0) return;
+      double sig_weight = signal_formula->EvalInstance();
+      double bkg_weight = background_formula->EvalInstance();
+      if (is_mc){
+        sig_weight = (sig_weight != 0) ? 1. : 0.;
+        bkg_weight = (bkg_weight != 0) ? 1. : 0.;
+        if (sig_weight == 0 && bkg_weight == 0) return;
+      }
+      signal_weights.push_back(sig_weight);
+      background_weights.push_back(bkg_weight);
+      for (std::size_t c = 0; c < classifiers.size(); ++c){
+        columns[c].push_back(formulas[3+c]->EvalInstance());
+      }
+    });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula) delete *formula;
+  }
+  return readable;
+}
+
+std::vector< std::shared_ptr<TH1D> > Triage::ObservableHistograms(Tuple* tuple, const std::vector<std::string>& selections, int nbins){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::vector< std::shared_ptr<TH1D> > Triage::ObservableHistograms(Tuple* tuple, const std::vector<std::string>& selections, int nbins) \t" << doocore::io::endmsg;
+  TTree& tree = tuple->tree();
+  const double margin = (tuple->observable_range().second-tuple->observable_range().first)*0.1;
+
+  std::vector< std::shared_ptr<TH1D> > hists;
+  std::vector<TTreeFormula*> formulas;
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    formulas.push_back(new TTreeFormula("triage_observable", TString(tuple->observable_name()), &tree));
+    for (std::size_t i = 0; i < selections.size(); ++i){
+      std::string hist_name = "hist_observable_"+std::to_string(i);
+      hists.push_back(std::shared_ptr<TH1D>(new TH1D(hist_name.c_str(), hist_name.c_str(), nbins, tuple->observable_range().first-margin, tuple->observable_range().second+margin)));
+      formulas.push_back(selections[i] == "" ? NULL : new TTreeFormula("triage_selection", TString(selections[i]), &tree));
+    }
+  }
+  std::vector<TTreeFormula*> used_formulas;
+  bool scalar = true;
+  for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula){
+    if (*formula == NULL) continue;
+    used_formulas.push_back(*formula);
+    scalar = scalar && IsScalar(*formula);
+  }
+
+  if (scalar){
+    TTreeFormula* observable_formula = formulas[0];
+    LoopFormulas(tree, used_formulas, [&](){
+      const double observable = observable_formula->EvalInstance();
+      for (std::size_t i = 0; i < selections.size(); ++i){
+        if (formulas[i+1] == NULL || formulas[i+1]->EvalInstance() != 0) hists[i]->Fill(observable);
+      }
+    });
+  }
+  else{
+    // array-valued expressions, let TTree::Project handle the instances
+    for (std::size_t i = 0; i < selections.size(); ++i){
+      tree.Project(hists[i]->GetName(), tuple->observable_name().c_str(), selections[i].c_str());
+    }
+  }
+  for (std::vector< std::shared_ptr<TH1D> >::const_iterator hist = hists.begin(); hist != hists.end(); ++hist){
+    (*hist)->SetDirectory(NULL);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(formula_mutex);
+    for (std::vector<TTreeFormula*>::const_iterator formula = used_formulas.begin(); formula != used_formulas.end(); ++formula) delete *formula;
+  }
+  return hists;
+}
+
+std::vector<Triage::TupleScan> Triage::ReadTupleScans(std::vector<char>& scanned){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::vector<Triage::TupleScan> Triage::ReadTupleScans(std::vector<char>& scanned) \t" << doocore::io::endmsg;
+  std::vector<Tuple*> tuples(tuple_list_.begin(), tuple_list_.end());
+  std::vector<Classifier*> classifiers;
+  for(ClassifierList::iterator classifier = classifier_list_.begin(); classifier != classifier_list_.end(); classifier++){
+    classifiers.push_back(&(*classifier));
+  }
+
+  std::vector<TupleScan> scans(tuples.size());
+  scanned.assign(tuples.size(), 0);
+  const unsigned int num_threads = std::min<std::size_t>(num_threads_, tuples.size());
+  doocore::io::sinfo << "Triage::ReadTupleScans(): Reading " << classifiers.size() << " classifiers of " << tuples.size() << " tuples in " << num_threads << " threads" << doocore::io::endmsg;
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+  if (num_threads > 1){
+    ROOT::EnableThreadSafety();
+  }
+#endif
+
+  std::atomic<std::size_t> next_tuple(0);
+  auto read_tuples = [&](){
+    for (std::size_t t = next_tuple++; t < tuples.size(); t = next_tuple++){
+      scanned[t] = ReadTupleScan(tuples[t], classifiers, scans[t]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < num_threads; ++i){
+    threads.push_back(std::thread(read_tuples));
+  }
+  read_tuples();
+  for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread){
+    (*thread).join();
+  }
+  return scans;
+}
+
+bool Triage::CumulativeSums(const std::vector<ScanEvent>& events, const std::string& cut_operator, const std::vector<double>& cut_values, std::vector< std::pair<double, double> >& number_of_events, std::vector< std::pair<double, double> >& sum_of_squared_weights){
+  if (!IsCumulativeOperator(cut_operator)) return false;
+
+  // cumulative sums in the direction of the cut, so that every cut point is
+  // a plain sum over the events passing it: sums[k] holds the events
+  // [k, n) for '>' and '>=' and the events [0, k) for '<' and '<='
+  const bool upper = (cut_operator == ">" || cut_operator == ">=");
+  const std::size_t num_events = events.size();
+  std::vector<double> sig_sums(num_events+1, 0.), sig_sums_sq(num_events+1, 0.);
+  std::vector<double> bkg_sums(num_events+1, 0.), bkg_sums_sq(num_events+1, 0.);
+  for (std::size_t i = 0; i < num_events; ++i){
+    const std::size_t k = upper ? num_events-1-i : i;
+    const std::size_t from = upper ? k+1 : k;
+    const std::size_t to = upper ? k : k+1;
+    const ScanEvent& event = events[k];
+    sig_sums[to] = sig_sums[from] + event.signal_weight;
+    sig_sums_sq[to] = sig_sums_sq[from] + event.signal_weight*event.signal_weight;
+    bkg_sums[to] = bkg_sums[from] + event.background_weight;
+    bkg_sums_sq[to] = bkg_sums_sq[from] + event.background_weight*event.background_weight;
+  }
+
+  auto less = [](const ScanEvent& lhs, const ScanEvent& rhs){ return lhs.value < rhs.value; };
+  number_of_events.clear();
+  sum_of_squared_weights.clear();
+  for (std::vector<double>::const_iterator cut_value = cut_values.begin(); cut_value != cut_values.end(); ++cut_value){
+    // cut strings contain the cut value as formatted by std::to_string
+    ScanEvent cut_event;
+    cut_event.value = std::atof(std::to_string(*cut_value).c_str());
+    std::vector<ScanEvent>::const_iterator position;
+    if (cut_operator == ">" || cut_operator == "<="){
+      position = std::upper_bound(events.begin(), events.end(), cut_event, less);
+    }
+    else{
+      position = std::lower_bound(events.begin(), events.end(), cut_event, less);
+    }
+    const std::size_t k = position - events.begin();
+    number_of_events.push_back(std::make_pair(sig_sums[k], bkg_sums[k]));
+    sum_of_squared_weights.push_back(std::make_pair(sig_sums_sq[k], bkg_sums_sq[k]));
+  }
+  return true;
+}
+
 std::vector< std::pair<TH1D, TH1D> > Triage::yield_histograms(){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling std::pair< std::string, std::pair<TH1D, TH1D> > Triage::yield_histograms() \t" << doocore::io::endmsg;
   std::vector< std::pair<TH1D, TH1D> > yield_histograms;
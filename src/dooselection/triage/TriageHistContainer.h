@@ -2,6 +2,7 @@
 #define TRIAGE_TRIAGEHISTCONTAINER_H
 
 // from STL
+#include <memory>
 
 // from ROOT
 #include "TH1D.h"
@@ -16,6 +17,7 @@
 // from here
 #include "Tuple.h"
 #include "Classifier.h"
+#include "RocEngine.h"
 // forward declarations
 
 namespace dooselection{
@@ -32,6 +34,14 @@ class TriageHistContainer{
     cut_values_(cut_values),
     hist_number_sig_bkg_events_(hist_number_sig_bkg_events){}
 
+  /// Container for the observable histograms of a tuple and classifier only
+  TriageHistContainer(std::string name, const Tuple* tuple, const Classifier* classifier):
+    name_(name),
+    tuple_(tuple),
+    classifier_(classifier),
+    max_n_sig_events_(0.),
+    max_n_bkg_events_(0.){}
+
   // getter
   std::string name() const{return name_;}
   const Tuple* tuple() const{return tuple_;}
@@ -42,6 +52,21 @@ class TriageHistContainer{
   double max_n_bkg_events() const{return max_n_bkg_events_;}
   std::vector<double> cut_values() const{return cut_values_;}
   std::pair<TH1D, TH1D> hist_number_sig_bkg_events() {return hist_number_sig_bkg_events_;}
+  /// exact, unbinned ROC curve and figures of merit (NULL if only the binned cut scan is available)
+  const RocEngine* roc_engine() const{return roc_engine_.get();}
+  /// observable distribution without classifier cut (NULL if not filled)
+  std::shared_ptr<TH1D> hist_observable_without_cuts() const{return hist_observable_without_cuts_;}
+  /// observable distribution with the classifier cut observable_cut_string() (NULL if not filled)
+  std::shared_ptr<TH1D> hist_observable_with_cuts() const{return hist_observable_with_cuts_;}
+  const std::string& observable_cut_string() const{return observable_cut_string_;}
+
+  // setter
+  void set_roc_engine(std::shared_ptr<const RocEngine> roc_engine){roc_engine_ = roc_engine;}
+  void set_observable_hists(const std::string& cut_string, std::shared_ptr<TH1D> hist_without_cuts, std::shared_ptr<TH1D> hist_with_cuts){
+    observable_cut_string_ = cut_string;
+    hist_observable_without_cuts_ = hist_without_cuts;
+    hist_observable_with_cuts_ = hist_with_cuts;
+  }
 
  private:
   std::string name_;
@@ -51,6 +76,10 @@ class TriageHistContainer{
   double max_n_bkg_events_;
   std::vector<double> cut_values_;
   std::pair<TH1D, TH1D> hist_number_sig_bkg_events_;
+  std::shared_ptr<const RocEngine> roc_engine_;
+  std::string observable_cut_string_;
+  std::shared_ptr<TH1D> hist_observable_without_cuts_;
+  std::shared_ptr<TH1D> hist_observable_with_cuts_;
 };
 
 } // namespace triage
@@ -1,6 +1,8 @@
 #include "Triage.h"
 
 // from STL
+#include <cmath>
+#include <sstream>
 
 // from ROOT
 #include "TStyle.h"
@@ -31,6 +33,7 @@
 #include "SWTuple.h"
 #include "FTTuple.h"
 #include "FoM.h"
+#include "RocEngine.h"
 
 // forward declarations
 
@@ -38,6 +41,25 @@ namespace dooselection{
 namespace triage{
 
 namespace fs = boost::filesystem;
+
+namespace {
+/// Indices of at most max_points evenly spaced points (including the last one) to draw a curve with many points
+std::vector<std::size_t> PlotPoints(std::size_t num_points, std::size_t max_points=1000){
+  std::vector<std::size_t> points;
+  const std::size_t step = (num_points+max_points-1)/max_points;
+  for (std::size_t i = 0; i < num_points; i += (step > 0 ? step : 1)) points.push_back(i);
+  if (num_points > 0 && points.back() != num_points-1) points.push_back(num_points-1);
+  return points;
+}
+
+/// Value and, if bootstrapped, uncertainty as text
+std::string ValueWithError(double value, double error, unsigned int num_bootstrap_samples){
+  std::stringstream text;
+  text << value;
+  if (num_bootstrap_samples > 0) text << " #pm " << error;
+  return text.str();
+}
+} // namespace
   
 void Triage::InitializeScans(const int nbins){
   set_nbins(nbins);
@@ -47,10 +69,20 @@ void Triage::InitializeScans(const int nbins){
 void Triage::PerformanceScans(){
   if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::Performance() \t" << doocore::io::endmsg;
   for(std::vector<TriageHistContainer>::iterator hists_sig_bkg_event = hist_container_list_.begin(); hists_sig_bkg_event != hist_container_list_.end(); hists_sig_bkg_event++){
-    PlotROC((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).max_n_sig_events(), (*hists_sig_bkg_event).max_n_bkg_events());
+    if ((*hists_sig_bkg_event).roc_engine() != NULL){
+      PlotROC((*hists_sig_bkg_event).name(), *(*hists_sig_bkg_event).roc_engine());
+    }
+    else{
+      PlotROC((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).max_n_sig_events(), (*hists_sig_bkg_event).max_n_bkg_events());
+    }
     PlotSignalEfficiency((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).cut_values(), (*hists_sig_bkg_event).max_n_sig_events());
     PlotBackgroundRejection((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).cut_values(), (*hists_sig_bkg_event).max_n_bkg_events());
-    PlotEfficiencies((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).cut_values(), (*hists_sig_bkg_event).max_n_sig_events(), (*hists_sig_bkg_event).max_n_bkg_events());
+    if ((*hists_sig_bkg_event).roc_engine() != NULL){
+      PlotEfficiencies((*hists_sig_bkg_event).name(), *(*hists_sig_bkg_event).roc_engine());
+    }
+    else{
+      PlotEfficiencies((*hists_sig_bkg_event).name(), (*hists_sig_bkg_event).hist_number_sig_bkg_events(), (*hists_sig_bkg_event).cut_values(), (*hists_sig_bkg_event).max_n_sig_events(), (*hists_sig_bkg_event).max_n_bkg_events());
+    }
   }
 }
 
@@ -273,6 +305,161 @@ void Triage::PlotEfficiencies(std::string name, std::pair<TH1D, TH1D> hist_numbe
   doocore::lutils::printPlot(&canvas, "FoMs_"+name, "PerformanceScans/");
 }
 
+void Triage::PlotROC(std::string name, const RocEngine& roc_engine){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::PlotROC(std::string name, const RocEngine& roc_engine) \t" << doocore::io::endmsg;
+  std::vector<double> signal_efficiency = roc_engine.signal_efficiency();
+  std::vector<double> background_rejection = roc_engine.background_rejection();
+  if (signal_efficiency.empty()){
+    doocore::io::swarn << "-warning- \t" << "Triage::PlotROC(...): No candidates for " << name << ", no ROC curve plotted" << doocore::io::endmsg;
+    return;
+  }
+
+  // the exact curve is saved, a subset of its points is drawn
+  std::vector<std::size_t> points = PlotPoints(signal_efficiency.size());
+  std::vector<double> plot_signal_efficiency, plot_background_rejection;
+  for (std::vector<std::size_t>::const_iterator point = points.begin(); point != points.end(); ++point){
+    plot_signal_efficiency.push_back(signal_efficiency[*point]);
+    plot_background_rejection.push_back(background_rejection[*point]);
+  }
+
+  doocore::io::sinfo << "Triage::PlotROC(...): ROC area for " << name << ": " << roc_engine.auc();
+  if (roc_engine.num_bootstrap_samples() > 0) doocore::io::sinfo << " +/- " << roc_engine.auc_error();
+  doocore::io::sinfo << doocore::io::endmsg;
+
+  TFile roc_file("roc_curve.root", "recreate");
+
+  TCanvas canvas("canvas", "canvas", 800, 600);
+  TGraph roc_curve(signal_efficiency.size(), &signal_efficiency[0], &background_rejection[0]);
+  TGraph roc_graph(plot_signal_efficiency.size(), &plot_signal_efficiency[0], &plot_background_rejection[0]);
+
+  roc_graph.SetMarkerColor(kBlue+2);
+  roc_graph.SetMarkerStyle(kFullDotMedium);
+
+  roc_graph.SetTitle(TString("ROC Curve for ")+name+" (area "+ValueWithError(roc_engine.auc(), roc_engine.auc_error(), roc_engine.num_bootstrap_samples())+")");
+  roc_graph.GetXaxis()->SetTitle("Signal Efficiency");
+  roc_graph.GetXaxis()->SetLimits(0.,1.);
+  roc_graph.GetYaxis()->SetTitle("Background Rejection");
+  roc_graph.GetYaxis()->SetLimits(0.,1.);
+
+  roc_graph.Draw("ap");
+
+  fs::path filename = fs::path("PerformanceScans/pdf") / fs::path(std::string("ROC_")+name+".pdf");
+  doocore::config::Summary::GetInstance().AddFile(filename);
+  doocore::lutils::printPlot (&canvas, "ROC_"+name, "PerformanceScans/");
+
+  roc_curve.Write("roc_curve");
+  roc_file.Close();
+}
+
+void Triage::PlotEfficiencies(std::string name, const RocEngine& roc_engine){
+  if (debug_mode_) doocore::io::sdebug << "-debug- \t" << "calling void Triage::PlotEfficiencies(std::string name, const RocEngine& roc_engine) \t" << doocore::io::endmsg;
+  if (roc_engine.cut_values().empty()){
+    doocore::io::swarn << "-warning- \t" << "Triage::PlotEfficiencies(...): No candidates for " << name << ", no efficiencies plotted" << doocore::io::endmsg;
+    return;
+  }
+
+  // FoMs normalised to their maxima, drawn at a subset of all cut values
+  const FoMType figures_of_merit[] = {FoMType::Significance, FoMType::WeightedSignificance, FoMType::Purity, FoMType::Sin2Beta};
+  std::vector< std::vector<double> > fom_values;
+  for (const FoMType* figure_of_merit = figures_of_merit; figure_of_merit != figures_of_merit+4; ++figure_of_merit){
+    fom_values.push_back(roc_engine.fom_values(*figure_of_merit));
+  }
+  std::vector<double> signal_efficiency = roc_engine.signal_efficiency();
+  std::vector<double> background_efficiency = roc_engine.fom_values(FoMType::BackgroundEfficiency);
+
+  std::vector<std::size_t> points = PlotPoints(roc_engine.cut_values().size());
+  std::vector<double> cut_value, plot_signal_efficiency, plot_background_efficiency;
+  std::vector< std::vector<double> > plot_fom_values(fom_values.size());
+  for (std::vector<std::size_t>::const_iterator point = points.begin(); point != points.end(); ++point){
+    cut_value.push_back(roc_engine.cut_values()[*point]);
+    plot_signal_efficiency.push_back(signal_efficiency[*point]);
+    plot_background_efficiency.push_back(background_efficiency[*point]);
+    for (std::size_t f = 0; f < fom_values.size(); ++f){
+      plot_fom_values[f].push_back(fom_values[f][*point]/roc_engine.optimum(figures_of_merit[f]).fom_value);
+    }
+  }
+  RocEngine::Optimum significance_max = roc_engine.optimum(FoMType::Significance);
+  RocEngine::Optimum wsignificance_max = roc_engine.optimum(FoMType::WeightedSignificance);
+  RocEngine::Optimum purity_max = roc_engine.optimum(FoMType::Purity);
+  RocEngine::Optimum sin2beta_max = roc_engine.optimum(FoMType::Sin2Beta);
+
+  const unsigned int num_bootstrap_samples = roc_engine.num_bootstrap_samples();
+  auto legend_text = [num_bootstrap_samples](const std::string& fom_name, const RocEngine::Optimum& optimum){
+    return TString(fom_name)+" ("+ValueWithError(optimum.fom_value, optimum.fom_value_error, num_bootstrap_samples)+" @cut value: "+ValueWithError(optimum.cut_value, optimum.cut_value_error, num_bootstrap_samples)+")";
+  };
+
+  const int num_points = cut_value.size();
+  TCanvas canvas("canvas", "canvas", 800, 700);
+  canvas.Divide(1,3);
+  canvas.GetPad(1)->SetPad(0,0.9,1,1);
+  canvas.GetPad(2)->SetPad(0,0.8,1,0.9);
+  canvas.GetPad(3)->SetPad(0,0,1,0.8);
+  canvas.GetPad(3)->SetTopMargin(0.);
+  TGraph significance_graph(num_points, &cut_value[0], &plot_fom_values[0][0]);
+  TGraph purity_graph(num_points, &cut_value[0], &plot_fom_values[2][0]);
+  TGraph sin2beta_graph(num_points, &cut_value[0], &plot_fom_values[3][0]);
+  TGraph sigeff_graph(num_points, &cut_value[0], &plot_signal_efficiency[0]);
+  TGraph bkgeff_graph(num_points, &cut_value[0], &plot_background_efficiency[0]);
+
+  canvas.cd(3);
+  significance_graph.Draw("a*");
+  purity_graph.Draw("same *");
+  sin2beta_graph.Draw("same *");
+  sigeff_graph.Draw("same *");
+  bkgeff_graph.Draw("same *");
+
+  significance_graph.SetName("significance");
+  significance_graph.SetTitle("");
+  significance_graph.GetXaxis()->SetTitle("Classifier");
+  significance_graph.GetYaxis()->SetTitle("Efficiency");
+  significance_graph.SetMarkerColor(kGreen+2);
+  significance_graph.SetMarkerStyle(kFullDotMedium);
+
+  purity_graph.SetMarkerColor(kYellow+2);
+  purity_graph.SetMarkerStyle(kFullDotMedium);
+
+  sin2beta_graph.SetMarkerColor(kMagenta+2);
+  sin2beta_graph.SetMarkerStyle(kFullDotMedium);
+
+  sigeff_graph.SetMarkerColor(kBlue+2);
+  sigeff_graph.SetMarkerStyle(kFullDotMedium);
+
+  bkgeff_graph.SetMarkerColor(kRed+2);
+  bkgeff_graph.SetMarkerStyle(kFullDotMedium);
+
+  double rightx = significance_graph.GetHistogram()->GetXaxis()->GetXmax();
+
+  TGaxis *unit_axis = new TGaxis(rightx,0,rightx,1.1,0,significance_max.fom_value,40408,"+");
+  unit_axis->SetTitle("Significance");
+  unit_axis->SetLineColor(kGreen+2);
+  unit_axis->SetLabelColor(kGreen+2);
+  unit_axis->SetLabelOffset(0.04);
+  unit_axis->SetTextColor(kGreen+2);
+  unit_axis->Draw();
+
+  canvas.cd(2);
+  TLegend* legend = new TLegend(0.1,0.1,0.9,0.9);
+     legend->SetBorderSize(0);
+     legend->SetFillColor(kWhite);
+     legend->SetNColumns(2);
+     legend->AddEntry(&sigeff_graph, "Signal Efficiency","p");
+     legend->AddEntry(&bkgeff_graph, "Background Efficiency","p");
+     legend->AddEntry(&significance_graph, legend_text("Significance", significance_max),"p");
+     legend->AddEntry(&significance_graph, legend_text("Weighted Significance", wsignificance_max),"p");
+     legend->AddEntry(&purity_graph, legend_text("Purity", purity_max),"p");
+     legend->AddEntry(&sin2beta_graph, legend_text("sin2#beta FoM", sin2beta_max),"p");
+     legend->Draw();
+
+  canvas.cd(1);
+  TText* title = new TText(0.1,0.1, TString("Cut efficiencies for ")+name);
+  title->SetTextSize(0.3);
+  title->Draw();
+
+  fs::path filename = fs::path("PerformanceScans/pdf") / fs::path(std::string("FoMs_")+name+".pdf");
+  doocore::config::Summary::GetInstance().AddFile(filename);
+  doocore::lutils::printPlot(&canvas, "FoMs_"+name, "PerformanceScans/");
+}
+
 
 } // namespace triage
 } // namespace dooselection
@@ -2,6 +2,7 @@
 #define TRIAGE_TUPLE_H
 
 // from STL
+#include <memory>
 
 // from ROOT
 
@@ -21,6 +22,7 @@
 #include "doocore/io/EasyTuple.h"
 
 // from here
+#include "TupleColumns.h"
 
 // forward declarations
 
@@ -44,7 +46,7 @@ class Tuple{
     observable_range_(std::make_pair(observable_range_min,observable_range_max)),
     max_n_sig_events_(0.),
     max_n_bkg_events_(0.),
-    dataset_exists_(false)
+    argset_(argset)
   {
     boost::filesystem::path filename_full(boost::filesystem::path(path) / boost::filesystem::path(filename));
     etuple_ = new doocore::io::EasyTuple(filename_full.string(), treename, argset);
@@ -73,19 +75,24 @@ class Tuple{
   doocore::io::EasyTuple& etuple(){return *etuple_;}
   TTree& tree() {return etuple_->tree();}
   const TTree& tree() const{return etuple_->tree();}
+  /// Full dataset, materialized from the columns on first use
   RooDataSet& dataset(){
-    if (dataset_exists_){
-      return (etuple_->dataset());
+    if (!dataset_){
+      dataset_.reset(columns().DataSet(columns().Select(""), name_));
     }
-    else{
-      if (global_cut_.size() > 0) {
-        dataset_ = &(etuple_->ConvertToDataSet(RooFit::Cut(global_cut_.c_str())));
-      } else {
-        dataset_ = &(etuple_->ConvertToDataSet());
-      }
-      dataset_exists_=true;
-      return (etuple_->dataset());
+    return *dataset_;
+  }
+  /// Columnar in-memory store of the argset variables, read on first use
+  TupleColumns& columns(){
+    if (!columns_){
+      columns_.reset(new TupleColumns(tree(), argset_, global_cut_));
     }
+    return *columns_;
+  }
+  /// New dataset with the entries passing a cut on the argset variables ("" for all), owned by the caller.
+  /// Only the selected entries are copied, the full dataset is not needed.
+  RooDataSet* ReducedDataSet(const std::string& cut){
+    return columns().DataSet(columns().Select(cut), name_);
   }
 
   bool is_mc() const{return is_mc_;};
@@ -94,6 +101,7 @@ class Tuple{
   bool is_absfitter() const{return is_absfitter_;};
   
   void set_global_cut(std::string global_cut) { global_cut_ = global_cut; }
+  const std::string& global_cut() const{return global_cut_;}
   
  protected:
   bool is_mc_;
@@ -118,8 +126,9 @@ class Tuple{
   double max_n_bkg_events_;
 
   doocore::io::EasyTuple* etuple_;
-  RooDataSet* dataset_;
-  bool dataset_exists_;
+  RooArgSet argset_;
+  std::shared_ptr<TupleColumns> columns_;
+  std::shared_ptr<RooDataSet> dataset_;
 };
 
 } // namespace triage
@@ -0,0 +1,139 @@
+#include "TupleColumns.h"
+
+// from STL
+#include <algorithm>
+
+// from ROOT
+#include "TIterator.h"
+#include "TString.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+// from RooFit
+#include "RooArgList.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooDataSet.h"
+#include "RooFormulaVar.h"
+#include "RooRealVar.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+namespace dooselection{
+namespace triage{
+
+TupleColumns::TupleColumns(TTree& tree, const RooArgSet& argset, const std::string& cut):
+  snapshot_(dynamic_cast<RooArgSet*>(argset.snapshot())),
+  variables_(new RooArgSet()),
+  num_entries_(0)
+{
+  // own copies of the variables, so that evaluating cuts and filling
+  // datasets does not change the values of the given variables
+  std::vector<TTreeFormula*> formulas;
+  TIterator* args_it = snapshot_->createIterator();
+  RooAbsArg* arg = NULL;
+  while ((arg = dynamic_cast<RooAbsArg*>(args_it->Next()))){
+    if (dynamic_cast<RooRealVar*>(arg) == NULL && dynamic_cast<RooCategory*>(arg) == NULL){
+      doocore::io::swarn << "-warning- \t" << "TupleColumns::TupleColumns(...): Skipping " << arg->GetName() << ", only RooRealVar and RooCategory variables are supported" << doocore::io::endmsg;
+      continue;
+    }
+    variables_->add(*arg);
+    names_.push_back(arg->GetName());
+    real_vars_.push_back(dynamic_cast<RooRealVar*>(arg));
+    categories_.push_back(dynamic_cast<RooCategory*>(arg));
+    formulas.push_back(new TTreeFormula((std::string("columns_")+arg->GetName()).c_str(), arg->GetName(), &tree));
+  }
+  delete args_it;
+
+  TTreeFormula* cut_formula = NULL;
+  if (cut != "") cut_formula = new TTreeFormula("columns_cut", cut.c_str(), &tree);
+
+  // same entries as in a RooDataSet: values in the variable ranges and
+  // valid category indices only
+  columns_.assign(names_.size(), std::vector<double>());
+  std::vector<double> values(names_.size());
+  int tree_number = -1;
+  const Long64_t num_tree_entries = tree.GetEntries();
+  for (Long64_t entry = 0; entry < num_tree_entries; ++entry){
+    if (tree.LoadTree(entry) < 0) break;
+    if (tree.GetTreeNumber() != tree_number){
+      tree_number = tree.GetTreeNumber();
+      for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula) (*formula)->UpdateFormulaLeaves();
+      if (cut_formula != NULL) cut_formula->UpdateFormulaLeaves();
+    }
+    if (cut_formula != NULL){
+      cut_formula->GetNdata();
+      if (cut_formula->EvalInstance() == 0) continue;
+    }
+    bool valid = true;
+    for (std::size_t c = 0; c < formulas.size() && valid; ++c){
+      formulas[c]->GetNdata();
+      values[c] = formulas[c]->EvalInstance();
+      if (categories_[c] != NULL){
+        valid = categories_[c]->isValidIndex(static_cast<int>(values[c]));
+      }
+      else{
+        valid = (values[c] >= real_vars_[c]->getMin() && values[c] <= real_vars_[c]->getMax());
+      }
+    }
+    if (!valid) continue;
+    for (std::size_t c = 0; c < values.size(); ++c) columns_[c].push_back(values[c]);
+    ++num_entries_;
+  }
+
+  for (std::vector<TTreeFormula*>::const_iterator formula = formulas.begin(); formula != formulas.end(); ++formula) delete *formula;
+  delete cut_formula;
+  doocore::io::sinfo << "TupleColumns::TupleColumns(...): Read " << names_.size() << " variables of " << num_entries_ << " entries" << doocore::io::endmsg;
+}
+
+TupleColumns::~TupleColumns(){}
+
+TupleColumns::Mask TupleColumns::Select(const std::string& cut) const{
+  Mask mask(num_entries_, 1);
+  if (cut == "") return mask;
+
+  RooFormulaVar formula("columns_selection", cut.c_str(), cut.c_str(), RooArgList(*variables_));
+  for (std::size_t entry = 0; entry < num_entries_; ++entry){
+    LoadEntry(entry);
+    mask[entry] = (formula.getVal() != 0);
+  }
+  return mask;
+}
+
+RooDataSet* TupleColumns::DataSet(const Mask& mask, const std::string& name) const{
+  RooDataSet* dataset = new RooDataSet(name.c_str(), name.c_str(), *variables_);
+  for (std::size_t entry = 0; entry < num_entries_; ++entry){
+    if (!mask[entry]) continue;
+    LoadEntry(entry);
+    dataset->add(*variables_);
+  }
+  return dataset;
+}
+
+std::size_t TupleColumns::NumSelected(const Mask& mask){
+  return std::count(mask.begin(), mask.end(), 1);
+}
+
+const std::vector<double>& TupleColumns::column(const std::string& name) const{
+  std::vector<std::string>::const_iterator position = std::find(names_.begin(), names_.end(), name);
+  if (position == names_.end()){
+    doocore::io::serr << "-ERROR- \t" << "TupleColumns::column(...): No column " << name << doocore::io::endmsg;
+    throw 1;
+  }
+  return columns_[position-names_.begin()];
+}
+
+void TupleColumns::LoadEntry(std::size_t entry) const{
+  for (std::size_t c = 0; c < names_.size(); ++c){
+    if (categories_[c] != NULL){
+      categories_[c]->setIndex(static_cast<int>(columns_[c][entry]));
+    }
+    else{
+      real_vars_[c]->setVal(columns_[c][entry]);
+    }
+  }
+}
+
+} // namespace triage
+} // namespace dooselection
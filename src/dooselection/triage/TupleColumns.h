@@ -0,0 +1,80 @@
+#ifndef TRIAGE_TUPLECOLUMNS_H
+#define TRIAGE_TUPLECOLUMNS_H
+
+// from STL
+#include <memory>
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from DooCore
+
+// from here
+
+// forward declarations
+class TTree;
+class RooArgSet;
+class RooDataSet;
+class RooRealVar;
+class RooCategory;
+
+namespace dooselection{
+namespace triage{
+
+/// Columnar in-memory store of the variables of a tuple.
+/// All RooRealVar and RooCategory variables of an argset are read once from the tree into one column per variable,
+/// keeping the entries a RooDataSet of the tree would contain (variables in range, valid category indices, passing
+/// the global cut). Cuts are applied as selection masks without copying the columns; RooDataSets are only
+/// materialized for the selected entries when needed (e.g. for a fit).
+class TupleColumns{
+ public:
+  /// Selection of entries, one flag per entry
+  typedef std::vector<unsigned char> Mask;
+
+  /// Reads the variables of argset from tree, skipping entries not passing cut (TTree selection, "" for none)
+  TupleColumns(TTree& tree, const RooArgSet& argset, const std::string& cut="");
+  ~TupleColumns();
+
+  /// Selects the entries passing a cut on the variables (RooFormulaVar expression as for RooAbsData::reduce, "" for all)
+  Mask Select(const std::string& cut) const;
+
+  /// Creates a new RooDataSet with the selected entries (owned by the caller)
+  RooDataSet* DataSet(const Mask& mask, const std::string& name) const;
+
+  /// Number of selected entries
+  static std::size_t NumSelected(const Mask& mask);
+
+  // getter
+  std::size_t num_entries() const{return num_entries_;}
+  /// Variables of the columns (RooRealVar and RooCategory only)
+  const RooArgSet& variables() const{return *variables_;}
+  /// Column of a variable (category indices for RooCategory), throws if there is none
+  const std::vector<double>& column(const std::string& name) const;
+
+ private:
+  TupleColumns(const TupleColumns&);
+  TupleColumns& operator=(const TupleColumns&);
+
+  /// Sets the variables to the values of an entry
+  void LoadEntry(std::size_t entry) const;
+
+  std::unique_ptr<RooArgSet> snapshot_;                 ///< own copies of all variables, used to evaluate cuts and fill RooDataSets
+  std::unique_ptr<RooArgSet> variables_;                ///< variables of the columns (not owning)
+  std::vector<std::string> names_;                      ///< per column
+  std::vector<RooRealVar*> real_vars_;                  ///< per column, NULL for categories
+  std::vector<RooCategory*> categories_;                ///< per column, NULL for real variables
+  std::vector< std::vector<double> > columns_;
+  std::size_t num_entries_;
+};
+
+} // namespace triage
+} // namespace dooselection
+
+#endif // TRIAGE_TUPLECOLUMNS_H